@@ -0,0 +1,160 @@
+#include "utils/road_tile_decoder.h"
+#include "utils/sql_util.h"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+using namespace std;
+using hdmap::data::proto::RoadTile;
+
+// RoadTile解码对比: 完整ParseFromArray + 提取 vs 只扫描渲染字段的wire解码.
+// 不带参数时生成一块车道数据很多的合成瓦片; 也可指定数据库分区.
+
+namespace {
+    void setPoint(hdmap::data::proto::Point *p, double lon, double lat, double alt) {
+        p->set_longitude(lon);
+        p->set_latitude(lat);
+        p->set_altitude(alt);
+    }
+
+    // 每条road带ab/ba两个车道组, 每组lanes条车道, 车道中心线/边界各points个点, 另加ADAS和经验轨迹
+    RoadTile makeLaneRichTile(int roads, int lanes, int points) {
+        RoadTile tile;
+        tile.mutable_id()->set_id(1);
+        double lon0 = 121.0, lat0 = 31.0;
+        for (int r = 0; r < roads; ++r) {
+            auto road = tile.add_road();
+            road->mutable_id()->set_count(r + 1);
+            road->set_length(50.0f);
+            for (int j = 0; j < points; ++j) {
+                setPoint(road->mutable_road_center()->add_points(), lon0 + r * 1e-4 + j * 1e-6, lat0, -5.0);
+            }
+            for (auto group : {road->add_lane_group_ab(), road->add_lane_group_ba()}) {
+                group->set_num_lanes(lanes);
+                for (int l = 0; l < lanes; ++l) {
+                    auto lane = group->add_lanes();
+                    lane->mutable_id()->set_index(l);
+                    lane->add_direction(hdmap::data::proto::Lane::GO_STRAIGHT);
+                    for (int j = 0; j < points; ++j) {
+                        setPoint(lane->mutable_center_line()->add_points(), lon0 + j * 1e-6, lat0 + l * 1e-5, -5.0);
+                    }
+                    auto boundary = group->add_lane_boundary_groups()->add_parallel_lane_boundaries()
+                            ->add_sequential_lane_boundaries();
+                    for (int j = 0; j < points; ++j) {
+                        setPoint(boundary->mutable_geometry()->add_points(), lon0 + j * 1e-6, lat0 + l * 1e-5, -5.0);
+                    }
+                }
+            }
+            for (int l = 0; l < lanes * 2; ++l) {
+                auto width = tile.add_width_for_lane();
+                auto curvature = tile.add_curvature_for_lane();
+                auto yaw = tile.add_yaw_for_lane();
+                auto slope = tile.add_slope_for_lane();
+                auto trajectory = tile.add_experience_trajectory_for_lane()->add_experience_trajectory_list();
+                for (int j = 0; j < points; ++j) {
+                    width->add_width_list(2.5);
+                    curvature->add_curvature_list(0.01);
+                    yaw->add_yaw_list(0.1);
+                    slope->add_vertical_slope_list(0.0);
+                    setPoint(trajectory->mutable_geometry()->add_points(), lon0 + j * 1e-6, lat0, -5.0);
+                    trajectory->add_instance_speed_list(3.0);
+                }
+            }
+        }
+        for (int i = 0; i < roads * 4; ++i) {
+            auto pks = tile.add_parking_space();
+            pks->mutable_id()->set_count(i + 1);
+            for (int k = 0; k < 4; ++k) {
+                setPoint(pks->add_shape(), lon0 + i * 3e-5 + (k == 1 || k == 2) * 2e-5, lat0 + (k >= 2) * 5e-5, -5.0);
+            }
+        }
+        for (int i = 0; i < roads; ++i) {
+            auto obstacle = tile.add_road_obstacle();
+            obstacle->mutable_id()->set_count(i + 1);
+            obstacle->set_type(hdmap::data::proto::RoadObstacle::PILLAR);
+            for (int k = 0; k < 4; ++k) {
+                setPoint(obstacle->add_shape(), lon0 + i * 1e-4 + k * 1e-6, lat0, -5.0);
+            }
+            auto mark = tile.add_road_mark();
+            mark->mutable_id()->set_count(i + 1);
+            mark->set_type(hdmap::data::proto::RoadMark::SPEED_BUMP);
+            setPoint(mark->add_shape(), lon0 + i * 1e-4, lat0, -5.0);
+            setPoint(mark->add_shape(), lon0 + i * 1e-4, lat0 + 1e-5, -5.0);
+            auto poi = tile.add_poi();
+            poi->mutable_id()->set_count(i + 1);
+            poi->set_poi_type(hdmap::data::proto::POI::PARK_INTERSECTION);
+            setPoint(poi->add_shape(), lon0 + i * 1e-4, lat0, -5.0);
+        }
+        return tile;
+    }
+
+    bool sameLayer(const TileLayer &a, const TileLayer &b) {
+        return a.ids == b.ids && a.types == b.types && a.offsets == b.offsets && a.points == b.points;
+    }
+
+    bool sameTile(const DecodedRoadTile &a, const DecodedRoadTile &b) {
+        return sameLayer(a.roads, b.roads) && a.road_lengths == b.road_lengths && a.road_heads == b.road_heads &&
+               a.road_tails == b.road_tails && a.road_directions == b.road_directions && sameLayer(a.pois, b.pois) &&
+               sameLayer(a.road_marks, b.road_marks) && sameLayer(a.road_obstacles, b.road_obstacles) &&
+               sameLayer(a.parking_spaces, b.parking_spaces);
+    }
+
+    template<typename Fn>
+    double timeIt(int iterations, Fn &&fn) {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            fn();
+        }
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count() / iterations;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 1 && argc != 3 && argc != 4) {
+        cout << "Usage: \n./decode_benchmark [iterations=20]\n./decode_benchmark <db_file> <partition_id> [iterations]"
+             << endl;
+        return 1;
+    }
+    string blob;
+    int iterations = 20;
+    if (argc >= 3) {
+        blob = query_for_blob(argv[1], atoi(argv[2]));
+        if (argc == 4) {
+            iterations = atoi(argv[3]);
+        }
+    } else {
+        blob = makeLaneRichTile(200, 4, 100).SerializeAsString();
+    }
+
+    DecodedRoadTile full, fast;
+    double full_seconds = timeIt(iterations, [&]() {
+        RoadTile tile;
+        if (!tile.ParseFromArray(blob.data(), static_cast<int>(blob.size()))) {
+            cerr << "ParseFromArray failed" << endl;
+            exit(1);
+        }
+        decode_road_tile(tile, full);
+    });
+    double fast_seconds = timeIt(iterations, [&]() {
+        if (!decode_road_tile(blob.data(), blob.size(), fast)) {
+            cerr << "decode_road_tile failed" << endl;
+            exit(1);
+        }
+    });
+
+    double mb = static_cast<double>(blob.size()) / (1 << 20);
+    cout << "blob " << fixed << setprecision(2) << mb << " MiB, " << fast.roads.size() << " roads, "
+         << fast.parking_spaces.size() << " parking spaces" << endl;
+    cout << "  ParseFromArray : " << setprecision(3) << full_seconds * 1000.0 << " ms ("
+         << setprecision(1) << mb / full_seconds << " MiB/s)" << endl;
+    cout << "  wire decoder   : " << setprecision(3) << fast_seconds * 1000.0 << " ms ("
+         << setprecision(1) << mb / fast_seconds << " MiB/s), x" << setprecision(1)
+         << full_seconds / fast_seconds << endl;
+    if (!sameTile(full, fast)) {
+        cerr << "MISMATCH between decoders" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include "navi_map/navi_map.h"
+#include "navi_map/road_graph.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 批量路线规划: 在道路附近随机取起点, 依次以各车位为终点调用findRouteToParkingSpace,
+// 统计耗时并校验每条路线: 沿道路部分的折线长度与Route::length一致.
+// 之后在合成的网格路网上对比A*与Dijkstra, 两者的路线长度必须相同.
+
+namespace {
+    float distance3(const float *a, const float *b) {
+        float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    // 返回空串表示通过
+    string check(const navi_map::Route &route) {
+        const auto &p = route.points;
+        if (p.size() < 12) {
+            return "too few points";
+        }
+        // 首尾两点是起终点到道路的连接段
+        float along = 0.0f;
+        for (size_t i = 3; i + 6 < p.size(); i += 3) {
+            along += distance3(p.data() + i, p.data() + i + 3);
+        }
+        if (fabs(along - route.length) > 0.01f * max(1.0f, route.length)) {
+            return "polyline length " + to_string(along) + " != " + to_string(route.length);
+        }
+        return "";
+    }
+
+    // side x side个路口的网格, 相邻路口间一条带偏移中点的road, 每7条中有一条单行
+    RoadGraph makeGrid(uint32_t side, float spacing) {
+        vector<uint32_t> heads, tails, offsets{0};
+        vector<uint8_t> directions;
+        vector<float> points;
+        auto port = [&](uint32_t x, uint32_t y) { return y * side + x + 1; };
+        auto add = [&](uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+            heads.push_back(port(x0, y0));
+            tails.push_back(port(x1, y1));
+            directions.push_back(heads.size() % 7 == 0 ? RoadGraph::A_B : RoadGraph::BOTH);
+            float ax = static_cast<float>(x0) * spacing, ay = static_cast<float>(y0) * spacing;
+            float bx = static_cast<float>(x1) * spacing, by = static_cast<float>(y1) * spacing;
+            points.insert(points.end(), {ax, ay, 0.0f, (ax + bx) / 2 + 0.5f, (ay + by) / 2 + 0.5f, 0.0f, bx, by, 0.0f});
+            offsets.push_back(static_cast<uint32_t>(points.size() / 3));
+        };
+        for (uint32_t y = 0; y < side; ++y) {
+            for (uint32_t x = 0; x < side; ++x) {
+                if (x + 1 < side) {
+                    add(x, y, x + 1, y);
+                }
+                if (y + 1 < side) {
+                    add(x, y, x, y + 1);
+                }
+            }
+        }
+        return RoadGraph::build(heads, tails, directions, offsets, points);
+    }
+
+    bool compareSearch(uint32_t side, int queries) {
+        const float spacing = 20.0f;
+        auto graph = makeGrid(side, spacing);
+        mt19937 rng(3);
+        uniform_real_distribution<float> coord(0.0f, static_cast<float>(side - 1) * spacing);
+        vector<array<float, 3>> from(queries), to(queries);
+        for (int i = 0; i < queries; ++i) {
+            from[i] = {coord(rng), coord(rng), 0.0f};
+            to[i] = {coord(rng), coord(rng), 0.0f};
+        }
+        bool ok = true;
+        double seconds[2] = {};
+        vector<float> lengths(queries);
+        for (int pass = 0; pass < 2; ++pass) {
+            bool astar = pass == 0;
+            auto begin = chrono::steady_clock::now();
+            for (int i = 0; i < queries; ++i) {
+                auto path = graph.route(from[i].data(), to[i].data(), astar);
+                if (astar) {
+                    lengths[i] = path.length;
+                } else {
+                    ok &= path.found && fabs(path.length - lengths[i]) < 1e-3f * max(1.0f, path.length);
+                }
+            }
+            seconds[pass] = chrono::duration<double>(chrono::steady_clock::now() - begin).count() / queries;
+        }
+        // 起终点投影是线性扫描, 单独计时以便从上面的耗时中扣除
+        auto begin = chrono::steady_clock::now();
+        for (int i = 0; i < queries; ++i) {
+            ok &= graph.snap(from[i].data()).road >= 0 && graph.snap(to[i].data()).road >= 0;
+        }
+        double snap = chrono::duration<double>(chrono::steady_clock::now() - begin).count() / queries;
+        cout << "grid " << side << "x" << side << ": " << graph.nodeCount() << " nodes, " << graph.edgeCount()
+             << " edges, " << graph.byteSize() / 1024 << " KiB" << endl;
+        cout << "  A* " << seconds[0] * 1e6 << " us, Dijkstra " << seconds[1] * 1e6 << " us per route (snap "
+             << snap * 1e6 << " us)" << endl;
+        return ok;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3 && argc != 4) {
+        cout << "Usage: ./route_benchmark <db_file> <partition_id> [pairs=2000]" << endl;
+        return 1;
+    }
+    int pairs = argc == 4 ? atoi(argv[3]) : 2000;
+    auto map = navi_map::NaviMap::createNaviMap(argv[1], atoi(argv[2]), navi_map::BlobType::LOC);
+    auto roads = map->getRoads();
+    // 起点取自road中心线上的点, 没有点的road不参与
+    roads.erase(remove_if(roads.begin(), roads.end(), [](const auto &road) { return road.road_center.size() < 3; }),
+                roads.end());
+    auto psds = map->getParkingSpaces();
+    if (roads.empty() || psds.empty()) {
+        cerr << "no roads or parking spaces in partition" << endl;
+        return 1;
+    }
+
+    // 第一次调用包含路网构建
+    auto begin = chrono::steady_clock::now();
+    map->findRoute({0, 0, 0}, {0, 0, 0});
+    double build_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    mt19937 rng(1);
+    uniform_real_distribution<float> jitter(-3.0f, 3.0f);
+    vector<double> micros;
+    micros.reserve(pairs);
+    int found = 0, failed = 0;
+    double total_length = 0.0;
+    for (int i = 0; i < pairs; ++i) {
+        const auto &road = roads[rng() % roads.size()];
+        size_t vertex = rng() % (road.road_center.size() / 3);
+        array<float, 3> start = {road.road_center[vertex * 3] + jitter(rng),
+                                 road.road_center[vertex * 3 + 1] + jitter(rng), road.road_center[vertex * 3 + 2]};
+        uint32_t target = psds[i % psds.size()].id;
+
+        auto t0 = chrono::steady_clock::now();
+        auto route = map->findRouteToParkingSpace(start, target);
+        micros.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+        if (!route.found) {
+            continue;
+        }
+        ++found;
+        total_length += route.length;
+        auto error = check(route);
+        if (!error.empty() && ++failed <= 10) {
+            cerr << "route " << i << " to " << target << ": " << error << endl;
+        }
+    }
+
+    sort(micros.begin(), micros.end());
+    double mean = 0.0;
+    for (double m : micros) {
+        mean += m;
+    }
+    mean /= static_cast<double>(micros.size());
+    cout << roads.size() << " roads, " << psds.size() << " parking spaces, graph built in " << fixed
+         << setprecision(2) << build_ms << " ms" << endl;
+    cout << "  " << pairs << " routes: " << found << " found, mean " << mean << " us, p50 "
+         << micros[micros.size() / 2] << " us, p99 " << micros[micros.size() * 99 / 100] << " us, avg length "
+         << (found ? total_length / found : 0.0) << " m" << endl;
+    if (failed > 0) {
+        cerr << failed << " routes failed validation" << endl;
+        return 1;
+    }
+    if (!compareSearch(100, 500)) {
+        cerr << "MISMATCH between A* and Dijkstra route lengths" << endl;
+        return 1;
+    }
+    return 0;
+}
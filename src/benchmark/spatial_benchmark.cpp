@@ -0,0 +1,232 @@
+#include "utils/spatial_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// SpatialIndex(STR批量构建的R树)与线性扫描的查询耗时对比.
+// 合成数据全部与坐标轴对齐(车位矩形, 拉伸的柱子, 沿x的道路, 点), 此时要素几何距离等于包围盒距离,
+// 线性扫描可以直接用包围盒作为参考结果.
+
+namespace {
+    enum Layer : uint32_t { PSDS, PILLARS, ROADS, POIS };
+
+    struct Feature {
+        uint32_t layer;
+        uint32_t id;
+        array<float, 3> min;
+        array<float, 3> max;
+    };
+
+    float boxDistance(const Feature &f, const array<float, 3> &p) {
+        float d2 = 0.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            float d = max({f.min[axis] - p[axis], p[axis] - f.max[axis], 0.0f});
+            d2 += d * d;
+        }
+        return sqrt(d2);
+    }
+
+    // 100x100m一个分区, 每个分区内车位/柱子/道路/POI数量按count / 分区数均分
+    void makeFeatures(size_t count, SpatialIndex &index, vector<Feature> &features) {
+        mt19937 rng(7);
+        uniform_real_distribution<float> jitter(0.0f, 1.0f);
+        size_t side = static_cast<size_t>(ceil(sqrt(static_cast<double>(count) / 100.0)));
+        for (uint32_t id = 0; id < count; ++id) {
+            size_t cell = id / 100;
+            float ox = static_cast<float>(cell % side) * 100.0f, oy = static_cast<float>(cell / side) * 100.0f;
+            float z = -5.0f * static_cast<float>(cell % 3);
+            uint32_t k = id % 100;
+            Feature f{};
+            f.id = id;
+            vector<float> points;
+            if (k < 40) {
+                // 车位 2.5 x 5m, 8列5行
+                float x = ox + static_cast<float>(k % 8) * 12.0f, y = oy + static_cast<float>(k / 8) * 18.0f;
+                points = {x, y, z, x + 2.5f, y, z, x + 2.5f, y + 5.0f, z, x, y + 5.0f, z};
+                f.layer = PSDS;
+                index.add(PSDS, 0, id, SpatialIndex::POLYGON, points.data(), 4);
+                f.min = {x, y, z};
+                f.max = {x + 2.5f, y + 5.0f, z};
+            } else if (k < 60) {
+                float x = ox + static_cast<float>(k - 40) * 5.0f + 1.0f, y = oy + 95.0f;
+                points = {x, y, z, x + 0.6f, y, z, x + 0.6f, y + 0.6f, z, x, y + 0.6f, z};
+                f.layer = PILLARS;
+                index.add(PILLARS, 0, id, SpatialIndex::POLYGON, points.data(), 4, 3.0f);
+                f.min = {x, y, z};
+                f.max = {x + 0.6f, y + 0.6f, z + 3.0f};
+            } else if (k < 80) {
+                // 沿x的道路中心线, 10个点
+                float y = oy + 7.0f + static_cast<float>(k - 60) * 4.4f, x = ox + jitter(rng) * 10.0f;
+                for (int j = 0; j < 10; ++j) {
+                    points.insert(points.end(), {x + static_cast<float>(j) * 8.0f, y, z});
+                }
+                f.layer = ROADS;
+                index.add(ROADS, 0, id, SpatialIndex::POLYLINE, points.data(), 10);
+                f.min = {x, y, z};
+                f.max = {x + 72.0f, y, z};
+            } else {
+                float x = ox + jitter(rng) * 100.0f, y = oy + jitter(rng) * 100.0f;
+                points = {x, y, z};
+                f.layer = POIS;
+                index.add(POIS, 0, id, SpatialIndex::POINTS, points.data(), 1);
+                f.min = f.max = {x, y, z};
+            }
+            features.push_back(f);
+        }
+    }
+
+    template<typename Fn>
+    double timeIt(int iterations, Fn &&fn) {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            fn(i);
+        }
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count() / iterations;
+    }
+
+    vector<uint32_t> ids(const vector<SpatialHit> &hits) {
+        vector<uint32_t> result;
+        for (const auto &hit : hits) {
+            result.push_back(hit.id);
+        }
+        sort(result.begin(), result.end());
+        return result;
+    }
+
+    void report(const string &name, double indexed, double linear) {
+        cout << "  " << left << setw(12) << name << right << fixed << setprecision(2) << setw(9)
+             << indexed * 1e6 << " us  linear " << setw(9) << linear * 1e6 << " us  x" << setprecision(0)
+             << linear / indexed << endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 3) {
+        cout << "Usage: ./spatial_benchmark [features=100000] [queries=1000]" << endl;
+        return 1;
+    }
+    size_t count = argc > 1 ? stoul(argv[1]) : 100000;
+    int queries = argc > 2 ? stoi(argv[2]) : 1000;
+
+    SpatialIndex index;
+    vector<Feature> features;
+    features.reserve(count);
+    makeFeatures(count, index, features);
+    auto start = chrono::steady_clock::now();
+    index.build();
+    double build_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    float extent = static_cast<float>(ceil(sqrt(static_cast<double>(count) / 100.0))) * 100.0f;
+    mt19937 rng(42);
+    uniform_real_distribution<float> coord(0.0f, extent);
+    vector<array<float, 3>> points(queries);
+    for (auto &p : points) {
+        p = {coord(rng), coord(rng), -5.0f};
+    }
+
+    cout << count << " features, build " << setprecision(1) << fixed << build_seconds * 1000.0 << " ms, "
+         << index.byteSize() / 1024 << " KiB" << endl;
+
+    bool ok = true;
+    size_t found = 0;
+    double box = timeIt(queries, [&](int i) {
+        const auto &p = points[i];
+        found += index.queryBox({p[0] - 10, p[1] - 10, -20}, {p[0] + 10, p[1] + 10, 10}).size();
+    });
+    double box_linear = timeIt(queries, [&](int i) {
+        const auto &p = points[i];
+        vector<SpatialHit> hits;
+        for (const auto &f : features) {
+            if (f.max[0] >= p[0] - 10 && f.min[0] <= p[0] + 10 && f.max[1] >= p[1] - 10 && f.min[1] <= p[1] + 10) {
+                hits.push_back({f.layer, 0, f.id, 0.0f});
+            }
+        }
+        if (i < 50) {
+            ok &= ids(hits) == ids(index.queryBox({p[0] - 10, p[1] - 10, -20}, {p[0] + 10, p[1] + 10, 10}));
+        }
+    });
+    report("queryBox", box, box_linear);
+
+    // 20m内的车位
+    double radius = timeIt(queries, [&](int i) {
+        found += index.queryRadius(points[i], 20.0f, layerMask(PSDS)).size();
+    });
+    double radius_linear = timeIt(queries, [&](int i) {
+        vector<SpatialHit> hits;
+        for (const auto &f : features) {
+            if (f.layer == PSDS && boxDistance(f, points[i]) <= 20.0f) {
+                hits.push_back({f.layer, 0, f.id, 0.0f});
+            }
+        }
+        if (i < 50) {
+            ok &= ids(hits) == ids(index.queryRadius(points[i], 20.0f, layerMask(PSDS)));
+        }
+    });
+    report("queryRadius", radius, radius_linear);
+
+    // 最近的5根柱子
+    double nearest = timeIt(queries, [&](int i) {
+        found += index.nearestK(points[i], 5, layerMask(PILLARS)).size();
+    });
+    double nearest_linear = timeIt(queries, [&](int i) {
+        vector<pair<float, uint32_t>> all;
+        for (const auto &f : features) {
+            if (f.layer == PILLARS) {
+                all.emplace_back(boxDistance(f, points[i]), f.id);
+            }
+        }
+        partial_sort(all.begin(), all.begin() + 5, all.end());
+        if (i < 50) {
+            auto hits = index.nearestK(points[i], 5, layerMask(PILLARS));
+            for (size_t j = 0; j < hits.size(); ++j) {
+                ok &= fabs(hits[j].distance - all[j].first) < 1e-4f;
+            }
+        }
+    });
+    report("nearestK(5)", nearest, nearest_linear);
+
+    // 从10m高处斜向下的射线; 线性扫描只做包围盒测试, 作为下限参考
+    double ray = timeIt(queries, [&](int i) {
+        const auto &p = points[i];
+        found += index.raycast({p[0], p[1], 10.0f}, {0.3f, 0.2f, -1.0f}).size();
+    });
+    double ray_linear = timeIt(queries, [&](int i) {
+        const auto &p = points[i];
+        array<float, 3> o = {p[0], p[1], 10.0f}, d = {0.3f, 0.2f, -1.0f};
+        size_t hits = 0;
+        for (const auto &f : features) {
+            float tmin = 0.0f, tmax = 1e30f;
+            for (int axis = 0; axis < 3; ++axis) {
+                float t1 = (f.min[axis] - 0.2f - o[axis]) / d[axis], t2 = (f.max[axis] + 0.2f - o[axis]) / d[axis];
+                tmin = max(tmin, min(t1, t2));
+                tmax = min(tmax, max(t1, t2));
+            }
+            hits += tmin <= tmax;
+        }
+        found += hits;
+    });
+    report("raycast", ray, ray_linear);
+
+    // 车位中心正上方向下的射线, 第一个命中应为该车位
+    for (size_t i = 0; i < features.size() && i < 5000; i += 100) {
+        const auto &f = features[i];
+        float cx = (f.min[0] + f.max[0]) / 2, cy = (f.min[1] + f.max[1]) / 2;
+        auto hits = index.raycast({cx, cy, f.max[2] + 10.0f}, {0.0f, 0.0f, -1.0f}, 0.2f, layerMask(PSDS));
+        ok &= !hits.empty() && hits.front().id == f.id && fabs(hits.front().distance - 10.0f) < 1e-3f;
+    }
+
+    cout << "  (" << found << " hits)" << endl;
+    if (!ok) {
+        cerr << "MISMATCH between R-tree and linear scan" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "utils/gl_util.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 动态图层流式上传压力测试: 每帧重新生成overlays条轨迹并上传绘制.
+// 对比 持久映射环形缓冲 / GL 3.3 orphaning回退 / 每帧glBufferData(GL_STATIC_DRAW)
+
+namespace {
+    const size_t kStride = 4 * sizeof(float);  // xyz + 填充, 保证offset可整除得到首顶点
+
+    enum class Mode {
+        PERSISTENT, ORPHAN, STATIC_DRAW
+    };
+
+    const char *modeName(Mode mode) {
+        switch (mode) {
+            case Mode::PERSISTENT:
+                return "persistent ring";
+            case Mode::ORPHAN:
+                return "orphaning ring";
+            default:
+                return "glBufferData";
+        }
+    }
+
+    void fillTrajectories(float *out, int frame, int overlays, int points) {
+        for (int i = 0; i < overlays; ++i) {
+            float phase = static_cast<float>(frame) * 0.05f + static_cast<float>(i);
+            for (int j = 0; j < points; ++j) {
+                float *v = out + (static_cast<size_t>(i) * points + j) * 4;
+                v[0] = static_cast<float>(i % 50) * 4.0f + static_cast<float>(j) * 0.2f;
+                v[1] = static_cast<float>(i / 50) * 4.0f + std::sin(phase + static_cast<float>(j) * 0.1f);
+                v[2] = 0.0f;
+                v[3] = 0.0f;
+            }
+        }
+    }
+
+    struct Result {
+        double seconds{};
+        double stall{};
+        bool persistent{};
+    };
+
+    Result run(GLUtil &gl_util, Mode mode, int frames, int overlays, int points) {
+        size_t frameBytes = static_cast<size_t>(overlays) * points * kStride;
+
+        unsigned int vao;
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glDisableVertexAttribArray(1);
+        glVertexAttribI4ui(1, style::key(style::ROAD, style::SELECTED), 0, 0, 0);
+
+        StreamBuffer stream;
+        unsigned int staticVBO = 0;
+        std::vector<float> scratch;
+        if (mode == Mode::STATIC_DRAW) {
+            glGenBuffers(1, &staticVBO);
+            scratch.resize(frameBytes / sizeof(float));
+        } else {
+            stream.init(GL_ARRAY_BUFFER, frameBytes * 3 + 4096, 3, mode == Mode::ORPHAN);
+        }
+
+        std::vector<GLint> firsts(overlays);
+        std::vector<GLsizei> counts(overlays, points);
+
+        glFinish();
+        double start = glfwGetTime();
+        for (int frame = 0; frame < frames; ++frame) {
+            gl_util.clear();
+            gl_util.updateTransforms();
+
+            GLint base = 0;
+            if (mode == Mode::STATIC_DRAW) {
+                fillTrajectories(scratch.data(), frame, overlays, points);
+                glBindBuffer(GL_ARRAY_BUFFER, staticVBO);
+                glBufferData(GL_ARRAY_BUFFER, frameBytes, scratch.data(), GL_STATIC_DRAW);
+            } else {
+                auto allocation = stream.allocate(frameBytes, kStride);
+                if (allocation.ptr == nullptr) {
+                    break;
+                }
+                fillTrajectories(static_cast<float *>(allocation.ptr), frame, overlays, points);
+                stream.commit(allocation);
+                glBindBuffer(GL_ARRAY_BUFFER, stream.buffer());
+                base = static_cast<GLint>(allocation.offset / kStride);
+            }
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, kStride, (void *) 0);
+            glEnableVertexAttribArray(0);
+
+            for (int i = 0; i < overlays; ++i) {
+                firsts[i] = base + i * points;
+            }
+            glMultiDrawArrays(GL_LINE_STRIP, firsts.data(), counts.data(), overlays);
+
+            stream.endFrame();
+            glfwSwapBuffers(gl_util.window());
+        }
+        glFinish();
+
+        Result result;
+        result.seconds = glfwGetTime() - start;
+        result.stall = stream.stallSeconds();
+        result.persistent = stream.persistent();
+
+        stream.release();
+        if (staticVBO != 0) {
+            glDeleteBuffers(1, &staticVBO);
+        }
+        glBindVertexArray(0);
+        glDeleteVertexArrays(1, &vao);
+        return result;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 4) {
+        cout << "Usage: ./stream_benchmark [frames=300] [overlays=2000] [points_per_overlay=64]" << endl;
+        return 1;
+    }
+    int frames = argc > 1 ? atoi(argv[1]) : 300;
+    int overlays = argc > 2 ? atoi(argv[2]) : 2000;
+    int points = argc > 3 ? atoi(argv[3]) : 64;
+
+    GLUtil gl_util;
+    if (!gl_util.init(glm::vec3(100.0f, -60.0f, 80.0f), glm::vec3(100.0f, 80.0f, 0.0f), true)) {
+        return 1;
+    }
+    cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << endl;
+    cout << "frames=" << frames << " overlays=" << overlays << " points=" << points
+         << " (" << static_cast<double>(overlays) * points * kStride / (1 << 20) << " MiB/frame)" << endl;
+
+    for (auto mode : {Mode::PERSISTENT, Mode::ORPHAN, Mode::STATIC_DRAW}) {
+        auto result = run(gl_util, mode, frames, overlays, points);
+        if (mode == Mode::PERSISTENT && !result.persistent) {
+            cout << setw(18) << modeName(mode) << ": unavailable (GL < 4.4), fell back to orphaning" << endl;
+        }
+        cout << setw(18) << modeName(mode) << ": "
+             << fixed << setprecision(3) << result.seconds * 1000.0 / frames << " ms/frame, "
+             << setprecision(1) << frames / result.seconds << " fps, fence stall "
+             << setprecision(3) << result.stall * 1000.0 << " ms total" << endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
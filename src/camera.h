@@ -64,6 +64,9 @@ class Camera {
     float getZoom() const {
       return zoom;
     }
+    glm::vec3 getPosition() const {
+      return position_;
+    }
   private:
     glm::vec3 position_;
 
@@ -0,0 +1,155 @@
+#include "navi_map/navi_map.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "utils/gl_util.h"
+#include "utils/cull_pass.h"
+#include "utils/camera_path.h"
+
+using namespace std;
+
+// 从起点沿规划路线飞到目标车位的无窗口视频导出. 渲染在主线程, 视锥剔除、PBO读回后的PNG编码
+// (或写入外部编码器的管道)各在自己的线程上, 三者流水并行
+
+namespace {
+    constexpr float kEyeHeight = 8.0f;   // 相机高出路线的高度(米)
+    constexpr float kEyeBack = 12.0f;    // 相机落后于当前位置的弧长(米)
+    constexpr float kLookAhead = 8.0f;   // 注视点领先于当前位置的弧长(米)
+
+    glm::vec3 toVec3(const std::array<float, 3> &p) {
+        return {p[0], p[1], p[2]};
+    }
+}
+
+int main(int argc, char *argv[]) {
+    // --output=dir: PNG序列的目录, 默认fly_through_<partition_id>; 只给--pipe时不写PNG
+    // --pipe=command: 按顺序把rgb24原始帧写入command的标准输入, 如ffmpeg
+    // --fps=F: 帧率, 默认30; --speed=V: 沿路线的速度(米/秒), 默认4
+    // --target=id: 目标车位, 默认使用地图中的目标车位
+    string output, pipe;
+    float fps = 30.0f, speed = 4.0f;
+    int target = -1;
+    bool args_ok = argc >= 3;
+    for (int i = 3; i < argc; ++i) {
+        string arg = argv[i];
+        char *end = nullptr;
+        if (arg.rfind("--output=", 0) == 0 && arg.size() > 9) {
+            output = arg.substr(9);
+        } else if (arg.rfind("--pipe=", 0) == 0 && arg.size() > 7) {
+            pipe = arg.substr(7);
+        } else if (arg.rfind("--fps=", 0) == 0) {
+            fps = strtof(arg.c_str() + 6, &end);
+            args_ok = args_ok && *end == '\0' && fps > 0.0f;
+        } else if (arg.rfind("--speed=", 0) == 0) {
+            speed = strtof(arg.c_str() + 8, &end);
+            args_ok = args_ok && *end == '\0' && speed > 0.0f;
+        } else if (arg.rfind("--target=", 0) == 0) {
+            target = static_cast<int>(strtol(arg.c_str() + 9, &end, 10));
+            args_ok = args_ok && *end == '\0';
+        } else {
+            args_ok = false;
+        }
+    }
+    if (!args_ok) {
+        cout << "Usage: ./fly_through <db_file> <partition_id> [--output=dir] [--pipe=command] [--fps=F] [--speed=V]"
+                " [--target=id]" << endl;
+        return 1;
+    }
+    int partition_id = atoi(argv[2]);
+    if (output.empty() && pipe.empty()) {
+        output = "fly_through_" + to_string(partition_id);
+    }
+
+    auto navi_map = navi_map::NaviMap::createNaviMap(argv[1], partition_id, navi_map::BlobType::LOC);
+    auto start = navi_map->getStartPoint();
+    std::array<float, 3> from = {static_cast<float>(start[0]), static_cast<float>(start[1]),
+                                 static_cast<float>(start[2])};
+    if (target < 0) {
+        target = navi_map->getTargetId();
+    }
+    auto route = navi_map->findRouteToParkingSpace(from, target);
+    if (!route.found) {
+        cout << "no route to " << target << endl;
+        return 1;
+    }
+    CameraPath path(route.points);
+    size_t frames = static_cast<size_t>(std::ceil(path.length() / speed * fps)) + 1;
+    cout << "route to " << target << ": " << path.length() << " m, " << frames << " frames" << endl;
+
+    GLUtil gl_util;
+    if (!gl_util.init(toVec3(path.at(0.0f)) + glm::vec3(0.0f, 0.0f, kEyeHeight), toVec3(path.at(kLookAhead)),
+                      true)) {
+        return 1;
+    }
+    // 不等待垂直同步, 帧率只受渲染和编码吞吐限制
+    glfwSwapInterval(0);
+
+    enum { ROADS, POIS, ROAD_MARKS, ROAD_OBSTACLES, PSDS, ROUTE, LAYER_COUNT };
+    std::vector<LayerBuffer> layers(LAYER_COUNT);
+    navi_map->bindRoadsData(layers[ROADS]);
+    navi_map->bindPoiData(layers[POIS]);
+    navi_map->bindRoadMarkData(layers[ROAD_MARKS]);
+    navi_map->bindRoadObstacleData(layers[ROAD_OBSTACLES]);
+    navi_map->bindPsdsData(layers[PSDS]);
+    if (target != navi_map->getTargetId()) {
+        navi_map->setTargetId(target, layers[PSDS]);
+    }
+    navi_map->bindRouteData(route, layers[ROUTE]);
+    std::vector<const LayerBuffer *> cullLayers;
+    for (const auto &layer : layers) {
+        cullLayers.push_back(&layer);
+    }
+    CullPass cull;
+    cull.init();
+
+    auto &capture = gl_util.capture();
+    if (!output.empty()) {
+        capture.startSequence(output);
+    }
+    if (!pipe.empty()) {
+        // 编码器提前退出时由写入失败处理, 不让SIGPIPE结束进程
+        signal(SIGPIPE, SIG_IGN);
+        if (!capture.startPipe(pipe)) {
+            return 1;
+        }
+        auto size = gl_util.windowSize();
+        cout << "pipe: rgb24 " << size.x << "x" << size.y << " at " << fps << " fps" << endl;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames; ++i) {
+        float s = frames > 1 ? path.length() * static_cast<float>(i) / static_cast<float>(frames - 1) : 0.0f;
+        gl_util.setCamera(toVec3(path.at(s - kEyeBack)) + glm::vec3(0.0f, 0.0f, kEyeHeight),
+                          toVec3(path.at(s + kLookAhead)));
+        gl_util.clear();
+        gl_util.updateTransforms();
+        cull.wait();
+        glPointSize(10.0f);
+        for (auto &layer : layers) {
+            cull.draw(layer);
+        }
+        cull.start(cullLayers, gl_util.projectionMatrix() * gl_util.viewMatrix());
+        gl_util.present();
+    }
+    cull.release();
+    capture.stopSequence();
+    capture.stopPipe();
+    capture.release();
+    capture.wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    cout << "exported " << frames << " frames in " << seconds << " s ("
+         << static_cast<double>(frames) / seconds << " fps), capture stall " << capture.stallSeconds() << " s"
+         << endl;
+
+    for (auto &layer : layers) {
+        layer.release();
+    }
+    glfwTerminate();
+    return 0;
+}
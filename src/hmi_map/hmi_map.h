@@ -4,6 +4,10 @@
 #include<vector>
 #include<array>
 #include<memory>
+#include<string>
+#include "utils/layer_buffer.h"
+#include "utils/spatial_index.h"
+#include "utils/footprint_lod.h"
 
 struct Pillar {
     int pillarId{};
@@ -37,6 +41,20 @@ struct Floor {
     std::vector<Road> roads;
 };
 
+// 楼层内所有要素的包围盒, 柱子含绘制高度; 没有要素时min > max
+struct FloorBounds {
+    std::array<float, 3> min{};
+    std::array<float, 3> max{};
+};
+
+// 空间查询结果中的SpatialHit::layer, SpatialHit::group为楼层在getFloorNames()中的下标
+enum HmiSpatialLayer : uint32_t {
+    SPATIAL_PILLARS,
+    SPATIAL_PSDS,
+    SPATIAL_SPEED_BUMPS,
+    SPATIAL_ROADS,
+};
+
 enum class LoadType {
     FILE,
     STRING,
@@ -47,7 +65,10 @@ class HMIMap {
     static std::shared_ptr<HMIMap> createHmiMap(const std::string& data, LoadType loadType);
     virtual ~HMIMap() = default;
 
+    // 按floorName升序, 楼层在其中的下标即楼层的稠密编号
     [[nodiscard]] virtual std::vector<float> getFloorNames() const = 0;
+    // 直接读取楼层原始数据计算, 不触发要素转换; 结果缓存
+    [[nodiscard]] virtual FloorBounds getFloorBounds(float floorName) const = 0;
     [[nodiscard]] virtual std::vector<Pillar> getPillars(float floorName) const = 0;
     [[nodiscard]] virtual std::vector<Psd> getPsds(float floorName) const = 0;
     [[nodiscard]] virtual std::vector<SpeedBump> getSpeedBumps(float floorName) const = 0;
@@ -56,26 +77,29 @@ class HMIMap {
     [[nodiscard]] virtual std::array<float, 3> getStartPoint() const = 0;
     [[nodiscard]] virtual std::array<float, 3> getEndPoint() const = 0;
 
-    virtual void bindPillarsData(float floorName,
-        const std::vector<unsigned int> &VAOs,
-        const std::vector<unsigned int> &vertexVBOs,
-        const std::vector<unsigned int> &colorVBOs,
-        const std::vector<unsigned int> &indicesEBOs) = 0;
-    virtual void bindPsdsData(float floorName,
-        const std::vector<unsigned int> &VAOs,
-        const std::vector<unsigned int> &vertexVBOs,
-        const std::vector<unsigned int> &colorVBOs,
-        const std::vector<unsigned int> &indicesEBOs) = 0;
-    virtual void bindSpeedBumpsData(float floorName,
-        const std::vector<unsigned int> &VAOs,
-        const std::vector<unsigned int> &vertexVBOs,
-        const std::vector<unsigned int> &colorVBOs,
-        const std::vector<unsigned int> &indicesEBOs) = 0;
-    virtual std::vector<unsigned int> bindRoadsData(float floorName,
-        const std::vector<unsigned int> &VAOs,
-        const std::vector<unsigned int> &vertexVBOs,
-        const std::vector<unsigned int> &colorVBOs,
-        const std::vector<unsigned int> &indicesEBOs) = 0;
+    // 切换目标车位: 只改写新旧目标车位在各楼层psds中的状态区间, 不重新绑定
+    virtual void setTargetId(int id, const std::vector<LayerBuffer *> &psds) = 0;
+
+    virtual void bindPillarsData(float floorName, LayerBuffer &pillars) = 0;
+    virtual void bindPsdsData(float floorName, LayerBuffer &psds) = 0;
+    virtual void bindSpeedBumpsData(float floorName, LayerBuffer &speedBumps) = 0;
+    virtual void bindRoadsData(float floorName, LayerBuffer &roads) = 0;
+
+    // 楼层内沿柱网方向排成一排的柱子(members为pillarId), 用于远处的聚合绘制. 首次调用时聚类并缓存
+    [[nodiscard]] virtual std::vector<FootprintCluster> getPillarRows(float floorName) const = 0;
+    // 每排一个柱顶高度的填充轮廓, 要素id为排在getPillarRows()中的下标
+    virtual void bindPillarRowsData(float floorName, LayerBuffer &rows) = 0;
+
+    // 空间查询, 不需要GL上下文. 首次调用时转换所有楼层的要素并构建R树, 柱子按绘制高度拉伸.
+    // layers为layerMask(HmiSpatialLayer)的组合
+    [[nodiscard]] virtual std::vector<SpatialHit> queryBox(const std::array<float, 3> &min,
+        const std::array<float, 3> &max, uint32_t layers = kAllLayers) const = 0;
+    [[nodiscard]] virtual std::vector<SpatialHit> queryRadius(const std::array<float, 3> &center, float radius,
+        uint32_t layers = kAllLayers) const = 0;
+    [[nodiscard]] virtual std::vector<SpatialHit> nearestK(const std::array<float, 3> &point, size_t k,
+        uint32_t layers = kAllLayers) const = 0;
+    [[nodiscard]] virtual std::vector<SpatialHit> raycast(const std::array<float, 3> &origin,
+        const std::array<float, 3> &direction, float tolerance = 0.2f, uint32_t layers = kAllLayers) const = 0;
 };
 
 #endif //HMI_MAP_H
@@ -1,12 +1,51 @@
 #include "hmi_map_impl.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "utils/style_palette.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
-#include <numeric>
+#include <limits>
+#include <stdexcept>
 
 using namespace nlohmann;
 
+namespace {
+    constexpr uint8_t kSpeedBumpMark = 1;  // navi_map::RoadMark::SPEED_BUMP
+    constexpr float kPillarHeight = 3.0f;
+    // 同一排相邻柱子的最大间隙, 大于常见柱距; 排与排之间靠垂直方向的投影不重叠区分
+    constexpr float kPillarRowGap = 12.0f;
+    constexpr float kPillarRowMaxDz = 1.0f;
+
+    void readPoints(const json &points, std::vector<float> &out) {
+        for (const auto &point : points) {
+            out.push_back(point.at("x"));
+            out.push_back(point.at("y"));
+            out.push_back(point.at("z"));
+        }
+    }
+
+    void expand(FloorBounds &bounds, float x, float y, float z) {
+        const float p[3] = {x, y, z};
+        for (int i = 0; i < 3; ++i) {
+            bounds.min[i] = std::min(bounds.min[i], p[i]);
+            bounds.max[i] = std::max(bounds.max[i], p[i]);
+        }
+    }
+
+    void expand(FloorBounds &bounds, const std::vector<float> &points, float height = 0.0f) {
+        for (size_t i = 0; i + 2 < points.size(); i += 3) {
+            expand(bounds, points[i], points[i + 1], points[i + 2] + height);
+        }
+    }
+
+    void expand(FloorBounds &bounds, const json &points, float height = 0.0f) {
+        for (const auto &point : points) {
+            expand(bounds, point.at("x"), point.at("y"), point.at("z").get<float>() + height);
+        }
+    }
+}
+
 std::shared_ptr<HMIMap> HMIMap::createHmiMap(const std::string &data, LoadType loadType) {
     return std::make_shared<HmiMapImpl>(data, loadType);
 }
@@ -23,58 +62,146 @@ HmiMapImpl::HmiMapImpl(const std::string &data, LoadType loadType) {
     }
 }
 
-void HmiMapImpl::init(const nlohmann::json& data) {
-    json floors = data["floor"];
+void HmiMapImpl::init(nlohmann::json& data) {
+    json &floors = data["floor"];
 
     for (auto & it : floors) {
-        Floor floor;
-        auto floorName = it.at("floorName");
-        auto pillars = it.at("pillar");
-        auto psds = it.at("psd");
-        auto speedBumps = it.at("speedBump");
-        auto roads = it.at("road");
-
-        floor.floorName = floorName;
-        for (const auto &pillar : pillars) {
+        LazyFloor floor;
+        floor.floor.floorName = it.at("floorName");
+        floor.source = std::move(it);
+        floorData.push_back(std::move(floor));
+    }
+    std::sort(floorData.begin(), floorData.end(), [](const LazyFloor &a, const LazyFloor &b) {
+        return a.floor.floorName < b.floor.floorName;
+    });
+
+    json info = data["info"];
+    startPoint[0] = info["learningStart"].at("x");
+    startPoint[1] = info["learningStart"].at("y");
+    startPoint[2] = info["learningStart"].at("z");
+    endPoint[0] = info["learningEnd"].at("x");
+    endPoint[1] = info["learningEnd"].at("y");
+    endPoint[2] = info["learningEnd"].at("z");
+
+    targetPrkId = info["targetPrk"].at("targetPrkId");
+
+    std::cout << "Loaded hmi map" << std::endl;
+}
+
+std::vector<float> HmiMapImpl::getFloorNames() const {
+    std::vector<float> floorNames;
+    floorNames.reserve(floorData.size());
+    for (const auto &it : floorData) {
+        floorNames.push_back(it.floor.floorName);
+    }
+    return floorNames;
+}
+
+size_t HmiMapImpl::floorIndex(float floorName) const {
+    auto it = std::lower_bound(floorData.begin(), floorData.end(), floorName, [](const LazyFloor &a, float name) {
+        return a.floor.floorName < name;
+    });
+    if (it == floorData.end() || it->floor.floorName != floorName) {
+        throw std::out_of_range("unknown floor " + std::to_string(floorName));
+    }
+    return static_cast<size_t>(it - floorData.begin());
+}
+
+FloorBounds HmiMapImpl::getFloorBounds(float floorName) const {
+    auto &lazy = floorData[floorIndex(floorName)];
+    if (lazy.hasBounds) {
+        return lazy.bounds;
+    }
+    auto &bounds = lazy.bounds;
+    bounds.min.fill(std::numeric_limits<float>::max());
+    bounds.max.fill(std::numeric_limits<float>::lowest());
+    // 已转换的类别读转换结果, 其余直接读json
+    const auto &floor = lazy.floor;
+    const auto &source = lazy.source;
+    if (lazy.converted & PILLARS) {
+        for (const auto &pillar : floor.pillars) {
+            expand(bounds, pillar.points);
+            expand(bounds, pillar.points, kPillarHeight);
+        }
+    } else {
+        for (const auto &pillar : source.at("pillar")) {
+            expand(bounds, pillar.at("points"));
+            expand(bounds, pillar.at("points"), kPillarHeight);
+        }
+    }
+    if (lazy.converted & PSDS) {
+        for (const auto &psd : floor.psds) {
+            expand(bounds, psd.points);
+        }
+    } else {
+        for (const auto &psd : source.at("psd")) {
+            expand(bounds, psd.at("points"));
+        }
+    }
+    if (lazy.converted & SPEED_BUMPS) {
+        for (const auto &speedBump : floor.speedBumps) {
+            expand(bounds, speedBump.points);
+        }
+    } else {
+        for (const auto &speedBump : source.at("speedBump")) {
+            expand(bounds, speedBump.at("points"));
+        }
+    }
+    if (lazy.converted & ROADS) {
+        for (const auto &road : floor.roads) {
+            expand(bounds, road.roadCenter);
+        }
+    } else {
+        for (const auto &road : source.at("road")) {
+            for (const auto &center : road.at("roadCenter")) {
+                const auto &point = center.at("point");
+                expand(bounds, point.at("x"), point.at("y"), point.at("z"));
+            }
+        }
+    }
+    lazy.hasBounds = true;
+    return bounds;
+}
+
+const Floor &HmiMapImpl::floor(size_t index, FloorKind kind) const {
+    auto &lazy = floorData[index];
+    if (lazy.converted & kind) {
+        return lazy.floor;
+    }
+    auto &floor = lazy.floor;
+    const auto &source = lazy.source;
+    if (kind == PILLARS) {
+        for (const auto &pillar : source.at("pillar")) {
             Pillar p;
             p.pillarId = pillar.at("pillarId");
             for (const auto &id : pillar.at("roadId")) {
                 p.road.push_back(id);
             }
-            for (const auto &point : pillar.at("points")) {
-                p.points.push_back(point.at("x"));
-                p.points.push_back(point.at("y"));
-                p.points.push_back(point.at("z"));
-            }
+            readPoints(pillar.at("points"), p.points);
             floor.pillars.push_back(p);
         }
-        for (const auto &psd : psds) {
+    } else if (kind == PSDS) {
+        for (const auto &psd : source.at("psd")) {
             Psd p;
             p.psdId = psd.at("psdId");
             for (const auto &id : psd.at("roadId")) {
                 p.road.push_back(id);
             }
-            for (const auto &point : psd.at("points")) {
-                p.points.push_back(point.at("x"));
-                p.points.push_back(point.at("y"));
-                p.points.push_back(point.at("z"));
-            }
+            readPoints(psd.at("points"), p.points);
             floor.psds.push_back(p);
         }
-        for (const auto &speedBump : speedBumps) {
+    } else if (kind == SPEED_BUMPS) {
+        for (const auto &speedBump : source.at("speedBump")) {
             SpeedBump p;
             p.speedBumpId = speedBump.at("speedBumpId");
             for (const auto &id : speedBump.at("roadId")) {
                 p.road.push_back(id);
             }
-            for (const auto &point : speedBump.at("points")) {
-                p.points.push_back(point.at("x"));
-                p.points.push_back(point.at("y"));
-                p.points.push_back(point.at("z"));
-            }
+            readPoints(speedBump.at("points"), p.points);
             floor.speedBumps.push_back(p);
         }
-        for (const auto &road : roads) {
+    } else if (kind == ROADS) {
+        for (const auto &road : source.at("road")) {
             Road p;
             p.roadId = road.at("roadId");
             p.slopeType = road.at("slopeType");
@@ -85,63 +212,48 @@ void HmiMapImpl::init(const nlohmann::json& data) {
             }
             floor.roads.push_back(p);
         }
-
-        floorData.emplace(floorName, floor);
     }
-
-    json info = data["info"];
-    startPoint[0] = info["learningStart"].at("x");
-    startPoint[1] = info["learningStart"].at("y");
-    startPoint[2] = info["learningStart"].at("z");
-    endPoint[0] = info["learningEnd"].at("x");
-    endPoint[1] = info["learningEnd"].at("y");
-    endPoint[2] = info["learningEnd"].at("z");
-
-    targetPrkId = info["targetPrk"].at("targetPrkId");
-
-    std::cout << "Loaded hmi map" << std::endl;
-}
-
-std::vector<float> HmiMapImpl::getFloorNames() const {
-    std::vector<float> floorNames;
-    floorNames.reserve(floorData.size());
-    for (const auto &it : floorData) {
-        floorNames.push_back(it.first);
+    lazy.converted |= kind;
+    if (lazy.converted == ALL_KINDS) {
+        lazy.source = nullptr;
     }
-    return floorNames;
+    return floor;
 }
 
 std::vector<Pillar> HmiMapImpl::getPillars(float floorName) const {
-    return floorData.at(floorName).pillars;
+    return floor(floorIndex(floorName), PILLARS).pillars;
 }
 
 std::vector<Psd> HmiMapImpl::getPsds(float floorName) const {
-    return floorData.at(floorName).psds;
+    return floor(floorIndex(floorName), PSDS).psds;
 }
 
 std::vector<SpeedBump> HmiMapImpl::getSpeedBumps(float floorName) const {
-    return floorData.at(floorName).speedBumps;
+    return floor(floorIndex(floorName), SPEED_BUMPS).speedBumps;
 }
 
 std::vector<Road> HmiMapImpl::getRoads(float floorName) const {
-    return floorData.at(floorName).roads;
+    return floor(floorIndex(floorName), ROADS).roads;
 }
 
-void HmiMapImpl::bindPillarsData(float floorName,
-    const std::vector<unsigned int> &VAOs,
-    const std::vector<unsigned int> &vertexVBOs,
-    const std::vector<unsigned int> &colorVBOs,
-    const std::vector<unsigned int> &indicesEBOs) {
-
-    std::vector<float> colors = {
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 0.9f, 0.5f, 0.2f,
-        1.0f, 0.9f, 0.5f, 0.2f,
-        1.0f, 0.9f, 0.5f, 0.2f,
-        1.0f, 0.9f, 0.5f, 0.2f,
+void HmiMapImpl::setTargetId(int id, const std::vector<LayerBuffer *> &psds) {
+    for (auto *layer : psds) {
+        layer->setFeatureState(targetPrkId, style::NORMAL);
+        layer->setFeatureState(id, style::HIGHLIGHT);
+    }
+    targetPrkId = id;
+}
+
+void HmiMapImpl::bindPillarsData(float floorName, LayerBuffer &pillars) {
+    std::vector<uint16_t> styles = {
+        style::key(style::PILLAR_BOTTOM),
+        style::key(style::PILLAR_BOTTOM),
+        style::key(style::PILLAR_BOTTOM),
+        style::key(style::PILLAR_BOTTOM),
+        style::key(style::PILLAR_TOP),
+        style::key(style::PILLAR_TOP),
+        style::key(style::PILLAR_TOP),
+        style::key(style::PILLAR_TOP),
     };
     std::vector<unsigned int> indices = {
         0, 1, 2, 2, 3, 0,
@@ -152,170 +264,148 @@ void HmiMapImpl::bindPillarsData(float floorName,
         3, 2, 6, 6, 7, 3,
     };
 
-    auto pillars = getPillars(floorName);
-    for (size_t i = 0; i < pillars.size(); i++) {
-        std::vector<float> pillarsDataExpand;
-        std::copy(pillars[i].points.begin(), pillars[i].points.end(), std::back_inserter(pillarsDataExpand));
-        std::copy(pillars[i].points.begin(), pillars[i].points.end(), std::back_inserter(pillarsDataExpand));
-        pillarsDataExpand[14] += 3.0;
-        pillarsDataExpand[17] += 3.0;
-        pillarsDataExpand[20] += 3.0;
-        pillarsDataExpand[23] += 3.0;
-
-        glBindVertexArray(VAOs[i]);
-
-        glBindBuffer(GL_ARRAY_BUFFER, vertexVBOs[i]);
-        glBufferData(GL_ARRAY_BUFFER, pillarsDataExpand.size() * sizeof(float), pillarsDataExpand.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, colorVBOs[i]);
-        glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indicesEBOs[i]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        glBindVertexArray(0);
+    // 柱子按底面四个角点拉伸成长方体, 与styles/indices的8个顶点对应; 不足四个点的柱子跳过, 多余的点(如闭合点)忽略
+    LayerData layer;
+    for (const auto &pillar : getPillars(floorName)) {
+        if (pillar.points.size() < 12) {
+            continue;
+        }
+        std::vector<float> pillarsDataExpand(pillar.points.begin(), pillar.points.begin() + 12);
+        pillarsDataExpand.insert(pillarsDataExpand.end(), pillar.points.begin(), pillar.points.begin() + 12);
+        for (size_t z = 14; z < pillarsDataExpand.size(); z += 3) {
+            pillarsDataExpand[z] += kPillarHeight;
+        }
+        layer.addFeature(pillar.pillarId, GL_TRIANGLES, pillarsDataExpand, styles, indices);
     }
+    pillars.upload(layer);
 }
 
-void HmiMapImpl::bindPsdsData(float floorName,
-    const std::vector<unsigned int> &VAOs,
-    const std::vector<unsigned int> &vertexVBOs,
-    const std::vector<unsigned int> &colorVBOs,
-    const std::vector<unsigned int> &indicesEBOs) {
-
-    std::vector<float> colors = {
-        0.8f, 0.8f, 0.8f, 1.0f,
-        0.8f, 0.8f, 0.8f, 1.0f,
-        0.3f, 0.3f, 0.3f, 1.0f,
-        0.3f, 0.3f, 0.3f, 1.0f,
-    };
-    std::vector<float> targetColors = {
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 0.55f, 0.0f, 1.0f,
-        1.0f, 0.55f, 0.0f, 1.0f,
-    };
+void HmiMapImpl::bindPsdsData(float floorName, LayerBuffer &psds) {
     std::vector<unsigned int> indices = {
         0, 1, 2, 2, 3, 0,
     };
 
-    auto psds = getPsds(floorName);
-    for (size_t i = 0; i < psds.size(); i++) {
-
-        glBindVertexArray(VAOs[i]);
-
-        glBindBuffer(GL_ARRAY_BUFFER, vertexVBOs[i]);
-        glBufferData(GL_ARRAY_BUFFER, psds[i].points.size() * sizeof(float), psds[i].points.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, colorVBOs[i]);
-        if (psds[i].psdId == getTargetId()) {
-            glBufferData(GL_ARRAY_BUFFER, targetColors.size() * sizeof(float), targetColors.data(), GL_STATIC_DRAW);
-        } else {
-            glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
+    LayerData layer;
+    for (const auto &psd : getPsds(floorName)) {
+        if (psd.points.size() < 12) {
+            continue;  // indices需要四个角点
         }
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indicesEBOs[i]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        glBindVertexArray(0);
+        uint8_t state = psd.psdId == getTargetId() ? style::HIGHLIGHT : style::NORMAL;
+        // 前两个点为入口边, 其余为底边
+        std::vector<uint16_t> styles(psd.points.size() / 3, style::key(style::PSD_REAR, state));
+        styles[0] = styles[1] = style::key(style::PSD_ENTRY, state);
+        layer.addFeature(psd.psdId, GL_TRIANGLES, psd.points, styles, indices);
     }
+    psds.upload(layer);
 }
 
-void HmiMapImpl::bindSpeedBumpsData(float floorName,
-    const std::vector<unsigned int> &VAOs,
-    const std::vector<unsigned int> &vertexVBOs,
-    const std::vector<unsigned int> &colorVBOs,
-    const std::vector<unsigned int> &indicesEBOs) {
-
-    std::vector<float> colors = {
-        1.0f, 0.83f, 0.01f, 1.0f,
-        1.0f, 0.83f, 0.01f, 1.0f,
-    };
+void HmiMapImpl::bindSpeedBumpsData(float floorName, LayerBuffer &speedBumps) {
     std::vector<unsigned int> indices = {
         0, 1,
     };
 
-    auto speedBumps = getSpeedBumps(floorName);
-    for (size_t i = 0; i < speedBumps.size(); i++) {
-
-        glBindVertexArray(VAOs[i]);
-
-        glBindBuffer(GL_ARRAY_BUFFER, vertexVBOs[i]);
-        glBufferData(GL_ARRAY_BUFFER, speedBumps[i].points.size() * sizeof(float), speedBumps[i].points.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, colorVBOs[i]);
-        glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indicesEBOs[i]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        glBindVertexArray(0);
+    // 减速带与导航地图的SPEED_BUMP路面标识共用样式
+    LayerData layer;
+    for (const auto &speedBump : getSpeedBumps(floorName)) {
+        if (speedBump.points.size() < 6) {
+            continue;
+        }
+        layer.addFeature(speedBump.speedBumpId, GL_LINES, speedBump.points,
+            style::key(style::ROAD_MARK_BASE + kSpeedBumpMark), indices);
     }
+    speedBumps.upload(layer);
 }
 
-std::vector<unsigned int> HmiMapImpl::bindRoadsData(float floorName,
-    const std::vector<unsigned int> &VAOs,
-    const std::vector<unsigned int> &vertexVBOs,
-    const std::vector<unsigned int> &colorVBOs,
-    const std::vector<unsigned int> &indicesEBOs) {
-
-    std::vector<float> colors = {
-        0.0f, 0.7f, 1.0f, 1.0f,
-    };
-    std::vector<float> slopeColors = {
-        0.0f, 0.0f, 1.0f, 1.0f,
-    };
-
-    std::vector<unsigned int> roadPointNums{};
-
-    auto roads = getRoads(floorName);
-    for (size_t i = 0; i < roads.size(); i++) {
-        auto num = roads[i].roadCenter.size() / 3;
-        roadPointNums.push_back(num);
+void HmiMapImpl::bindRoadsData(float floorName, LayerBuffer &roads) {
+    LayerData layer;
+    for (const auto &road : getRoads(floorName)) {
+        layer.addFeature(road.roadId, GL_LINE_STRIP, road.roadCenter,
+            style::key(road.slopeType ? style::SLOPE_ROAD : style::ROAD));
+    }
+    roads.upload(layer);
+}
 
-        std::vector<float> colorExpand;
-        for (size_t j = 0; j < num; j++) {
-            if (roads[i].slopeType) {
-                std::copy(slopeColors.begin(), slopeColors.end(), std::back_inserter(colorExpand));
-            } else {
-                std::copy(colors.begin(), colors.end(), std::back_inserter(colorExpand));
-            }
+std::vector<FootprintCluster> HmiMapImpl::getPillarRows(float floorName) const {
+    size_t index = floorIndex(floorName);
+    auto &lazy = floorData[index];
+    if (lazy.hasPillarRows) {
+        return lazy.pillarRows;
+    }
+    const auto &pillars = floor(index, PILLARS).pillars;
+    std::vector<const std::vector<float> *> polygons;
+    for (const auto &pillar : pillars) {
+        polygons.push_back(&pillar.points);
+    }
+    lazy.pillarRows = cluster_footprints(polygons, kPillarRowGap, kPillarRowMaxDz);
+    for (auto &row : lazy.pillarRows) {
+        for (auto &member : row.members) {
+            member = static_cast<uint32_t>(pillars[member].pillarId);
         }
+    }
+    lazy.hasPillarRows = true;
+    return lazy.pillarRows;
+}
 
-        std::vector<unsigned int> indices(num);
-        std::iota(indices.begin(), indices.end(), 0);
-
-        glBindVertexArray(VAOs[i]);
-
-        glBindBuffer(GL_ARRAY_BUFFER, vertexVBOs[i]);
-        glBufferData(GL_ARRAY_BUFFER, roads[i].roadCenter.size() * sizeof(float), roads[i].roadCenter.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, colorVBOs[i]);
-        glBufferData(GL_ARRAY_BUFFER, colorExpand.size() * sizeof(float), colorExpand.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indicesEBOs[i]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+void HmiMapImpl::bindPillarRowsData(float floorName, LayerBuffer &rows) {
+    LayerData layer;
+    auto pillarRows = getPillarRows(floorName);
+    for (uint32_t i = 0; i < pillarRows.size(); ++i) {
+        auto footprint = pillarRows[i].footprint;
+        for (size_t k = 2; k < footprint.size(); k += 3) {
+            footprint[k] += kPillarHeight;
+        }
+        // 凸包按扇形三角化
+        std::vector<unsigned int> indices;
+        for (uint32_t k = 1; k + 1 < footprint.size() / 3; ++k) {
+            indices.insert(indices.end(), {0, k, k + 1});
+        }
+        layer.addFeature(i, GL_TRIANGLES, footprint, style::key(style::PILLAR_ROW), indices);
+    }
+    rows.upload(layer);
+}
 
-        glBindVertexArray(0);
+const SpatialIndex &HmiMapImpl::spatialIndex() const {
+    if (spatial) {
+        return *spatial;
     }
-    return roadPointNums;
+    spatial = std::make_unique<SpatialIndex>();
+    for (uint32_t group = 0; group < floorData.size(); ++group) {
+        for (const auto &pillar : floor(group, PILLARS).pillars) {
+            spatial->add(SPATIAL_PILLARS, group, pillar.pillarId, SpatialIndex::POLYGON, pillar.points.data(),
+                pillar.points.size() / 3, kPillarHeight);
+        }
+        for (const auto &psd : floor(group, PSDS).psds) {
+            spatial->add(SPATIAL_PSDS, group, psd.psdId, SpatialIndex::POLYGON, psd.points.data(),
+                psd.points.size() / 3);
+        }
+        for (const auto &speedBump : floor(group, SPEED_BUMPS).speedBumps) {
+            spatial->add(SPATIAL_SPEED_BUMPS, group, speedBump.speedBumpId, SpatialIndex::POLYLINE,
+                speedBump.points.data(), speedBump.points.size() / 3);
+        }
+        for (const auto &road : floor(group, ROADS).roads) {
+            spatial->add(SPATIAL_ROADS, group, road.roadId, SpatialIndex::POLYLINE, road.roadCenter.data(),
+                road.roadCenter.size() / 3);
+        }
+    }
+    spatial->build();
+    return *spatial;
+}
+
+std::vector<SpatialHit> HmiMapImpl::queryBox(const std::array<float, 3> &min, const std::array<float, 3> &max,
+    uint32_t layers) const {
+    return spatialIndex().queryBox(min, max, layers);
 }
 
+std::vector<SpatialHit> HmiMapImpl::queryRadius(const std::array<float, 3> &center, float radius,
+    uint32_t layers) const {
+    return spatialIndex().queryRadius(center, radius, layers);
+}
 
+std::vector<SpatialHit> HmiMapImpl::nearestK(const std::array<float, 3> &point, size_t k, uint32_t layers) const {
+    return spatialIndex().nearestK(point, k, layers);
+}
 
+std::vector<SpatialHit> HmiMapImpl::raycast(const std::array<float, 3> &origin, const std::array<float, 3> &direction,
+    float tolerance, uint32_t layers) const {
+    return spatialIndex().raycast(origin, direction, tolerance, layers);
+}
@@ -4,7 +4,7 @@
 #include "hmi_map.h"
 #include <nlohmann/json.hpp>
 
-#include <unordered_map>
+#include <vector>
 
 class HmiMapImpl : public HMIMap {
 public:
@@ -12,6 +12,8 @@ public:
 
     [[nodiscard]] std::vector<float> getFloorNames() const override;
 
+    [[nodiscard]] FloorBounds getFloorBounds(float floorName) const override;
+
     [[nodiscard]] std::vector<Pillar> getPillars(float floorName) const override;
 
     [[nodiscard]] std::vector<Psd> getPsds(float floorName) const override;
@@ -27,30 +29,52 @@ public:
     [[nodiscard]] std::array<float, 3> getEndPoint() const override { return endPoint; };
 
 
-    void bindPillarsData(float floorName,
-                         const std::vector<unsigned int> &VAOs,
-                         const std::vector<unsigned int> &vertexVBOs,
-                         const std::vector<unsigned int> &colorVBOs,
-                         const std::vector<unsigned int> &indicesEBOs) override;
-    void bindPsdsData(float floorName,
-        const std::vector<unsigned int> &VAOs,
-        const std::vector<unsigned int> &vertexVBOs,
-        const std::vector<unsigned int> &colorVBOs,
-        const std::vector<unsigned int> &indicesEBOs) override;
-    void bindSpeedBumpsData(float floorName,
-        const std::vector<unsigned int> &VAOs,
-        const std::vector<unsigned int> &vertexVBOs,
-        const std::vector<unsigned int> &colorVBOs,
-        const std::vector<unsigned int> &indicesEBOs) override;
-    std::vector<unsigned int> bindRoadsData(float floorName,
-        const std::vector<unsigned int> &VAOs,
-        const std::vector<unsigned int> &vertexVBOs,
-        const std::vector<unsigned int> &colorVBOs,
-        const std::vector<unsigned int> &indicesEBOs) override;
+    void setTargetId(int id, const std::vector<LayerBuffer *> &psds) override;
+
+    void bindPillarsData(float floorName, LayerBuffer &pillars) override;
+    void bindPsdsData(float floorName, LayerBuffer &psds) override;
+    void bindSpeedBumpsData(float floorName, LayerBuffer &speedBumps) override;
+    void bindRoadsData(float floorName, LayerBuffer &roads) override;
+
+    [[nodiscard]] std::vector<FootprintCluster> getPillarRows(float floorName) const override;
+    void bindPillarRowsData(float floorName, LayerBuffer &rows) override;
+
+    [[nodiscard]] std::vector<SpatialHit> queryBox(const std::array<float, 3> &min, const std::array<float, 3> &max,
+        uint32_t layers) const override;
+    [[nodiscard]] std::vector<SpatialHit> queryRadius(const std::array<float, 3> &center, float radius,
+        uint32_t layers) const override;
+    [[nodiscard]] std::vector<SpatialHit> nearestK(const std::array<float, 3> &point, size_t k,
+        uint32_t layers) const override;
+    [[nodiscard]] std::vector<SpatialHit> raycast(const std::array<float, 3> &origin,
+        const std::array<float, 3> &direction, float tolerance, uint32_t layers) const override;
 
 private:
-    void init(const nlohmann::json& data);
-    std::unordered_map<float, Floor> floorData;
+    // 按要素类别延迟转换: 楼层json先原样保留, 首次访问某类要素时才转换该类
+    enum FloorKind : uint8_t {
+        PILLARS = 1u << 0,
+        PSDS = 1u << 1,
+        SPEED_BUMPS = 1u << 2,
+        ROADS = 1u << 3,
+        ALL_KINDS = (1u << 4) - 1,
+    };
+    struct LazyFloor {
+        nlohmann::json source;
+        Floor floor;
+        uint8_t converted{};
+        FloorBounds bounds;
+        bool hasBounds{};
+        std::vector<FootprintCluster> pillarRows;
+        bool hasPillarRows{};
+    };
+
+    void init(nlohmann::json& data);
+    // floorName在floorData中的下标, 不存在时抛出std::out_of_range
+    size_t floorIndex(float floorName) const;
+    const Floor &floor(size_t index, FloorKind kind) const;
+    const SpatialIndex &spatialIndex() const;
+    // 按floorName升序排列, 以稠密下标访问
+    mutable std::vector<LazyFloor> floorData;
+    mutable std::unique_ptr<SpatialIndex> spatial;
     int targetPrkId;
     std::array<float, 3> startPoint;
     std::array<float, 3> endPoint;
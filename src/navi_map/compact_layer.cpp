@@ -0,0 +1,70 @@
+#include "compact_layer.h"
+#include <algorithm>
+#include <limits>
+
+CompactLayer CompactLayer::build(const TileLayer &layer, const TransUtil &trans_util) {
+    CompactLayer compact;
+    compact.ids = layer.ids;
+    compact.types = layer.types;
+    compact.offsets = layer.offsets;
+    compact.points.reserve(layer.points.size());
+    compact.bounds.reserve(layer.size() * 6);
+    compact.index.reserve(layer.size());
+    for (size_t i = 0; i < layer.size(); ++i) {
+        float box[6] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                        std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+                        std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+        const double *p = layer.point(i);
+        for (uint32_t j = 0; j < layer.pointCount(i); ++j, p += 3) {
+            auto enu = trans_util.transToENU(p[0], p[1], p[2]);
+            for (int axis = 0; axis < 3; ++axis) {
+                auto v = static_cast<float>(enu[axis]);
+                compact.points.push_back(v);
+                box[axis] = std::min(box[axis], v);
+                box[axis + 3] = std::max(box[axis + 3], v);
+            }
+        }
+        compact.bounds.insert(compact.bounds.end(), box, box + 6);
+        compact.index.emplace_back(layer.ids[i], static_cast<uint32_t>(i));
+    }
+    // 同id保留原顺序, find返回第一个
+    std::stable_sort(compact.index.begin(), compact.index.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+    return compact;
+}
+
+int CompactLayer::find(uint32_t id) const {
+    auto it = std::lower_bound(index.begin(), index.end(), id,
+                               [](const auto &entry, uint32_t value) { return entry.first < value; });
+    if (it == index.end() || it->first != id) {
+        return -1;
+    }
+    return static_cast<int>(it->second);
+}
+
+size_t CompactLayer::byteSize() const {
+    return (ids.capacity() + types.capacity() + offsets.capacity()) * sizeof(uint32_t) +
+           (points.capacity() + bounds.capacity()) * sizeof(float) +
+           index.capacity() * sizeof(std::pair<uint32_t, uint32_t>);
+}
+
+CompactTile CompactTile::build(const DecodedRoadTile &tile, const TransUtil &trans_util) {
+    CompactTile compact;
+    compact.roads = CompactLayer::build(tile.roads, trans_util);
+    compact.road_lengths = tile.road_lengths;
+    compact.road_heads = tile.road_heads;
+    compact.road_tails = tile.road_tails;
+    compact.road_directions = tile.road_directions;
+    compact.pois = CompactLayer::build(tile.pois, trans_util);
+    compact.road_marks = CompactLayer::build(tile.road_marks, trans_util);
+    compact.road_obstacles = CompactLayer::build(tile.road_obstacles, trans_util);
+    compact.parking_spaces = CompactLayer::build(tile.parking_spaces, trans_util);
+    return compact;
+}
+
+size_t CompactTile::byteSize() const {
+    return roads.byteSize() + road_lengths.capacity() * sizeof(float) +
+           (road_heads.capacity() + road_tails.capacity()) * sizeof(uint32_t) + road_directions.capacity() +
+           pois.byteSize() + road_marks.byteSize() +
+           road_obstacles.byteSize() + parking_spaces.byteSize();
+}
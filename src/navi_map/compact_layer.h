@@ -0,0 +1,47 @@
+#ifndef COMPACT_LAYER_H
+#define COMPACT_LAYER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "utils/road_tile_decoder.h"
+#include "utils/trans_util.h"
+
+// 低内存模式下一类要素的常驻形式: 点已转换为ENU float, 另存每要素包围盒和按id排序的索引
+struct CompactLayer {
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> types;
+    std::vector<uint32_t> offsets{0};
+    std::vector<float> points;       // [x, y, z, x, y, z, ...] ENU
+    std::vector<float> bounds;       // 每要素[min_x, min_y, min_z, max_x, max_y, max_z]
+    std::vector<std::pair<uint32_t, uint32_t>> index;  // (id, 要素下标), 按id排序
+
+    static CompactLayer build(const TileLayer &layer, const TransUtil &trans_util);
+
+    [[nodiscard]] size_t size() const { return ids.size(); }
+    [[nodiscard]] std::vector<float> featurePoints(size_t i) const {
+        return {points.begin() + offsets[i] * 3, points.begin() + offsets[i + 1] * 3};
+    }
+    [[nodiscard]] const float *featureBounds(size_t i) const { return bounds.data() + i * 6; }
+    // 返回要素下标, 不存在时返回-1
+    [[nodiscard]] int find(uint32_t id) const;
+    [[nodiscard]] size_t byteSize() const;
+};
+
+struct CompactTile {
+    CompactLayer roads;
+    std::vector<float> road_lengths;
+    std::vector<uint32_t> road_heads;
+    std::vector<uint32_t> road_tails;
+    std::vector<uint8_t> road_directions;
+    CompactLayer pois;
+    CompactLayer road_marks;
+    CompactLayer road_obstacles;
+    CompactLayer parking_spaces;
+
+    static CompactTile build(const DecodedRoadTile &tile, const TransUtil &trans_util);
+    [[nodiscard]] size_t byteSize() const;
+};
+
+#endif //COMPACT_LAYER_H
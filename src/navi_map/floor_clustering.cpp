@@ -0,0 +1,90 @@
+#include "floor_clustering.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr float kBinSize = 0.25f;       // 直方图格宽(米)
+    constexpr int kSmooth = 2;              // 平滑窗口半宽(格)
+    constexpr float kMinFloorGap = 2.0f;    // 相邻楼层的最小高差(米), 小于常见层高
+    constexpr float kPeakShare = 0.1f;      // 峰的权重不低于最高峰的比例
+}
+
+std::vector<float> cluster_floor_heights(const std::vector<float> &heights) {
+    std::vector<float> floors;
+    if (heights.empty()) {
+        return floors;
+    }
+    auto [lo_it, hi_it] = std::minmax_element(heights.begin(), heights.end());
+    float lo = *lo_it, hi = *hi_it;
+    size_t bins = static_cast<size_t>((hi - lo) / kBinSize) + 1;
+    std::vector<float> histogram(bins, 0.0f);
+    for (float z : heights) {
+        histogram[std::min(bins - 1, static_cast<size_t>((z - lo) / kBinSize))] += 1.0f;
+    }
+    std::vector<float> smooth(bins, 0.0f);
+    for (size_t i = 0; i < bins; ++i) {
+        for (int d = -kSmooth; d <= kSmooth; ++d) {
+            auto j = static_cast<std::ptrdiff_t>(i) + d;
+            if (j >= 0 && j < static_cast<std::ptrdiff_t>(bins)) {
+                smooth[i] += histogram[j];
+            }
+        }
+    }
+
+    // 从最高的格开始贪心取峰, 与已取的峰相距不足kMinFloorGap的格跳过
+    std::vector<size_t> order(bins);
+    for (size_t i = 0; i < bins; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return smooth[a] > smooth[b]; });
+    float top = smooth[order.front()];
+    auto gap = static_cast<std::ptrdiff_t>(std::ceil(kMinFloorGap / kBinSize));
+    std::vector<size_t> peaks;
+    for (size_t i : order) {
+        if (smooth[i] < top * kPeakShare) {
+            break;
+        }
+        // 只取局部极大, 避免把坡道上的缓坡当成楼层
+        if ((i > 0 && smooth[i - 1] > smooth[i]) || (i + 1 < bins && smooth[i + 1] > smooth[i])) {
+            continue;
+        }
+        bool separate = std::all_of(peaks.begin(), peaks.end(), [&](size_t p) {
+            return std::abs(static_cast<std::ptrdiff_t>(p) - static_cast<std::ptrdiff_t>(i)) >= gap;
+        });
+        if (separate) {
+            peaks.push_back(i);
+        }
+    }
+    std::sort(peaks.begin(), peaks.end());
+
+    std::vector<float> near;
+    for (size_t peak : peaks) {
+        float center = lo + (static_cast<float>(peak) + 0.5f) * kBinSize;
+        float reach = (static_cast<float>(kSmooth) + 0.5f) * kBinSize;
+        near.clear();
+        for (float z : heights) {
+            if (std::fabs(z - center) <= reach) {
+                near.push_back(z);
+            }
+        }
+        if (near.empty()) {
+            floors.push_back(center);
+            continue;
+        }
+        auto mid = near.begin() + static_cast<std::ptrdiff_t>(near.size() / 2);
+        std::nth_element(near.begin(), mid, near.end());
+        floors.push_back(*mid);
+    }
+    return floors;
+}
+
+int nearest_floor(const std::vector<float> &floor_heights, float z) {
+    auto it = std::lower_bound(floor_heights.begin(), floor_heights.end(), z);
+    if (it == floor_heights.end()) {
+        return static_cast<int>(floor_heights.size()) - 1;
+    }
+    if (it != floor_heights.begin() && z - *(it - 1) < *it - z) {
+        --it;
+    }
+    return static_cast<int>(it - floor_heights.begin());
+}
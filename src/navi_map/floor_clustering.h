@@ -0,0 +1,14 @@
+#ifndef FLOOR_CLUSTERING_H
+#define FLOOR_CLUSTERING_H
+
+#include <vector>
+
+// 由要素顶点的ENU高度估计各楼层的地面高度, 自下而上.
+// 高度直方图平滑后, 权重不低于最高峰kPeakShare且相距至少kMinFloorGap的峰为楼层, 楼层高度取峰附近样本的中位数.
+// 坡道的样本分散在两层之间形不成峰, 不会被当作楼层, 也不会拉偏楼层高度. 没有样本时返回空
+std::vector<float> cluster_floor_heights(const std::vector<float> &heights);
+
+// 离z最近的楼层下标, floor_heights升序且非空
+int nearest_floor(const std::vector<float> &floor_heights, float z);
+
+#endif //FLOOR_CLUSTERING_H
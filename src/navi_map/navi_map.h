@@ -4,6 +4,10 @@
 #include <memory>
 #include <vector>
 #include <array>
+#include <string>
+#include "utils/layer_buffer.h"
+#include "utils/spatial_index.h"
+#include "utils/footprint_lod.h"
 
 namespace navi_map {
 
@@ -90,6 +94,31 @@ namespace navi_map {
         std::vector<float> points;
     };
 
+    struct Route {
+        bool found{false};
+        float length{};                  // 沿道路的长度(米), 不含起终点到道路的连接段
+        std::vector<uint32_t> road_ids;  // 依次经过的road
+        std::vector<float> points;       // ENU折线, 从起点经道路到终点
+    };
+
+    // 按高度聚类得到的楼层, 自下而上
+    struct Floor {
+        int index;
+        float z;                // 楼层地面的ENU高度
+        float min_z;            // 归入该层的高度范围, 以与相邻楼层高度的中点为界
+        float max_z;
+        size_t feature_count;   // 只位于该层的要素数, 不含跨层的坡道等
+    };
+
+    // 空间查询结果中的SpatialHit::layer
+    enum SpatialLayer : uint32_t {
+        SPATIAL_ROADS,
+        SPATIAL_POIS,
+        SPATIAL_ROAD_MARKS,
+        SPATIAL_ROAD_OBSTACLES,
+        SPATIAL_PARKING_SPACES,
+    };
+
     enum class BlobType {
         NAVI, LOC
     };
@@ -98,44 +127,110 @@ namespace navi_map {
     public:
         virtual ~NaviMap() = default;
 
-        static std::shared_ptr<NaviMap> createNaviMap(const std::string &db_path, int partition_id, BlobType blob_type);
+        // low_memory: 解码后即转换为紧凑的ENU存储(含包围盒和id索引)并释放解码结果, get*从紧凑存储读取
+        static std::shared_ptr<NaviMap> createNaviMap(const std::string &db_path, int partition_id, BlobType blob_type,
+                                                      bool low_memory = false);
 
         [[nodiscard]] virtual std::array<double, 3> getStartPoint() const = 0;
 
         [[nodiscard]] virtual std::array<double, 3> getEndPoint() const = 0;
 
+        [[nodiscard]] virtual int getTargetId() const = 0;
+
+        // 切换目标车位: 只改写新旧目标车位在psds中的状态区间, 不重新绑定
+        virtual void setTargetId(int id, LayerBuffer &psds) = 0;
+
         [[nodiscard]] virtual std::vector<Road> getRoads() const = 0;
 
-        virtual std::vector<unsigned int> bindRoadsData(
-                const std::vector<unsigned int> &VAOs,
-                const std::vector<unsigned int> &vertexVBOs,
-                const std::vector<unsigned int> &colorVBOs) = 0;
+        [[nodiscard]] virtual LayerData getRoadsLayer() const = 0;
+
+        virtual void bindRoadsData(LayerBuffer &roads) = 0;
 
         [[nodiscard]] virtual std::vector<POI> getPOI() const = 0;
 
-        virtual std::vector<unsigned int> bindPoiData(const std::vector<unsigned int> &VAOs,
-                                 const std::vector<unsigned int> &vertexVBOs,
-                                 const std::vector<unsigned int> &colorVBOs) = 0;
+        [[nodiscard]] virtual LayerData getPoiLayer() const = 0;
+
+        virtual void bindPoiData(LayerBuffer &pois) = 0;
 
         [[nodiscard]] virtual std::vector<RoadMark> getRoadMark() const = 0;
 
-        virtual void bindRoadMarkData(const std::vector<unsigned int> &VAOs,
-                                      const std::vector<unsigned int> &vertexVBOs,
-                                      const std::vector<unsigned int> &colorVBOs) = 0;
+        [[nodiscard]] virtual LayerData getRoadMarkLayer() const = 0;
+
+        virtual void bindRoadMarkData(LayerBuffer &roadMarks) = 0;
 
         [[nodiscard]] virtual std::vector<RoadObstacle> getRoadObstacle() const = 0;
 
-        virtual std::vector<unsigned int> bindRoadObstacleData(const std::vector<unsigned int> &VAOs,
-                                          const std::vector<unsigned int> &vertexVBOs,
-                                          const std::vector<unsigned int> &colorVBOs) = 0;
+        [[nodiscard]] virtual LayerData getRoadObstacleLayer() const = 0;
+
+        virtual void bindRoadObstacleData(LayerBuffer &roadObstacles) = 0;
 
         [[nodiscard]] virtual std::vector<ParkingSpace> getParkingSpaces() const = 0;
 
-        virtual void bindPsdsData(
-                const std::vector<unsigned int> &VAOs,
-                const std::vector<unsigned int> &vertexVBOs,
-                const std::vector<unsigned int> &colorVBOs,
-                const std::vector<unsigned int> &indicesEBOs) = 0;
+        [[nodiscard]] virtual LayerData getPsdsLayer() const = 0;
+
+        virtual void bindPsdsData(LayerBuffer &psds) = 0;
+
+        // 按id查找车位, 不存在时返回false
+        virtual bool getParkingSpace(uint32_t id, ParkingSpace &psd) const = 0;
+
+        // 并排相邻的车位合并成的排(members为车位id), 用于远处的聚合绘制; 走廊模式下只含走廊内的车位.
+        // 首次调用时聚类并缓存; 非走廊模式下轮廓与成员写入磁盘缓存, 命中时不再解码车位和聚类
+        [[nodiscard]] virtual std::vector<FootprintCluster> getParkingRows() const = 0;
+
+        // 每排一个填充轮廓, 要素id为排在getParkingRows()中的下标
+        [[nodiscard]] virtual LayerData getParkingRowsLayer() const = 0;
+
+        virtual void bindParkingRowsData(LayerBuffer &rows) = 0;
+
+        // 当前常驻的CPU端地图数据字节数(blob, 解码结果, 紧凑存储), 不含GPU缓冲
+        [[nodiscard]] virtual size_t residentBytes() const = 0;
+
+        // 空间查询, 坐标与get*返回的ENU点一致, 不需要GL上下文. 首次调用时解码全部图层并构建R树.
+        // layers为layerMask(SpatialLayer)的组合
+        [[nodiscard]] virtual std::vector<SpatialHit> queryBox(const std::array<float, 3> &min,
+                                                               const std::array<float, 3> &max,
+                                                               uint32_t layers = kAllLayers) const = 0;
+
+        [[nodiscard]] virtual std::vector<SpatialHit> queryRadius(const std::array<float, 3> &center, float radius,
+                                                                  uint32_t layers = kAllLayers) const = 0;
+
+        [[nodiscard]] virtual std::vector<SpatialHit> nearestK(const std::array<float, 3> &point, size_t k,
+                                                               uint32_t layers = kAllLayers) const = 0;
+
+        [[nodiscard]] virtual std::vector<SpatialHit> raycast(const std::array<float, 3> &origin,
+                                                              const std::array<float, 3> &direction,
+                                                              float tolerance = 0.2f,
+                                                              uint32_t layers = kAllLayers) const = 0;
+
+        // 在road.head_id/tail_id/travel_direction构成的路网上用A*求最短行驶路线, 起终点先投影到最近的road.
+        // 首次调用时构建CSR路网
+        [[nodiscard]] virtual Route findRoute(const std::array<float, 3> &from, const std::array<float, 3> &to) const = 0;
+
+        // 终点为车位入口边(前两个点)的中点, 车位不存在时found为false
+        [[nodiscard]] virtual Route findRouteToParkingSpace(const std::array<float, 3> &from,
+                                                            uint32_t parking_space_id) const = 0;
+
+        [[nodiscard]] virtual LayerData getRouteLayer(const Route &route) const = 0;
+
+        virtual void bindRouteData(const Route &route, LayerBuffer &buffer) = 0;
+
+        // 走廊模式: 之后的get*Layer/bind*Data只包含与路线两侧各width / 2范围相交且在同一楼层的要素(由R树筛选),
+        // 不读写磁盘缓存.
+        // route.found为false时恢复完整图层. 已绑定的图层需重新绑定才会生效
+        virtual void setCorridor(const Route &route, float width) = 0;
+
+        // 当前走廊内的要素数, 未开启走廊模式时为0
+        [[nodiscard]] virtual size_t corridorFeatureCount() const = 0;
+
+        // 按要素顶点的ENU高度把要素聚成楼层(高度直方图找峰), 首次调用时解码全部图层. 没有要素时为空
+        [[nodiscard]] virtual std::vector<Floor> getFloors() const = 0;
+
+        // 要素所在的楼层区间[first, last], 坡道/HILL等跨层要素first < last; 要素不存在时返回false
+        virtual bool getFeatureFloors(SpatialLayer layer, uint32_t id, int &first, int &last) const = 0;
+
+        // buffer(由layer对应的bind*Data绑定)只绘制与楼层区间[first, last]相交的要素, first > last时恢复全部.
+        // 重新绑定后需再次设置
+        virtual void setFloorFilter(SpatialLayer layer, int first, int last, LayerBuffer &buffer) const = 0;
     };
 };
 
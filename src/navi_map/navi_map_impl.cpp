@@ -2,14 +2,48 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "utils/sql_util.h"
+#include "utils/style_palette.h"
+#include "utils/triangulator.h"
+#include "floor_clustering.h"
 #include <iostream>
+#include <algorithm>
+#include <limits>
 
 namespace navi_map {
-    std::shared_ptr<NaviMap> NaviMap::createNaviMap(const std::string &db_path, int partition_id, BlobType blob_type) {
-        return std::make_shared<NaviMapImpl>(db_path, partition_id, blob_type);
+    // 走廊的竖直容差, 小于层高, 只选中路线所在楼层的要素
+    constexpr float kCorridorHeight = 2.0f;
+    // 并排车位之间允许的间隙和高差, 背靠背或隔着通道的车位不合并
+    constexpr float kParkingRowGap = 0.5f;
+    constexpr float kParkingRowMaxDz = 1.0f;
+
+    // 排的缓存文件名带上聚类参数, 参数调整后不会读到旧的聚类结果
+    std::string parkingRowsCacheName(const std::string &layer) {
+        float params[] = {kParkingRowGap, kParkingRowMaxDz};
+        return layer + "_" + std::to_string(static_cast<uint32_t>(fnv1a64(params, sizeof(params))));
     }
 
-    NaviMapImpl::NaviMapImpl(const std::string &db_path, int partition_id, BlobType blob_type) {
+    uint64_t featureKey(uint32_t layer, uint32_t id) {
+        return static_cast<uint64_t>(layer) << 32 | id;
+    }
+
+    // 三角化后的多边形按索引三角形绘制, 与其他多边形合批; 一个点的要素画点, 不足三个有效点的画线
+    void addPolygon(LayerData &layer, uint32_t id, const std::vector<float> &points,
+                    const std::vector<uint32_t> &triangles, uint16_t style_key) {
+        size_t count = points.size() / 3;
+        if (!triangles.empty()) {
+            layer.addFeature(id, GL_TRIANGLES, points, style_key, triangles);
+        } else {
+            layer.addFeature(id, count == 1 ? GL_POINTS : (count == 2 ? GL_LINES : GL_LINE_STRIP), points, style_key);
+        }
+    }
+
+    std::shared_ptr<NaviMap> NaviMap::createNaviMap(const std::string &db_path, int partition_id, BlobType blob_type,
+                                                    bool low_memory) {
+        return std::make_shared<NaviMapImpl>(db_path, partition_id, blob_type, low_memory);
+    }
+
+    NaviMapImpl::NaviMapImpl(const std::string &db_path, int partition_id, BlobType blob_type, bool low_memory)
+            : db_path_(db_path), partition_id_(partition_id), low_memory_(low_memory) {
         auto ref_point_str = query_for_column(db_path, partition_id, "ref_point");
         auto ref_point_wgs84 = getPoint(ref_point_str);
         auto ref_point_gcj02 = wgs84_to_gcj02(ref_point_wgs84[0], ref_point_wgs84[1]);
@@ -29,11 +63,133 @@ namespace navi_map {
         std::cout << "end:(" << end_point_[0] << "," << end_point_[1] << "," << end_point_[2] << ")" << std::endl;
 
 
-        if (blob_type == BlobType::NAVI) {
-            road_tile_ = query_for_road_tile(db_path, partition_id, "blob_data");
-        } else {
-            road_tile_ = query_for_road_tile(db_path, partition_id, "road_mark");
+        // 两种blob_type目前都读取blob_data, 与query_for_road_tile一致.
+        // 只保留内容哈希作缓存键, blob在首次解码时再读取, 图层全部命中缓存时不常驻内存
+        auto blob = query_for_blob(db_path, partition_id);
+        cache_key_ = fnv1a64(blob.data(), blob.size());
+        cache_key_ = fnv1a64(ref_point_str.data(), ref_point_str.size(), cache_key_);
+        uint32_t salt[] = {static_cast<uint32_t>(blob_type), GeometryCache::kFormatVersion};
+        cache_key_ = fnv1a64(salt, sizeof(salt), cache_key_);
+
+        cache_ = std::make_unique<GeometryCache>(db_path);
+        cache_->bindPartition(std::to_string(partition_id) + (blob_type == BlobType::NAVI ? ".navi" : ".loc"),
+                              cache_key_);
+    }
+
+    const DecodedRoadTile &NaviMapImpl::tile(uint32_t layers) const {
+        // 低内存模式一次解码全部图层, 以便立即释放blob
+        uint32_t missing = (low_memory_ ? TILE_ALL_LAYERS : layers) & ~decoded_;
+        if (missing == 0) {
+            return tile_;
         }
+        if (blob_.empty()) {
+            blob_ = query_for_blob(db_path_, partition_id_);
+        }
+        // 只解码渲染用到的字段; 解码失败时退回完整解析, 由protobuf给出错误
+        if (!decode_road_tile(blob_.data(), blob_.size(), tile_, missing)) {
+            hdmap::data::proto::RoadTile road_tile;
+            if (!road_tile.ParseFromString(blob_)) {
+                throw std::runtime_error("Failed to parse the BLOB data into a proto object.");
+            }
+            decode_road_tile(road_tile, tile_);
+            missing = TILE_ALL_LAYERS & ~decoded_;
+        }
+        decoded_ |= missing;
+        if (decoded_ == TILE_ALL_LAYERS) {
+            blob_.clear();
+            blob_.shrink_to_fit();
+        }
+        updateFastMode();
+
+        if (low_memory_) {
+            compact_ = std::make_unique<CompactTile>(CompactTile::build(tile_, *trans_util_));
+            tile_ = DecodedRoadTile{};
+        }
+        return tile_;
+    }
+
+    void NaviMapImpl::updateFastMode() const {
+        // 地库范围通常只有一两公里, 在已解码图层的包围盒内用多项式近似ENU转换, 误差超过1mm时保持精确计算.
+        // 后解码的图层超出原包围盒时按合并后的范围重新拟合
+        std::array<double, 3> min_lla = fast_min_, max_lla = fast_max_;
+        if (!trans_util_->fastMode()) {
+            min_lla = {1e9, 1e9, 1e9};
+            max_lla = {-1e9, -1e9, -1e9};
+        }
+        for (const auto *layer : {&tile_.roads, &tile_.pois, &tile_.road_marks, &tile_.road_obstacles,
+                                  &tile_.parking_spaces}) {
+            for (size_t i = 0; i < layer->points.size(); i += 3) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    min_lla[axis] = std::min(min_lla[axis], layer->points[i + axis]);
+                    max_lla[axis] = std::max(max_lla[axis], layer->points[i + axis]);
+                }
+            }
+        }
+        if (min_lla[0] > max_lla[0] || (trans_util_->fastMode() && min_lla == fast_min_ && max_lla == fast_max_)) {
+            return;
+        }
+        if (trans_util_->enableFastMode(min_lla, max_lla)) {
+            fast_min_ = min_lla;
+            fast_max_ = max_lla;
+        }
+    }
+
+    template<typename Fn>
+    void NaviMapImpl::forEachFeature(uint32_t layer_bit, TileLayer DecodedRoadTile::*source,
+                                     CompactLayer CompactTile::*compact, Fn &&fn) const {
+        tile(layer_bit);
+        if (compact_) {
+            const auto &layer = (*compact_).*compact;
+            for (size_t i = 0; i < layer.size(); ++i) {
+                fn(i, layer.ids[i], layer.types[i], layer.featurePoints(i));
+            }
+            return;
+        }
+        const auto &layer = tile_.*source;
+        for (size_t i = 0; i < layer.size(); ++i) {
+            fn(i, layer.ids[i], layer.types[i], toENU(layer, i));
+        }
+    }
+
+    std::vector<float> NaviMapImpl::toENU(const TileLayer &layer, size_t i) const {
+        std::vector<float> points;
+        points.reserve(layer.pointCount(i) * 3);
+        const double *p = layer.point(i);
+        for (uint32_t j = 0; j < layer.pointCount(i); ++j, p += 3) {
+            auto enu = trans_util_->transToENU(p[0], p[1], p[2]);
+            points.push_back(enu[0]);
+            points.push_back(enu[1]);
+            points.push_back(enu[2]);
+        }
+        return points;
+    }
+
+    LayerData NaviMapImpl::loadLayer(const std::string &name, LayerBuilder build) const {
+        if (corridor_) {
+            return (this->*build)();
+        }
+        auto mapped = cache_->open(cache_key_, name);
+        if (mapped) {
+            return LayerData::fromView(mapped->view());
+        }
+        auto layer = (this->*build)();
+        cache_->store(cache_key_, name, layer);
+        return layer;
+    }
+
+    void NaviMapImpl::bindLayer(const std::string &name, LayerBuilder build, LayerBuffer &buffer) const {
+        if (corridor_) {
+            buffer.upload((this->*build)());
+            return;
+        }
+        auto mapped = cache_->open(cache_key_, name);
+        if (mapped) {
+            buffer.upload(mapped->view());
+            return;
+        }
+        auto layer = (this->*build)();
+        cache_->store(cache_key_, name, layer);
+        buffer.upload(layer);
     }
 
     std::array<double, 3> NaviMapImpl::getStartPoint() const {
@@ -46,312 +202,530 @@ namespace navi_map {
 
     std::vector<Road> NaviMapImpl::getRoads() const {
         std::vector<Road> roads;
-        for (size_t i = 0; i < road_tile_.road_size(); ++i) {
-            roads.push_back({});
-            auto road = road_tile_.road(i);
-            roads.back().id = road.id().count();
-            roads.back().length = road.length();
-            const auto &road_center = road.road_center();
-            for (size_t j = 0; j < road_center.points_size(); j++) {
-                auto p = trans_util_->transToENU(
-                        road_center.points(j).longitude(),
-                        road_center.points(j).latitude(),
-                        road_center.points(j).altitude());
-                roads.back().road_center.push_back(p[0]);
-                roads.back().road_center.push_back(p[1]);
-                roads.back().road_center.push_back(p[2]);
+        forEachFeature(TILE_ROADS, &DecodedRoadTile::roads, &CompactTile::roads,
+                       [&](size_t i, uint32_t id, uint32_t, std::vector<float> points) {
+                           float length = compact_ ? compact_->road_lengths[i] : tile_.road_lengths[i];
+                           roads.push_back({id, length, std::move(points)});
+                       });
+        return roads;
+    }
+
+    LayerData NaviMapImpl::buildRoadsLayer() const {
+        LayerData layer;
+        for (const auto &road : getRoads()) {
+            if (!inCorridor(SPATIAL_ROADS, road.id)) {
+                continue;
             }
+            layer.addFeature(road.id, GL_LINES, road.road_center, style::key(style::ROAD));
         }
-        return roads;
+        return layer;
     }
 
-    std::vector<unsigned int> NaviMapImpl::bindRoadsData(
-            const std::vector<unsigned int> &VAOs,
-            const std::vector<unsigned int> &vertexVBOs,
-            const std::vector<unsigned int> &colorVBOs) {
+    LayerData NaviMapImpl::getRoadsLayer() const {
+        return loadLayer("roads", &NaviMapImpl::buildRoadsLayer);
+    }
 
-        std::vector<float> color = {
-                0.0f, 0.7f, 1.0f, 1.0f,
-        };
+    void NaviMapImpl::bindRoadsData(LayerBuffer &roads) {
+        bindLayer("roads", &NaviMapImpl::buildRoadsLayer, roads);
+    }
+
+
+    std::vector<POI> NaviMapImpl::getPOI() const {
+        std::vector<POI> pois;
+        forEachFeature(TILE_POIS, &DecodedRoadTile::pois, &CompactTile::pois,
+                       [&](size_t, uint32_t id, uint32_t type, std::vector<float> points) {
+                           pois.push_back({id, static_cast<POI::POIType>(type), std::move(points)});
+                       });
+        return pois;
+    }
+
+    LayerData NaviMapImpl::buildPoiLayer() const {
+        std::vector<POI> pois;
+        std::vector<const std::vector<float> *> polygons;
+        for (auto &poi : getPOI()) {
+            if (inCorridor(SPATIAL_POIS, poi.id)) {
+                pois.push_back(std::move(poi));
+            }
+        }
+        for (const auto &poi : pois) {
+            polygons.push_back(&poi.points);
+        }
+        auto triangles = triangulate_polygons(polygons);
+        LayerData layer;
+        for (size_t i = 0; i < pois.size(); ++i) {
+            addPolygon(layer, pois[i].id, pois[i].points, triangles[i],
+                       style::key(style::typed(style::POI_BASE, pois[i].poi_type, style::POI_SLOTS)));
+        }
+        return layer;
+    }
 
-        std::vector<unsigned int> roadPointNums{};
-        std::vector<Road> roads = getRoads();
-        for (size_t i = 0; i < roads.size(); ++i) {
-            auto point_num = roads[i].road_center.size() / 3;
-            roadPointNums.push_back(point_num);
+    LayerData NaviMapImpl::getPoiLayer() const {
+        return loadLayer("pois", &NaviMapImpl::buildPoiLayer);
+    }
 
-            glBindVertexArray(VAOs[i]);
+    void NaviMapImpl::bindPoiData(LayerBuffer &pois) {
+        bindLayer("pois", &NaviMapImpl::buildPoiLayer, pois);
+    }
 
-            glBindBuffer(GL_ARRAY_BUFFER, vertexVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, roads[i].road_center.size() * sizeof(float), roads[i].road_center.data(),
-                         GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(0);
+    std::vector<RoadMark> NaviMapImpl::getRoadMark() const {
+        std::vector<RoadMark> road_marks;
+        forEachFeature(TILE_ROAD_MARKS, &DecodedRoadTile::road_marks, &CompactTile::road_marks,
+                       [&](size_t, uint32_t id, uint32_t type, std::vector<float> points) {
+                           road_marks.push_back({id, static_cast<RoadMark::RoadMarkType>(type), std::move(points)});
+                       });
+        return road_marks;
+    }
 
-            std::vector<float> colors;
-            for (size_t n = 0; n < point_num; n++) {
-                colors.insert(colors.end(), color.begin(), color.end());
+    LayerData NaviMapImpl::buildRoadMarkLayer() const {
+        // 路面标识只画前两个点连成的线段, 与原先glDrawArrays(GL_LINES, 0, 2)一致
+        std::vector<unsigned int> indices = {0, 1};
+        LayerData layer;
+        for (const auto &road_mark : getRoadMark()) {
+            if (!inCorridor(SPATIAL_ROAD_MARKS, road_mark.id) || road_mark.points.size() < 6) {
+                continue;
             }
-            glBindBuffer(GL_ARRAY_BUFFER, colorVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(1);
+            layer.addFeature(road_mark.id, GL_LINES, road_mark.points,
+                             style::key(style::typed(style::ROAD_MARK_BASE, road_mark.type, style::ROAD_MARK_SLOTS)),
+                             indices);
+        }
+        return layer;
+    }
+
+    LayerData NaviMapImpl::getRoadMarkLayer() const {
+        return loadLayer("road_marks", &NaviMapImpl::buildRoadMarkLayer);
+    }
+
+    void NaviMapImpl::bindRoadMarkData(LayerBuffer &roadMarks) {
+        bindLayer("road_marks", &NaviMapImpl::buildRoadMarkLayer, roadMarks);
+    }
+
+    std::vector<RoadObstacle> NaviMapImpl::getRoadObstacle() const {
+        std::vector<RoadObstacle> road_obstacles;
+        forEachFeature(TILE_ROAD_OBSTACLES, &DecodedRoadTile::road_obstacles, &CompactTile::road_obstacles,
+                       [&](size_t, uint32_t id, uint32_t type, std::vector<float> points) {
+                           road_obstacles.push_back(
+                                   {id, static_cast<RoadObstacle::RoadObstacleType>(type), std::move(points)});
+                       });
+        return road_obstacles;
+    }
 
-            glBindVertexArray(0);  // reset
+    LayerData NaviMapImpl::buildRoadObstacleLayer() const {
+        std::vector<RoadObstacle> obstacles;
+        std::vector<const std::vector<float> *> polygons;
+        for (auto &obstacle : getRoadObstacle()) {
+            if (inCorridor(SPATIAL_ROAD_OBSTACLES, obstacle.id)) {
+                obstacles.push_back(std::move(obstacle));
+            }
+        }
+        for (const auto &obstacle : obstacles) {
+            polygons.push_back(&obstacle.points);
         }
-        return roadPointNums;
+        auto triangles = triangulate_polygons(polygons);
+        LayerData layer;
+        for (size_t i = 0; i < obstacles.size(); ++i) {
+            addPolygon(layer, obstacles[i].id, obstacles[i].points, triangles[i],
+                       style::key(style::typed(style::ROAD_OBSTACLE_BASE, obstacles[i].type,
+                                               style::ROAD_OBSTACLE_SLOTS)));
+        }
+        return layer;
     }
 
+    LayerData NaviMapImpl::getRoadObstacleLayer() const {
+        return loadLayer("road_obstacles", &NaviMapImpl::buildRoadObstacleLayer);
+    }
 
-    std::vector<POI> NaviMapImpl::getPOI() const {
-        std::vector<POI> pois;
-        for (size_t i = 0; i < road_tile_.poi_size(); ++i) {
-            pois.push_back({});
-            auto poi = road_tile_.poi(i);
-            pois.back().id = poi.id().count();
-            pois.back().poi_type = static_cast<POI::POIType>(poi.poi_type());
-            for (size_t j = 0; j < poi.shape_size(); j++) {
-                auto p = trans_util_->transToENU(poi.shape(j).longitude(), poi.shape(j).latitude(),
-                                                 poi.shape(j).altitude());
-                pois.back().points.push_back(p[0]);
-                pois.back().points.push_back(p[1]);
-                pois.back().points.push_back(p[2]);
+    void NaviMapImpl::bindRoadObstacleData(LayerBuffer &roadObstacles) {
+        bindLayer("road_obstacles", &NaviMapImpl::buildRoadObstacleLayer, roadObstacles);
+    }
+
+    std::vector<ParkingSpace> NaviMapImpl::getParkingSpaces() const {
+        std::vector<ParkingSpace> parking_spaces;
+        forEachFeature(TILE_PARKING_SPACES, &DecodedRoadTile::parking_spaces, &CompactTile::parking_spaces,
+                       [&](size_t, uint32_t id, uint32_t, std::vector<float> points) {
+                           parking_spaces.push_back({id, std::move(points)});
+                       });
+        return parking_spaces;
+    }
+
+    bool NaviMapImpl::getParkingSpace(uint32_t id, ParkingSpace &psd) const {
+        tile(TILE_PARKING_SPACES);
+        if (compact_) {
+            int i = compact_->parking_spaces.find(id);
+            if (i < 0) {
+                return false;
             }
+            psd = {id, compact_->parking_spaces.featurePoints(i)};
+            return true;
         }
-        return pois;
+        const auto &layer = tile_.parking_spaces;
+        auto it = std::find(layer.ids.begin(), layer.ids.end(), id);
+        if (it == layer.ids.end()) {
+            return false;
+        }
+        psd = {id, toENU(layer, it - layer.ids.begin())};
+        return true;
     }
 
-    std::vector<unsigned int> NaviMapImpl::bindPoiData(const std::vector<unsigned int> &VAOs,
-                                                       const std::vector<unsigned int> &vertexVBOs,
-                                                       const std::vector<unsigned int> &colorVBOs) {
-
-        std::vector<float> color = {1.0f, 1.0f, 1.0f, 1.0f,};
-        std::vector<float> entrance_color = {1.0f, 0.27f, 0.0f, 1.0f,};
-        std::vector<float> check_point_color = {0.0f, 0.5f, 0.0f, 1.0f,};
-        std::vector<float> hill_color = {1.0f, 0.5f, 0.3f, 1.0f,};
-        std::vector<float> intersection_color = {0.0f, 1.0f, 0.5f, 1.0f,};
-
-        std::vector<unsigned int> poiPointNums{};
-        auto poi = getPOI();
-        for (size_t i = 0; i < poi.size(); i++) {
-            glBindVertexArray(VAOs[i]);
-
-            glBindBuffer(GL_ARRAY_BUFFER, vertexVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, poi[i].points.size() * sizeof(float), poi[i].points.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(0);
-
-            auto point_num = poi[i].points.size() / 3;
-            poiPointNums.push_back(point_num);
-            std::vector<float> colors;
-            if (poi[i].poi_type == POI::GARAGE_ENTRANCE) {
-                for (size_t n = 0; n < point_num; n++) {
-                    colors.insert(colors.end(), entrance_color.begin(), entrance_color.end());
-                }
-            } else if (poi[i].poi_type == POI::CHECK_POINT) {
-                for (size_t n = 0; n < point_num; n++) {
-                    colors.insert(colors.end(), check_point_color.begin(), check_point_color.end());
-                }
-            } else if (poi[i].poi_type == POI::HILL) {
-                for (size_t n = 0; n < point_num; n++) {
-                    colors.insert(colors.end(), hill_color.begin(), hill_color.end());
-                }
-            } else {
-                for (size_t n = 0; n < point_num; n++) {
-                    colors.insert(colors.end(), color.begin(), color.end());
-                }
+    LayerData NaviMapImpl::buildPsdsLayer() const {
+        std::vector<unsigned int> indices = {
+                0, 1, 2, 2, 3, 0,
+        };
+
+        LayerData layer;
+        // 目标车位不写入缓存, 由get/bind再叠加高亮状态
+        for (const auto &psd : getParkingSpaces()) {
+            // indices需要四个角点
+            if (!inCorridor(SPATIAL_PARKING_SPACES, psd.id) || psd.points.size() < 12) {
+                continue;
             }
-            glBindBuffer(GL_ARRAY_BUFFER, colorVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(1);
+            // 前两个点为入口边, 其余为底边
+            std::vector<uint16_t> styles(psd.points.size() / 3, style::key(style::PSD_REAR));
+            styles[0] = styles[1] = style::key(style::PSD_ENTRY);
+            layer.addFeature(psd.id, GL_TRIANGLES, psd.points, styles, indices);
+        }
+        return layer;
+    }
 
-            glBindVertexArray(0);  // reset
+    LayerData NaviMapImpl::getPsdsLayer() const {
+        auto layer = loadLayer("psds", &NaviMapImpl::buildPsdsLayer);
+        for (const auto &range : layer.ranges) {
+            if (range.id != static_cast<uint32_t>(target_prk_space_id_)) {
+                continue;
+            }
+            for (uint32_t i = range.first; i < range.first + range.count; ++i) {
+                layer.styles[i] = style::key(layer.styles[i] & 0xFFu, style::HIGHLIGHT);
+            }
         }
-        return poiPointNums;
+        return layer;
     }
 
-    std::vector<RoadMark> NaviMapImpl::getRoadMark() const {
-        std::vector<RoadMark> road_marks;
-        for (size_t i = 0; i < road_tile_.road_mark_size(); ++i) {
-            road_marks.push_back({});
-            auto road_mark = road_tile_.road_mark(i);
-            road_marks.back().id = road_mark.id().count();
-            road_marks.back().type = static_cast<RoadMark::RoadMarkType>(road_mark.type());
-            for (size_t j = 0; j < road_mark.shape_size(); j++) {
-                auto p = trans_util_->transToENU(
-                        road_mark.shape(j).longitude(),
-                        road_mark.shape(j).latitude(),
-                        road_mark.shape(j).altitude());
-                road_marks.back().points.push_back(p[0]);
-                road_marks.back().points.push_back(p[1]);
-                road_marks.back().points.push_back(p[2]);
+    void NaviMapImpl::bindPsdsData(LayerBuffer &psds) {
+        bindLayer("psds", &NaviMapImpl::buildPsdsLayer, psds);
+        psds.setFeatureState(target_prk_space_id_, style::HIGHLIGHT);
+    }
+
+    std::vector<FootprintCluster> NaviMapImpl::getParkingRows() const {
+        if (parking_rows_built_) {
+            return parking_rows_;
+        }
+        if (!corridor_ && openParkingRows()) {
+            parking_rows_built_ = true;
+            return parking_rows_;
+        }
+        auto spaces = getParkingSpaces();
+        spaces.erase(std::remove_if(spaces.begin(), spaces.end(), [&](const ParkingSpace &psd) {
+            return !inCorridor(SPATIAL_PARKING_SPACES, psd.id);
+        }), spaces.end());
+        std::vector<const std::vector<float> *> polygons;
+        for (const auto &psd : spaces) {
+            polygons.push_back(&psd.points);
+        }
+        parking_rows_ = cluster_footprints(polygons, kParkingRowGap, kParkingRowMaxDz);
+        for (auto &row : parking_rows_) {
+            for (auto &member : row.members) {
+                member = spaces[member].id;
+            }
+        }
+        parking_rows_built_ = true;
+        if (!corridor_) {
+            // 成员id记在各要素的indices中, 不带顶点
+            LayerData members;
+            for (uint32_t i = 0; i < parking_rows_.size(); ++i) {
+                FeatureRange range;
+                range.id = i;
+                range.mode = GL_POINTS;
+                range.firstIndex = static_cast<uint32_t>(members.indices.size());
+                range.indexCount = static_cast<uint32_t>(parking_rows_[i].members.size());
+                members.indices.insert(members.indices.end(), parking_rows_[i].members.begin(),
+                                       parking_rows_[i].members.end());
+                members.ranges.push_back(range);
             }
+            cache_->store(cache_key_, parkingRowsCacheName("parking_row_members"), members);
         }
+        return parking_rows_;
+    }
 
-        return road_marks;
+    bool NaviMapImpl::openParkingRows() const {
+        auto footprints = cache_->open(cache_key_, parkingRowsCacheName("parking_rows"));
+        auto members = cache_->open(cache_key_, parkingRowsCacheName("parking_row_members"));
+        if (!footprints || !members || footprints->view().rangeCount != members->view().rangeCount) {
+            return false;
+        }
+        const auto &footprint_view = footprints->view();
+        const auto &member_view = members->view();
+        parking_rows_.assign(footprint_view.rangeCount, FootprintCluster{});
+        for (size_t i = 0; i < parking_rows_.size(); ++i) {
+            const auto &outline = footprint_view.ranges[i];
+            const auto &row = member_view.ranges[i];
+            parking_rows_[i].footprint.assign(footprint_view.vertices + outline.first * 3,
+                                              footprint_view.vertices + (outline.first + outline.count) * 3);
+            parking_rows_[i].members.assign(member_view.indices + row.firstIndex,
+                                            member_view.indices + row.firstIndex + row.indexCount);
+            fit_cluster_bounds(parking_rows_[i]);
+        }
+        return true;
     }
 
-    void
-    NaviMapImpl::bindRoadMarkData(const std::vector<unsigned int> &VAOs, const std::vector<unsigned int> &vertexVBOs,
-                                  const std::vector<unsigned int> &colorVBOs) {
-        std::vector<float> colors = {
-                1.0f, 0.83f, 0.01f, 1.0f,
-                1.0f, 0.83f, 0.01f, 1.0f,
-        };
-        auto roadMark = getRoadMark();
-        for (size_t i = 0; i < roadMark.size(); i++) {
-            glBindVertexArray(VAOs[i]);
+    LayerData NaviMapImpl::buildParkingRowsLayer() const {
+        LayerData layer;
+        auto rows = getParkingRows();
+        for (uint32_t i = 0; i < rows.size(); ++i) {
+            // 凸包按扇形三角化
+            std::vector<uint32_t> indices;
+            for (uint32_t k = 1; k + 1 < rows[i].footprint.size() / 3; ++k) {
+                indices.insert(indices.end(), {0, k, k + 1});
+            }
+            addPolygon(layer, i, rows[i].footprint, indices, style::key(style::PARKING_ROW));
+        }
+        return layer;
+    }
 
-            glBindBuffer(GL_ARRAY_BUFFER, vertexVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, roadMark[i].points.size() * sizeof(float), roadMark[i].points.data(),
-                         GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(0);
+    LayerData NaviMapImpl::getParkingRowsLayer() const {
+        return loadLayer(parkingRowsCacheName("parking_rows"), &NaviMapImpl::buildParkingRowsLayer);
+    }
 
-            glBindBuffer(GL_ARRAY_BUFFER, colorVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(1);
+    void NaviMapImpl::bindParkingRowsData(LayerBuffer &rows) {
+        bindLayer(parkingRowsCacheName("parking_rows"), &NaviMapImpl::buildParkingRowsLayer, rows);
+    }
 
-            glBindVertexArray(0);
+    size_t NaviMapImpl::residentBytes() const {
+        size_t bytes = blob_.capacity();
+        for (const auto *layer : {&tile_.roads, &tile_.pois, &tile_.road_marks, &tile_.road_obstacles,
+                                  &tile_.parking_spaces}) {
+            bytes += (layer->ids.capacity() + layer->types.capacity() + layer->offsets.capacity()) * sizeof(uint32_t) +
+                     layer->points.capacity() * sizeof(double);
+        }
+        bytes += tile_.road_lengths.capacity() * sizeof(float) +
+                 (tile_.road_heads.capacity() + tile_.road_tails.capacity()) * sizeof(uint32_t) +
+                 tile_.road_directions.capacity();
+        if (compact_) {
+            bytes += compact_->byteSize();
         }
+        if (spatial_) {
+            bytes += spatial_->byteSize();
+        }
+        if (graph_) {
+            bytes += graph_->byteSize();
+        }
+        return bytes;
     }
 
-    std::vector<RoadObstacle> NaviMapImpl::getRoadObstacle() const {
-        std::vector<RoadObstacle> road_obstacles;
-        for (size_t i = 0; i < road_tile_.road_obstacle_size(); ++i) {
-            road_obstacles.push_back({});
-            auto obstacle = road_tile_.road_obstacle(i);
-            road_obstacles.back().id = obstacle.id().count();
-            road_obstacles.back().type = static_cast<RoadObstacle::RoadObstacleType>(obstacle.type());
-            for (size_t j = 0; j < obstacle.shape_size(); j++) {
-                auto p = trans_util_->transToENU(
-                        obstacle.shape(j).longitude(),
-                        obstacle.shape(j).latitude(),
-                        obstacle.shape(j).altitude());
-                road_obstacles.back().points.push_back(p[0]);
-                road_obstacles.back().points.push_back(p[1]);
-                road_obstacles.back().points.push_back(p[2]);
-            }
+    const SpatialIndex &NaviMapImpl::spatialIndex() const {
+        if (spatial_) {
+            return *spatial_;
         }
+        spatial_ = std::make_unique<SpatialIndex>();
+        auto add = [this](SpatialLayer layer, SpatialIndex::Shape shape) {
+            return [this, layer, shape](size_t, uint32_t id, uint32_t, const std::vector<float> &points) {
+                size_t count = points.size() / 3;
+                // 与绘制一致: 一个点的POI为点, 两个点的POI/障碍物为线段
+                auto actual = count == 1 ? SpatialIndex::POINTS : (count == 2 ? SpatialIndex::POLYLINE : shape);
+                spatial_->add(layer, 0, id, actual, points.data(), count);
+            };
+        };
+        forEachFeature(TILE_ROADS, &DecodedRoadTile::roads, &CompactTile::roads,
+                       add(SPATIAL_ROADS, SpatialIndex::POLYLINE));
+        forEachFeature(TILE_POIS, &DecodedRoadTile::pois, &CompactTile::pois,
+                       add(SPATIAL_POIS, SpatialIndex::POLYGON));
+        forEachFeature(TILE_ROAD_MARKS, &DecodedRoadTile::road_marks, &CompactTile::road_marks,
+                       add(SPATIAL_ROAD_MARKS, SpatialIndex::POLYLINE));
+        forEachFeature(TILE_ROAD_OBSTACLES, &DecodedRoadTile::road_obstacles, &CompactTile::road_obstacles,
+                       add(SPATIAL_ROAD_OBSTACLES, SpatialIndex::POLYGON));
+        forEachFeature(TILE_PARKING_SPACES, &DecodedRoadTile::parking_spaces, &CompactTile::parking_spaces,
+                       add(SPATIAL_PARKING_SPACES, SpatialIndex::POLYGON));
+        spatial_->build();
+        return *spatial_;
+    }
 
-        return road_obstacles;
+    std::vector<SpatialHit> NaviMapImpl::queryBox(const std::array<float, 3> &min, const std::array<float, 3> &max,
+                                                  uint32_t layers) const {
+        return spatialIndex().queryBox(min, max, layers);
     }
 
-    std::vector<unsigned int> NaviMapImpl::bindRoadObstacleData(const std::vector<unsigned int> &VAOs,
-                                                                const std::vector<unsigned int> &vertexVBOs,
-                                                                const std::vector<unsigned int> &colorVBOs) {
+    std::vector<SpatialHit> NaviMapImpl::queryRadius(const std::array<float, 3> &center, float radius,
+                                                     uint32_t layers) const {
+        return spatialIndex().queryRadius(center, radius, layers);
+    }
 
-        std::vector<float> color = {1.0f, 1.0f, 1.0f, 1.0f,};
-        std::vector<float> pillar_color = {1.0f, 0.56f, 0.0f, 1.0f,};
-        std::vector<float> wall_color = {0.65f, 0.16f, 0.16f, 1.0f,};
+    std::vector<SpatialHit> NaviMapImpl::nearestK(const std::array<float, 3> &point, size_t k,
+                                                  uint32_t layers) const {
+        return spatialIndex().nearestK(point, k, layers);
+    }
 
-        std::vector<unsigned int> roadObstaclePointNums{};
-        auto road_obstacle = getRoadObstacle();
-        for (size_t i = 0; i < road_obstacle.size(); i++) {
-            glBindVertexArray(VAOs[i]);
+    std::vector<SpatialHit> NaviMapImpl::raycast(const std::array<float, 3> &origin,
+                                                 const std::array<float, 3> &direction, float tolerance,
+                                                 uint32_t layers) const {
+        return spatialIndex().raycast(origin, direction, tolerance, layers);
+    }
 
-            glBindBuffer(GL_ARRAY_BUFFER, vertexVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, road_obstacle[i].points.size() * sizeof(float),
-                         road_obstacle[i].points.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(0);
+    const RoadGraph &NaviMapImpl::roadGraph() const {
+        if (graph_) {
+            return *graph_;
+        }
+        std::vector<uint32_t> offsets{0};
+        std::vector<float> points;
+        forEachFeature(TILE_ROADS, &DecodedRoadTile::roads, &CompactTile::roads,
+                       [&](size_t, uint32_t, uint32_t, const std::vector<float> &road) {
+                           points.insert(points.end(), road.begin(), road.end());
+                           offsets.push_back(static_cast<uint32_t>(points.size() / 3));
+                       });
+        if (compact_) {
+            graph_ = std::make_unique<RoadGraph>(RoadGraph::build(compact_->road_heads, compact_->road_tails,
+                                                                  compact_->road_directions, offsets, points));
+        } else {
+            graph_ = std::make_unique<RoadGraph>(RoadGraph::build(tile_.road_heads, tile_.road_tails,
+                                                                  tile_.road_directions, offsets, points));
+        }
+        return *graph_;
+    }
 
-            auto point_num = road_obstacle[i].points.size() / 3;
-            roadObstaclePointNums.push_back(point_num);
-            std::vector<float> colors;
-            if (road_obstacle[i].type == RoadObstacle::RoadObstacleType::PILLAR) {
-                for (size_t n = 0; n < point_num; n++) {
-                    colors.insert(colors.end(), pillar_color.begin(), pillar_color.end());
-                }
-            } else if (road_obstacle[i].type == RoadObstacle::RoadObstacleType::WALL) {
-                for (size_t n = 0; n < point_num; n++) {
-                    colors.insert(colors.end(), wall_color.begin(), wall_color.end());
-                }
-            } else {
-                for (size_t n = 0; n < point_num; n++) {
-                    colors.insert(colors.end(), color.begin(), color.end());
-                }
-            }
-            glBindBuffer(GL_ARRAY_BUFFER, colorVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(1);
+    Route NaviMapImpl::findRoute(const std::array<float, 3> &from, const std::array<float, 3> &to) const {
+        auto path = roadGraph().route(from.data(), to.data());
+        Route route;
+        if (!path.found) {
+            return route;
+        }
+        const auto &ids = compact_ ? compact_->roads.ids : tile_.roads.ids;
+        route.found = true;
+        route.length = path.length;
+        for (auto road : path.roads) {
+            route.road_ids.push_back(ids[road]);
+        }
+        route.points.assign(from.begin(), from.end());
+        route.points.insert(route.points.end(), path.points.begin(), path.points.end());
+        route.points.insert(route.points.end(), to.begin(), to.end());
+        return route;
+    }
 
-            glBindVertexArray(0);  // reset
+    Route NaviMapImpl::findRouteToParkingSpace(const std::array<float, 3> &from, uint32_t parking_space_id) const {
+        ParkingSpace psd;
+        if (!getParkingSpace(parking_space_id, psd) || psd.points.size() < 6) {
+            return {};
         }
-        return roadObstaclePointNums;
+        const auto &p = psd.points;
+        return findRoute(from, {(p[0] + p[3]) / 2, (p[1] + p[4]) / 2, (p[2] + p[5]) / 2});
     }
 
-    std::vector<ParkingSpace> NaviMapImpl::getParkingSpaces() const {
-        std::vector<ParkingSpace> parking_spaces;
-        for (size_t i = 0; i < road_tile_.parking_space_size(); ++i) {
-            parking_spaces.push_back({});
-            auto pks = road_tile_.parking_space(i);
-            parking_spaces.back().id = pks.id().count();
-
-            for (size_t j = 0; j < pks.shape_size(); ++j) {
-                auto p = trans_util_->transToENU(
-                        pks.shape(j).longitude(),
-                        pks.shape(j).latitude(),
-                        pks.shape(j).altitude());
-//                std::cout << p[0] << "," << p[1] << "," << p[2] << std::endl;
-                parking_spaces.back().points.push_back(p[0]);
-                parking_spaces.back().points.push_back(p[1]);
-                parking_spaces.back().points.push_back(p[2]);
-            }
+    LayerData NaviMapImpl::getRouteLayer(const Route &route) const {
+        LayerData layer;
+        if (!route.found) {
+            return layer;
         }
+        // 略高于路面, 避免与道路中心线深度冲突
+        auto points = route.points;
+        for (size_t i = 2; i < points.size(); i += 3) {
+            points[i] += 0.1f;
+        }
+        layer.addFeature(0, GL_LINE_STRIP, points, style::key(style::ROUTE));
+        return layer;
+    }
 
-        return parking_spaces;
+    void NaviMapImpl::bindRouteData(const Route &route, LayerBuffer &buffer) {
+        buffer.upload(getRouteLayer(route));
+    }
+
+    void NaviMapImpl::setCorridor(const Route &route, float width) {
+        corridor_ids_.clear();
+        corridor_ = route.found && !route.points.empty();
+        parking_rows_built_ = false;
+        if (!corridor_) {
+            return;
+        }
+        auto hits = spatialIndex().queryCorridor(route.points.data(), route.points.size() / 3, width / 2,
+                                                 kCorridorHeight);
+        for (const auto &hit : hits) {
+            corridor_ids_.insert(featureKey(hit.layer, hit.id));
+        }
     }
 
-    void NaviMapImpl::bindPsdsData(
-            const std::vector<unsigned int> &VAOs,
-            const std::vector<unsigned int> &vertexVBOs,
-            const std::vector<unsigned int> &colorVBOs,
-            const std::vector<unsigned int> &indicesEBOs) {
+    bool NaviMapImpl::inCorridor(SpatialLayer layer, uint32_t id) const {
+        return !corridor_ || corridor_ids_.count(featureKey(layer, id)) > 0;
+    }
 
-        std::vector<float> colors = {
-                0.8f, 0.8f, 0.8f, 1.0f,
-                0.8f, 0.8f, 0.8f, 1.0f,
-                0.3f, 0.3f, 0.3f, 1.0f,
-                0.3f, 0.3f, 0.3f, 1.0f,
-        };
-        std::vector<float> targetColors = {
-                1.0f, 1.0f, 1.0f, 1.0f,
-                1.0f, 1.0f, 1.0f, 1.0f,
-                1.0f, 0.55f, 0.0f, 1.0f,
-                1.0f, 0.55f, 0.0f, 1.0f,
+    void NaviMapImpl::buildFloors() const {
+        if (floors_built_) {
+            return;
+        }
+        floors_built_ = true;
+        struct Span {
+            uint64_t key;
+            float min_z, max_z;
         };
-        std::vector<unsigned int> indices = {
-                0, 1, 2, 2, 3, 0,
+        std::vector<Span> spans;
+        std::vector<float> heights;
+        auto collect = [&](SpatialLayer layer) {
+            return [&, layer](size_t, uint32_t id, uint32_t, const std::vector<float> &points) {
+                Span span{featureKey(layer, id), 1e9f, -1e9f};
+                for (size_t i = 2; i < points.size(); i += 3) {
+                    heights.push_back(points[i]);
+                    span.min_z = std::min(span.min_z, points[i]);
+                    span.max_z = std::max(span.max_z, points[i]);
+                }
+                if (span.min_z <= span.max_z) {
+                    spans.push_back(span);
+                }
+            };
         };
-
-        auto psds = getParkingSpaces();
-        for (size_t i = 0; i < psds.size(); ++i) {
-            glBindVertexArray(VAOs[i]);
-
-            glBindBuffer(GL_ARRAY_BUFFER, vertexVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, psds[i].points.size() * sizeof(float), psds[i].points.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, colorVBOs[i]);
-            if (psds[i].id == target_prk_space_id_) {
-                glBufferData(GL_ARRAY_BUFFER, targetColors.size() * sizeof(float), targetColors.data(), GL_STATIC_DRAW);
-            } else {
-                glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
+        forEachFeature(TILE_ROADS, &DecodedRoadTile::roads, &CompactTile::roads, collect(SPATIAL_ROADS));
+        forEachFeature(TILE_POIS, &DecodedRoadTile::pois, &CompactTile::pois, collect(SPATIAL_POIS));
+        forEachFeature(TILE_ROAD_MARKS, &DecodedRoadTile::road_marks, &CompactTile::road_marks,
+                       collect(SPATIAL_ROAD_MARKS));
+        forEachFeature(TILE_ROAD_OBSTACLES, &DecodedRoadTile::road_obstacles, &CompactTile::road_obstacles,
+                       collect(SPATIAL_ROAD_OBSTACLES));
+        forEachFeature(TILE_PARKING_SPACES, &DecodedRoadTile::parking_spaces, &CompactTile::parking_spaces,
+                       collect(SPATIAL_PARKING_SPACES));
+
+        auto levels = cluster_floor_heights(heights);
+        for (size_t i = 0; i < levels.size(); ++i) {
+            float below = i == 0 ? -std::numeric_limits<float>::infinity() : (levels[i - 1] + levels[i]) / 2;
+            float above = i + 1 == levels.size() ? std::numeric_limits<float>::infinity()
+                                                 : (levels[i] + levels[i + 1]) / 2;
+            floors_.push_back({static_cast<int>(i), levels[i], below, above, 0});
+        }
+        if (floors_.empty()) {
+            return;
+        }
+        for (const auto &span : spans) {
+            int first = nearest_floor(levels, span.min_z), last = nearest_floor(levels, span.max_z);
+            feature_floors_.emplace(span.key, std::make_pair(first, last));
+            if (first == last) {
+                ++floors_[first].feature_count;
             }
-            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
-            glEnableVertexAttribArray(1);
+        }
+    }
 
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indicesEBOs[i]);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(),
-                         GL_STATIC_DRAW);
+    std::vector<Floor> NaviMapImpl::getFloors() const {
+        buildFloors();
+        return floors_;
+    }
 
-            glBindVertexArray(0);
+    bool NaviMapImpl::getFeatureFloors(SpatialLayer layer, uint32_t id, int &first, int &last) const {
+        buildFloors();
+        auto it = feature_floors_.find(featureKey(layer, id));
+        if (it == feature_floors_.end()) {
+            return false;
         }
+        first = it->second.first;
+        last = it->second.second;
+        return true;
+    }
+
+    void NaviMapImpl::setFloorFilter(SpatialLayer layer, int first, int last, LayerBuffer &buffer) const {
+        if (first > last) {
+            buffer.setFilter(nullptr);
+            return;
+        }
+        buildFloors();
+        buffer.setFilter([&](const FeatureRange &range) {
+            auto it = feature_floors_.find(featureKey(layer, range.id));
+            return it == feature_floors_.end() || (it->second.first <= last && it->second.second >= first);
+        });
+    }
+
+    void NaviMapImpl::setTargetId(int id, LayerBuffer &psds) {
+        psds.setFeatureState(target_prk_space_id_, style::NORMAL);
+        target_prk_space_id_ = id;
+        psds.setFeatureState(target_prk_space_id_, style::HIGHLIGHT);
     }
 } // namespace navi_map
 
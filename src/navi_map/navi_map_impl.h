@@ -4,52 +4,147 @@
 #include "navi_map.h"
 #include "road_tile.pb.h"
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utils/trans_util.h>
+#include "utils/geometry_cache.h"
+#include "utils/road_tile_decoder.h"
+#include "compact_layer.h"
+#include "road_graph.h"
 
 namespace navi_map {
     class NaviMapImpl : public NaviMap {
     public:
-        NaviMapImpl(const std::string &db_path, int partition_id, BlobType blob_type);
+        NaviMapImpl(const std::string &db_path, int partition_id, BlobType blob_type, bool low_memory);
 
         [[nodiscard]] std::array<double, 3> getStartPoint() const override;
 
         [[nodiscard]] std::array<double, 3> getEndPoint() const override;
 
+        [[nodiscard]] int getTargetId() const override { return target_prk_space_id_; }
+
+        void setTargetId(int id, LayerBuffer &psds) override;
+
         [[nodiscard]] std::vector<Road> getRoads() const override;
 
-        std::vector<unsigned int> bindRoadsData(
-                const std::vector<unsigned int> &VAOs,
-                const std::vector<unsigned int> &vertexVBOs,
-                const std::vector<unsigned int> &colorVBOs) override;
+        [[nodiscard]] LayerData getRoadsLayer() const override;
+
+        void bindRoadsData(LayerBuffer &roads) override;
 
         [[nodiscard]] std::vector<POI> getPOI() const override;
 
-        std::vector<unsigned int> bindPoiData(const std::vector<unsigned int> &VAOs,
-                         const std::vector<unsigned int> &vertexVBOs,
-                         const std::vector<unsigned int> &colorVBOs) override;
+        [[nodiscard]] LayerData getPoiLayer() const override;
+
+        void bindPoiData(LayerBuffer &pois) override;
 
         [[nodiscard]] std::vector<RoadMark> getRoadMark() const override;
 
-        void bindRoadMarkData(const std::vector<unsigned int> &VAOs,
-                              const std::vector<unsigned int> &vertexVBOs,
-                              const std::vector<unsigned int> &colorVBOs) override;
+        [[nodiscard]] LayerData getRoadMarkLayer() const override;
+
+        void bindRoadMarkData(LayerBuffer &roadMarks) override;
 
         [[nodiscard]] std::vector<RoadObstacle> getRoadObstacle() const override;
 
-        std::vector<unsigned int> bindRoadObstacleData(const std::vector<unsigned int> &VAOs,
-                                  const std::vector<unsigned int> &vertexVBOs,
-                                  const std::vector<unsigned int> &colorVBOs) override;
+        [[nodiscard]] LayerData getRoadObstacleLayer() const override;
+
+        void bindRoadObstacleData(LayerBuffer &roadObstacles) override;
 
         [[nodiscard]] std::vector<ParkingSpace> getParkingSpaces() const override;
 
-        void bindPsdsData(
-                const std::vector<unsigned int> &VAOs,
-                const std::vector<unsigned int> &vertexVBOs,
-                const std::vector<unsigned int> &colorVBOs,
-                const std::vector<unsigned int> &indicesEBOs) override;
+        [[nodiscard]] LayerData getPsdsLayer() const override;
+
+        void bindPsdsData(LayerBuffer &psds) override;
+
+        bool getParkingSpace(uint32_t id, ParkingSpace &psd) const override;
+
+        [[nodiscard]] std::vector<FootprintCluster> getParkingRows() const override;
+
+        [[nodiscard]] LayerData getParkingRowsLayer() const override;
+
+        void bindParkingRowsData(LayerBuffer &rows) override;
+
+        [[nodiscard]] size_t residentBytes() const override;
+
+        [[nodiscard]] std::vector<SpatialHit> queryBox(const std::array<float, 3> &min, const std::array<float, 3> &max,
+                                                       uint32_t layers) const override;
+
+        [[nodiscard]] std::vector<SpatialHit> queryRadius(const std::array<float, 3> &center, float radius,
+                                                          uint32_t layers) const override;
+
+        [[nodiscard]] std::vector<SpatialHit> nearestK(const std::array<float, 3> &point, size_t k,
+                                                       uint32_t layers) const override;
+
+        [[nodiscard]] std::vector<SpatialHit> raycast(const std::array<float, 3> &origin,
+                                                      const std::array<float, 3> &direction, float tolerance,
+                                                      uint32_t layers) const override;
+
+        [[nodiscard]] Route findRoute(const std::array<float, 3> &from, const std::array<float, 3> &to) const override;
+
+        [[nodiscard]] Route findRouteToParkingSpace(const std::array<float, 3> &from,
+                                                    uint32_t parking_space_id) const override;
+
+        [[nodiscard]] LayerData getRouteLayer(const Route &route) const override;
+
+        void bindRouteData(const Route &route, LayerBuffer &buffer) override;
+
+        void setCorridor(const Route &route, float width) override;
+
+        [[nodiscard]] size_t corridorFeatureCount() const override { return corridor_ids_.size(); }
+
+        [[nodiscard]] std::vector<Floor> getFloors() const override;
+
+        bool getFeatureFloors(SpatialLayer layer, uint32_t id, int &first, int &last) const override;
+
+        void setFloorFilter(SpatialLayer layer, int first, int last, LayerBuffer &buffer) const override;
 
     private:
-        hdmap::data::proto::RoadTile road_tile_{};
+        using LayerBuilder = LayerData (NaviMapImpl::*)() const;
+
+        // 首次访问某图层时才从blob解码该图层, 图层命中磁盘缓存或不可见时无需解码
+        const DecodedRoadTile &tile(uint32_t layers) const;
+        void updateFastMode() const;
+        const SpatialIndex &spatialIndex() const;
+        const RoadGraph &roadGraph() const;
+        void buildFloors() const;
+        // 未开启走廊模式时总是true
+        [[nodiscard]] bool inCorridor(SpatialLayer layer, uint32_t id) const;
+        [[nodiscard]] std::vector<float> toENU(const TileLayer &layer, size_t i) const;
+        // 低内存模式下从紧凑存储读取, 否则由解码结果现算ENU. fn(i, id, type, points)
+        template<typename Fn>
+        void forEachFeature(uint32_t layer, TileLayer DecodedRoadTile::*source, CompactLayer CompactTile::*compact,
+                            Fn &&fn) const;
+        // 命中缓存时从映射读取, 否则构建并写入缓存; 走廊模式下总是重新构建
+        LayerData loadLayer(const std::string &name, LayerBuilder build) const;
+        void bindLayer(const std::string &name, LayerBuilder build, LayerBuffer &buffer) const;
+
+        [[nodiscard]] LayerData buildRoadsLayer() const;
+        [[nodiscard]] LayerData buildPoiLayer() const;
+        [[nodiscard]] LayerData buildRoadMarkLayer() const;
+        [[nodiscard]] LayerData buildRoadObstacleLayer() const;
+        [[nodiscard]] LayerData buildPsdsLayer() const;
+        [[nodiscard]] LayerData buildParkingRowsLayer() const;
+        // 从磁盘缓存恢复parking_rows_, 轮廓或成员任一未命中时返回false
+        bool openParkingRows() const;
+
+        std::string db_path_;
+        int partition_id_;
+        mutable std::string blob_;  // 仅在解码期间持有, 全部图层解码后释放
+        mutable uint32_t decoded_{0};  // 已解码的TileLayerMask
+        mutable std::array<double, 3> fast_min_{}, fast_max_{};
+        mutable DecodedRoadTile tile_{};
+        bool low_memory_;
+        mutable std::unique_ptr<CompactTile> compact_;
+        mutable std::unique_ptr<SpatialIndex> spatial_;
+        mutable std::unique_ptr<RoadGraph> graph_;
+        bool corridor_{false};
+        std::unordered_set<uint64_t> corridor_ids_;   // (SpatialLayer << 32) | id
+        mutable bool floors_built_{false};
+        mutable std::vector<Floor> floors_;
+        mutable std::unordered_map<uint64_t, std::pair<int, int>> feature_floors_;  // 同上的键 -> 楼层区间
+        mutable bool parking_rows_built_{false};
+        mutable std::vector<FootprintCluster> parking_rows_;
+        std::unique_ptr<GeometryCache> cache_;
+        uint64_t cache_key_{};
         std::array<double, 3> start_point_{};
         std::array<double, 3> end_point_{};
         std::unique_ptr<TransUtil> trans_util_;
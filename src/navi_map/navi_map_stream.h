@@ -0,0 +1,56 @@
+#ifndef NAVI_MAP_STREAM_H
+#define NAVI_MAP_STREAM_H
+
+#include <memory>
+#include <string>
+#include <glm/glm.hpp>
+#include "navi_map.h"
+#include "utils/gl_util.h"
+
+namespace navi_map {
+
+    struct StreamConfig {
+        float load_radius = 250.0f;             // 分区参考点与相机的水平距离在此半径内时加载
+        float evict_radius = 400.0f;            // 超出此半径的分区从显存移除
+        float prefetch_distance = 150.0f;       // 沿相机运动方向前推的预取距离
+        size_t cpu_budget = 256u << 20;         // 解码后几何的内存预算(字节)
+        size_t gpu_budget = 128u << 20;         // 显存预算(字节)
+        int max_uploads_per_frame = 1;          // 每帧最多上传的分区数, 避免卡顿
+        int max_pending_loads = 2;              // 后台同时解码的分区数
+    };
+
+    struct StreamStats {
+        size_t resident{};      // 已上传到GPU的分区数
+        size_t cached{};        // 已解码在内存中的分区数
+        size_t loading{};       // 正在后台解码的分区数
+        size_t cpu_bytes{};
+        size_t gpu_bytes{};
+    };
+
+    // 跨多个分区的流式地图: 以起始分区的ENU为公共坐标系, 按相机位置加载/预取/淘汰相邻分区.
+    // update/draw/release须在GL线程调用; 解码在后台线程完成.
+    class NaviMapStream {
+    public:
+        virtual ~NaviMapStream() = default;
+
+        static std::shared_ptr<NaviMapStream> createNaviMapStream(const std::string &db_path, int origin_partition_id,
+                                                                  BlobType blob_type,
+                                                                  const StreamConfig &config = {});
+
+        // 起始分区, 起终点和目标车位都取自它
+        [[nodiscard]] virtual std::shared_ptr<NaviMap> origin() const = 0;
+
+        virtual void update(const glm::vec3 &camera_position) = 0;
+
+        virtual void draw(GLUtil &gl_util) = 0;
+
+        virtual void setTargetId(int id) = 0;
+
+        // 释放全部GL对象, 需在GL上下文销毁前调用
+        virtual void release() = 0;
+
+        [[nodiscard]] virtual StreamStats getStats() const = 0;
+    };
+}
+
+#endif //NAVI_MAP_STREAM_H
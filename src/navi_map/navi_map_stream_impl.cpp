@@ -0,0 +1,222 @@
+#include "navi_map_stream_impl.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include "utils/sql_util.h"
+#include "utils/style_palette.h"
+#include "utils/trans_util.h"
+
+namespace navi_map {
+    namespace {
+        std::array<double, 3> refPointGcj02(const std::string &db_path, int partition_id) {
+            auto ref_point_wgs84 = getPoint(query_for_column(db_path, partition_id, "ref_point"));
+            auto ref_point_gcj02 = wgs84_to_gcj02(ref_point_wgs84[0], ref_point_wgs84[1]);
+            return {ref_point_gcj02[0], ref_point_gcj02[1], ref_point_wgs84[2]};
+        }
+
+        // 目标车位只由起始分区决定, 缓存中的车位一律存为常态
+        void clearStates(LayerData &layer) {
+            for (auto &key : layer.styles) {
+                key &= 0xFFu;
+            }
+        }
+
+        float planarDistance(const glm::vec3 &a, const glm::vec3 &b) {
+            return std::hypot(a.x - b.x, a.y - b.y);
+        }
+    }
+
+    std::shared_ptr<NaviMapStream> NaviMapStream::createNaviMapStream(const std::string &db_path,
+                                                                      int origin_partition_id, BlobType blob_type,
+                                                                      const StreamConfig &config) {
+        return std::make_shared<NaviMapStreamImpl>(db_path, origin_partition_id, blob_type, config);
+    }
+
+    size_t PartitionLayers::byteSize() const {
+        return roads.byteSize() + pois.byteSize() + roadMarks.byteSize() + roadObstacles.byteSize() +
+               psds.byteSize();
+    }
+
+    void PartitionBuffers::upload(const PartitionLayers &layers) {
+        roads.upload(layers.roads);
+        pois.upload(layers.pois);
+        roadMarks.upload(layers.roadMarks);
+        roadObstacles.upload(layers.roadObstacles);
+        psds.upload(layers.psds);
+    }
+
+    void PartitionBuffers::draw() const {
+        roads.draw();
+        pois.draw();
+        roadMarks.draw();
+        roadObstacles.draw();
+        psds.draw();
+    }
+
+    void PartitionBuffers::release() {
+        roads.release();
+        pois.release();
+        roadMarks.release();
+        roadObstacles.release();
+        psds.release();
+    }
+
+    size_t PartitionBuffers::gpuBytes() const {
+        return roads.gpuBytes() + pois.gpuBytes() + roadMarks.gpuBytes() + roadObstacles.gpuBytes() +
+               psds.gpuBytes();
+    }
+
+    NaviMapStreamImpl::NaviMapStreamImpl(const std::string &db_path, int origin_partition_id, BlobType blob_type,
+                                         const StreamConfig &config)
+            : db_path_(db_path), blob_type_(blob_type), config_(config), origin_id_(origin_partition_id),
+              cpu_cache_(config.cpu_budget),
+              gpu_cache_(config.gpu_budget, [](const int &, PartitionBuffers &buffers) { buffers.release(); }) {
+        origin_ = NaviMap::createNaviMap(db_path, origin_partition_id, blob_type);
+
+        // 分区间距离只有几百米, 各分区ENU与公共ENU的旋转差可忽略, 只做平移
+        auto origin_ref = refPointGcj02(db_path, origin_partition_id);
+        TransUtil origin_trans(origin_ref[0], origin_ref[1], origin_ref[2]);
+        for (int id : query_partition_ids(db_path)) {
+            auto ref = refPointGcj02(db_path, id);
+            auto p = origin_trans.transToENU(ref[0], ref[1], ref[2]);
+            partitions_.push_back({id, glm::vec3(p[0], p[1], p[2])});
+            offsets_[id] = partitions_.back().offset;
+        }
+        std::cout << "stream: " << partitions_.size() << " partitions" << std::endl;
+    }
+
+    NaviMapStreamImpl::~NaviMapStreamImpl() {
+        for (auto &[id, future] : loading_) {
+            future.wait();
+        }
+    }
+
+    NaviMapStreamImpl::LayersPtr NaviMapStreamImpl::loadPartition(int partition_id) const {
+        auto layers = std::make_shared<PartitionLayers>();
+        // 后台线程单独解码, 不与GL线程共享origin_
+        auto map = NaviMap::createNaviMap(db_path_, partition_id, blob_type_);
+        layers->roads = map->getRoadsLayer();
+        layers->pois = map->getPoiLayer();
+        layers->roadMarks = map->getRoadMarkLayer();
+        layers->roadObstacles = map->getRoadObstacleLayer();
+        layers->psds = map->getPsdsLayer();
+        clearStates(layers->psds);
+        return layers;
+    }
+
+    std::vector<int> NaviMapStreamImpl::wantedPartitions(const glm::vec3 &camera_position) const {
+        glm::vec3 ahead = camera_position + direction_ * config_.prefetch_distance;
+        std::vector<std::pair<float, int>> wanted;
+        for (const auto &partition : partitions_) {
+            float distance = planarDistance(camera_position, partition.offset);
+            if (distance <= config_.load_radius ||
+                planarDistance(ahead, partition.offset) <= config_.load_radius) {
+                wanted.emplace_back(distance, partition.id);
+            }
+        }
+        std::sort(wanted.begin(), wanted.end());
+
+        std::vector<int> ids;
+        for (const auto &item : wanted) {
+            ids.push_back(item.second);
+        }
+        return ids;
+    }
+
+    void NaviMapStreamImpl::collectLoaded() {
+        for (auto it = loading_.begin(); it != loading_.end();) {
+            if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++it;
+                continue;
+            }
+            try {
+                auto layers = it->second.get();
+                cpu_cache_.put(it->first, layers, layers->byteSize());
+            } catch (const std::exception &e) {
+                std::cerr << "stream: failed to load partition " << it->first << ": " << e.what() << std::endl;
+                failed_.insert(it->first);
+            }
+            it = loading_.erase(it);
+        }
+    }
+
+    void NaviMapStreamImpl::update(const glm::vec3 &camera_position) {
+        if (has_last_position_) {
+            glm::vec3 moved(camera_position.x - last_position_.x, camera_position.y - last_position_.y, 0.0f);
+            if (glm::length(moved) > 1e-3f) {
+                direction_ = glm::normalize(moved);
+            }
+        }
+        last_position_ = camera_position;
+        has_last_position_ = true;
+
+        collectLoaded();
+
+        auto wanted = wantedPartitions(camera_position);
+        int uploads = 0;
+        for (int id : wanted) {
+            if (failed_.count(id) > 0) {
+                continue;
+            }
+            if (gpu_cache_.get(id) != nullptr) {
+                continue;
+            }
+            auto cached = cpu_cache_.get(id);
+            if (cached != nullptr) {
+                if (uploads >= config_.max_uploads_per_frame) {
+                    continue;
+                }
+                PartitionBuffers buffers;
+                buffers.upload(**cached);
+                if (id == origin_id_) {
+                    origin_->setTargetId(origin_->getTargetId(), buffers.psds);
+                }
+                size_t bytes = buffers.gpuBytes();
+                gpu_cache_.put(id, std::move(buffers), bytes);
+                ++uploads;
+            } else if (loading_.count(id) == 0 && loading_.size() < static_cast<size_t>(config_.max_pending_loads)) {
+                loading_.emplace(id, std::async(std::launch::async, [this, id]() { return loadPartition(id); }));
+            }
+        }
+
+        std::vector<int> out_of_range;
+        gpu_cache_.forEach([&](const int &id, PartitionBuffers &) {
+            if (planarDistance(camera_position, offsets_[id]) > config_.evict_radius) {
+                out_of_range.push_back(id);
+            }
+        });
+        for (int id : out_of_range) {
+            gpu_cache_.erase(id);
+        }
+    }
+
+    void NaviMapStreamImpl::draw(GLUtil &gl_util) {
+        gpu_cache_.forEach([&](const int &id, PartitionBuffers &buffers) {
+            gl_util.setModel(glm::translate(glm::mat4(1.0f), offsets_[id]));
+            buffers.draw();
+        });
+        gl_util.setModel(glm::mat4(1.0f));
+    }
+
+    void NaviMapStreamImpl::setTargetId(int id) {
+        auto buffers = gpu_cache_.get(origin_id_);
+        LayerBuffer unused;
+        origin_->setTargetId(id, buffers != nullptr ? buffers->psds : unused);
+    }
+
+    void NaviMapStreamImpl::release() {
+        gpu_cache_.clear();
+    }
+
+    StreamStats NaviMapStreamImpl::getStats() const {
+        StreamStats stats;
+        stats.resident = gpu_cache_.size();
+        stats.cached = cpu_cache_.size();
+        stats.loading = loading_.size();
+        stats.cpu_bytes = cpu_cache_.usedBytes();
+        stats.gpu_bytes = gpu_cache_.usedBytes();
+        return stats;
+    }
+}
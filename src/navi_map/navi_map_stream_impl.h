@@ -0,0 +1,87 @@
+#ifndef NAVI_MAP_STREAM_IMPL_H
+#define NAVI_MAP_STREAM_IMPL_H
+
+#include "navi_map_stream.h"
+#include "utils/lru_cache.h"
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace navi_map {
+
+    // 一个分区解码后的全部图层, 坐标为该分区自身的ENU
+    struct PartitionLayers {
+        LayerData roads;
+        LayerData pois;
+        LayerData roadMarks;
+        LayerData roadObstacles;
+        LayerData psds;
+
+        [[nodiscard]] size_t byteSize() const;
+    };
+
+    struct PartitionBuffers {
+        LayerBuffer roads;
+        LayerBuffer pois;
+        LayerBuffer roadMarks;
+        LayerBuffer roadObstacles;
+        LayerBuffer psds;
+
+        void upload(const PartitionLayers &layers);
+        void draw() const;
+        void release();
+        [[nodiscard]] size_t gpuBytes() const;
+    };
+
+    class NaviMapStreamImpl : public NaviMapStream {
+    public:
+        NaviMapStreamImpl(const std::string &db_path, int origin_partition_id, BlobType blob_type,
+                          const StreamConfig &config);
+
+        ~NaviMapStreamImpl() override;
+
+        [[nodiscard]] std::shared_ptr<NaviMap> origin() const override { return origin_; }
+
+        void update(const glm::vec3 &camera_position) override;
+
+        void draw(GLUtil &gl_util) override;
+
+        void setTargetId(int id) override;
+
+        void release() override;
+
+        [[nodiscard]] StreamStats getStats() const override;
+
+    private:
+        using LayersPtr = std::shared_ptr<const PartitionLayers>;
+
+        struct PartitionInfo {
+            int id;
+            glm::vec3 offset;   // 分区参考点在公共ENU中的位置
+        };
+
+        LayersPtr loadPartition(int partition_id) const;
+        [[nodiscard]] std::vector<int> wantedPartitions(const glm::vec3 &camera_position) const;
+        void collectLoaded();
+
+        std::string db_path_;
+        BlobType blob_type_;
+        StreamConfig config_;
+        int origin_id_;
+        std::shared_ptr<NaviMap> origin_;
+        std::vector<PartitionInfo> partitions_;
+        std::unordered_map<int, glm::vec3> offsets_;
+
+        LruCache<int, LayersPtr> cpu_cache_;
+        LruCache<int, PartitionBuffers> gpu_cache_;
+        std::unordered_map<int, std::future<LayersPtr>> loading_;
+        std::unordered_set<int> failed_;
+
+        bool has_last_position_{false};
+        glm::vec3 last_position_{};
+        glm::vec3 direction_{};
+    };
+}
+
+#endif //NAVI_MAP_STREAM_IMPL_H
@@ -0,0 +1,293 @@
+#include "road_graph.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+    constexpr uint32_t kReversed = 0x80000000u;
+    constexpr uint32_t kNone = 0xFFFFFFFFu;
+    // parent中的起点标记: 从起点投影沿road向tail/head走到的节点
+    constexpr uint32_t kSourceForward = 0xFFFFFFFEu;
+    constexpr uint32_t kSourceBackward = 0xFFFFFFFDu;
+
+    float distance3(const float *a, const float *b) {
+        float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+RoadGraph RoadGraph::build(const std::vector<uint32_t> &heads, const std::vector<uint32_t> &tails,
+                           const std::vector<uint8_t> &directions, const std::vector<uint32_t> &offsets,
+                           const std::vector<float> &points) {
+    RoadGraph graph;
+    struct Edge {
+        uint32_t from, to;
+        float weight;
+        uint32_t road;
+    };
+    std::vector<Edge> edges;
+    std::unordered_map<uint32_t, uint32_t> nodes;  // RoadPort count -> 节点
+    auto node = [&](uint32_t port, const float *p) {
+        // 缺少port id的端点不与其他road相连
+        if (port != 0) {
+            auto it = nodes.find(port);
+            if (it != nodes.end()) {
+                return it->second;
+            }
+            nodes.emplace(port, static_cast<uint32_t>(graph.node_points_.size() / 3));
+        }
+        graph.node_points_.insert(graph.node_points_.end(), p, p + 3);
+        return static_cast<uint32_t>(graph.node_points_.size() / 3 - 1);
+    };
+
+    size_t road_count = heads.size();
+    for (uint32_t road = 0; road < road_count; ++road) {
+        const float *begin = points.data() + offsets[road] * 3;
+        uint32_t count = offsets[road + 1] - offsets[road];
+        float measure = 0.0f;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                measure += distance3(begin + (i - 1) * 3, begin + i * 3);
+            }
+            graph.measures_.push_back(measure);
+        }
+        graph.road_points_.insert(graph.road_points_.end(), begin, begin + count * 3);
+        graph.road_offsets_.push_back(static_cast<uint32_t>(graph.road_points_.size() / 3));
+        // 协议中新增或损坏的方向值按未知(双向)处理
+        uint8_t direction = directions[road] > BOTH ? static_cast<uint8_t>(UNKNOWN) : directions[road];
+        graph.directions_.push_back(count < 2 ? static_cast<uint8_t>(NONE) : direction);
+        if (count < 2) {
+            graph.road_nodes_.insert(graph.road_nodes_.end(), {kNone, kNone});
+            continue;
+        }
+        uint32_t head = node(heads[road], begin);
+        uint32_t tail = node(tails[road], begin + (count - 1) * 3);
+        graph.road_nodes_.insert(graph.road_nodes_.end(), {head, tail});
+        if (graph.forward(road)) {
+            edges.push_back({head, tail, measure, road});
+        }
+        if (graph.backward(road)) {
+            edges.push_back({tail, head, measure, road | kReversed});
+        }
+    }
+
+    size_t node_count = graph.node_points_.size() / 3;
+    graph.offsets_.assign(node_count + 1, 0);
+    for (const auto &edge : edges) {
+        ++graph.offsets_[edge.from + 1];
+    }
+    for (size_t i = 0; i < node_count; ++i) {
+        graph.offsets_[i + 1] += graph.offsets_[i];
+    }
+    graph.targets_.resize(edges.size());
+    graph.weights_.resize(edges.size());
+    graph.edge_roads_.resize(edges.size());
+    std::vector<uint32_t> cursor(graph.offsets_.begin(), graph.offsets_.end() - 1);
+    for (const auto &edge : edges) {
+        uint32_t slot = cursor[edge.from]++;
+        graph.targets_[slot] = edge.to;
+        graph.weights_[slot] = edge.weight;
+        graph.edge_roads_[slot] = edge.road;
+    }
+    return graph;
+}
+
+bool RoadGraph::forward(uint32_t road) const {
+    auto direction = directions_[road];
+    return direction == A_B || direction == BOTH || direction == UNKNOWN;
+}
+
+bool RoadGraph::backward(uint32_t road) const {
+    auto direction = directions_[road];
+    return direction == B_A || direction == BOTH || direction == UNKNOWN;
+}
+
+RoadGraph::Position RoadGraph::snap(const float *p) const {
+    Position best;
+    best.distance = kInf;
+    for (uint32_t road = 0; road < roadCount(); ++road) {
+        if (road_nodes_[road * 2] == kNone) {
+            continue;
+        }
+        for (uint32_t i = road_offsets_[road]; i + 1 < road_offsets_[road + 1]; ++i) {
+            const float *a = road_points_.data() + i * 3, *b = a + 3;
+            float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            float len2 = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+            float t = len2 > 0.0f ? ((p[0] - a[0]) * ab[0] + (p[1] - a[1]) * ab[1] + (p[2] - a[2]) * ab[2]) / len2
+                                  : 0.0f;
+            t = std::clamp(t, 0.0f, 1.0f);
+            float q[3] = {a[0] + ab[0] * t, a[1] + ab[1] * t, a[2] + ab[2] * t};
+            float d = distance3(p, q);
+            if (d < best.distance) {
+                best.road = static_cast<int>(road);
+                best.distance = d;
+                best.offset = measures_[i] + (measures_[i + 1] - measures_[i]) * t;
+                std::copy(q, q + 3, best.point);
+            }
+        }
+    }
+    return best;
+}
+
+void RoadGraph::appendSlice(uint32_t road, float from, float to, std::vector<float> &out) const {
+    uint32_t first = road_offsets_[road], last = road_offsets_[road + 1] - 1;
+    auto at = [&](float offset, float *q) {
+        auto it = std::upper_bound(measures_.begin() + first, measures_.begin() + last, offset);
+        uint32_t i = std::max<uint32_t>(static_cast<uint32_t>(it - measures_.begin()), first + 1) - 1;
+        float span = measures_[i + 1] - measures_[i];
+        float t = span > 0.0f ? std::clamp((offset - measures_[i]) / span, 0.0f, 1.0f) : 0.0f;
+        const float *a = road_points_.data() + i * 3;
+        for (int axis = 0; axis < 3; ++axis) {
+            q[axis] = a[axis] + (a[axis + 3] - a[axis]) * t;
+        }
+    };
+    auto push = [&](const float *q) {
+        // 与上一段的末点重合时不重复
+        if (out.size() >= 3 && distance3(out.data() + out.size() - 3, q) < 1e-4f) {
+            return;
+        }
+        out.insert(out.end(), q, q + 3);
+    };
+    float q[3];
+    at(from, q);
+    push(q);
+    if (from <= to) {
+        for (uint32_t i = first; i <= last; ++i) {
+            if (measures_[i] > from && measures_[i] < to) {
+                push(road_points_.data() + i * 3);
+            }
+        }
+    } else {
+        for (uint32_t i = last + 1; i-- > first;) {
+            if (measures_[i] < from && measures_[i] > to) {
+                push(road_points_.data() + i * 3);
+            }
+        }
+    }
+    at(to, q);
+    push(q);
+}
+
+RoadGraph::Path RoadGraph::route(const float *from, const float *to, bool astar) const {
+    Path path;
+    Position start = snap(from), goal = snap(to);
+    if (start.road < 0 || goal.road < 0) {
+        return path;
+    }
+    auto s = static_cast<uint32_t>(start.road), t = static_cast<uint32_t>(goal.road);
+
+    // 到达终点road的head/tail节点后, 还需沿该road走到终点投影
+    uint32_t goal_head = road_nodes_[t * 2], goal_tail = road_nodes_[t * 2 + 1];
+    float via_head = forward(t) ? goal.offset : kInf;
+    float via_tail = backward(t) ? roadLength(t) - goal.offset : kInf;
+
+    float best = kInf;
+    uint32_t best_node = kNone;
+    if (s == t && ((goal.offset >= start.offset && forward(s)) || (goal.offset <= start.offset && backward(s)))) {
+        best = std::fabs(goal.offset - start.offset);
+    }
+
+    size_t n = nodeCount();
+    std::vector<float> cost(n, kInf);
+    std::vector<uint32_t> parent(n, kNone);
+    struct Entry {
+        float priority;
+        float cost;
+        uint32_t node;
+        bool operator>(const Entry &other) const { return priority > other.priority; }
+    };
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+    // 启发为节点到终点投影的直线距离, 边权是中心线长度, 不会高估
+    auto heuristic = [&](uint32_t node) {
+        return astar ? distance3(node_points_.data() + node * 3, goal.point) : 0.0f;
+    };
+    auto seed = [&](uint32_t node, float c, uint32_t marker) {
+        if (c < cost[node]) {
+            cost[node] = c;
+            parent[node] = marker;
+            queue.push({c + heuristic(node), c, node});
+        }
+    };
+    if (forward(s)) {
+        seed(road_nodes_[s * 2 + 1], roadLength(s) - start.offset, kSourceForward);
+    }
+    if (backward(s)) {
+        seed(road_nodes_[s * 2], start.offset, kSourceBackward);
+    }
+
+    while (!queue.empty()) {
+        auto entry = queue.top();
+        queue.pop();
+        if (entry.priority >= best) {
+            break;
+        }
+        if (entry.cost > cost[entry.node]) {
+            continue;
+        }
+        uint32_t u = entry.node;
+        if (u == goal_head && entry.cost + via_head < best) {
+            best = entry.cost + via_head;
+            best_node = u;
+        }
+        if (u == goal_tail && entry.cost + via_tail < best) {
+            best = entry.cost + via_tail;
+            best_node = u;
+        }
+        for (uint32_t e = offsets_[u]; e < offsets_[u + 1]; ++e) {
+            float c = entry.cost + weights_[e];
+            uint32_t v = targets_[e];
+            if (c < cost[v]) {
+                cost[v] = c;
+                parent[v] = e;
+                queue.push({c + heuristic(v), c, v});
+            }
+        }
+    }
+    if (best == kInf) {
+        return path;
+    }
+    path.found = true;
+    path.length = best;
+    if (best_node == kNone) {
+        path.roads.push_back(s);
+        appendSlice(s, start.offset, goal.offset, path.points);
+        return path;
+    }
+
+    std::vector<uint32_t> chain;
+    uint32_t node = best_node;
+    while (parent[node] != kSourceForward && parent[node] != kSourceBackward) {
+        uint32_t e = parent[node];
+        chain.push_back(e);
+        uint32_t road = edge_roads_[e] & ~kReversed;
+        node = road_nodes_[road * 2 + ((edge_roads_[e] & kReversed) ? 1 : 0)];
+    }
+    std::reverse(chain.begin(), chain.end());
+
+    path.roads.push_back(s);
+    appendSlice(s, start.offset, parent[node] == kSourceForward ? roadLength(s) : 0.0f, path.points);
+    for (uint32_t e : chain) {
+        uint32_t road = edge_roads_[e] & ~kReversed;
+        bool reversed = edge_roads_[e] & kReversed;
+        if (path.roads.back() != road) {
+            path.roads.push_back(road);
+        }
+        appendSlice(road, reversed ? roadLength(road) : 0.0f, reversed ? 0.0f : roadLength(road), path.points);
+    }
+    if (path.roads.back() != t) {
+        path.roads.push_back(t);
+    }
+    bool end_at_head = best_node == goal_head && cost[best_node] + via_head == best;
+    appendSlice(t, end_at_head ? 0.0f : roadLength(t), goal.offset, path.points);
+    return path;
+}
+
+size_t RoadGraph::byteSize() const {
+    return (offsets_.capacity() + targets_.capacity() + edge_roads_.capacity() + road_nodes_.capacity() +
+            road_offsets_.capacity()) * sizeof(uint32_t) +
+           (weights_.capacity() + node_points_.capacity() + road_points_.capacity() + measures_.capacity()) *
+           sizeof(float) + directions_.capacity();
+}
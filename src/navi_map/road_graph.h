@@ -0,0 +1,70 @@
+#ifndef ROAD_GRAPH_H
+#define ROAD_GRAPH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 由road.head_id/tail_id/travel_direction构成的有向路网, CSR存储.
+// 节点为RoadPort, 每条road按可通行方向贡献head->tail和/或tail->head两条边, 边权为中心线ENU长度.
+// road中心线的首点视为head(A端), 末点视为tail(B端). 构建后只读, route()可并发调用.
+class RoadGraph {
+  public:
+    // Road::TravelDirection
+    enum TravelDirection : uint8_t {
+        UNKNOWN = 0, NONE = 1, A_B = 2, B_A = 3, BOTH = 4,
+    };
+
+    // 点在road中心线上的投影
+    struct Position {
+        int road{-1};           // road下标, 没有road时为-1
+        float offset{};         // 投影点沿中心线到head的距离
+        float distance{};       // 点到中心线的距离
+        float point[3]{};
+    };
+
+    struct Path {
+        bool found{false};
+        float length{};                 // 沿道路的长度, 不含起终点到道路的连接段
+        std::vector<uint32_t> roads;    // 依次经过的road下标
+        std::vector<float> points;      // 从起点投影到终点投影的折线 [x, y, z, ...]
+    };
+
+    // points/offsets与TileLayer相同的布局, 为各road中心线的ENU坐标; 未知方向按双向处理, NONE不可通行
+    static RoadGraph build(const std::vector<uint32_t> &heads, const std::vector<uint32_t> &tails,
+                           const std::vector<uint8_t> &directions, const std::vector<uint32_t> &offsets,
+                           const std::vector<float> &points);
+
+    // 距离p最近的road中心线位置
+    [[nodiscard]] Position snap(const float *p) const;
+
+    // 起点和终点先投影到最近的road, 再在路网上搜索最短路. astar为false时退化为Dijkstra, 用于对照
+    [[nodiscard]] Path route(const float *from, const float *to, bool astar = true) const;
+
+    [[nodiscard]] size_t nodeCount() const { return offsets_.size() - 1; }
+    [[nodiscard]] size_t edgeCount() const { return targets_.size(); }
+    [[nodiscard]] size_t roadCount() const { return road_nodes_.size() / 2; }
+    [[nodiscard]] size_t byteSize() const;
+
+  private:
+    [[nodiscard]] bool forward(uint32_t road) const;    // head -> tail可通行
+    [[nodiscard]] bool backward(uint32_t road) const;   // tail -> head可通行
+    [[nodiscard]] float roadLength(uint32_t road) const { return measures_[road_offsets_[road + 1] - 1]; }
+    // 沿road中心线从offset from走到offset to的折线(from > to时反向), 追加到out
+    void appendSlice(uint32_t road, float from, float to, std::vector<float> &out) const;
+
+    // CSR: 节点i的出边为[offsets_[i], offsets_[i + 1])
+    std::vector<uint32_t> offsets_{0};
+    std::vector<uint32_t> targets_;
+    std::vector<float> weights_;
+    std::vector<uint32_t> edge_roads_;      // 边对应的road下标, 最高位为1表示tail -> head
+
+    std::vector<float> node_points_;        // 节点ENU坐标, 用于A*启发
+    std::vector<uint32_t> road_nodes_;      // 每条road的[head节点, tail节点]
+    std::vector<uint8_t> directions_;
+    std::vector<uint32_t> road_offsets_{0};
+    std::vector<float> road_points_;
+    std::vector<float> measures_;           // 每个中心线点到head的累计长度
+};
+
+#endif //ROAD_GRAPH_H
@@ -4,44 +4,126 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
 
 #include "utils/gl_util.h"
+#include "utils/layer_toggle.h"
+#include "utils/feature_picker.h"
+#include "utils/footprint_lod.h"
+#include "utils/cull_pass.h"
+#include "utils/minimap.h"
 #include "hmi_map/hmi_map.h"
 #include "utils/sql_util.h"
 
 using namespace std;
 
-struct FloorVAO {
-    float floorName{};
+// 按数字键1-4切换各楼层的同类要素, 隐藏超过该时间(秒)的图层释放显存
+constexpr double kLayerUnloadDelay = 10.0;
 
-    std::vector<unsigned int> pillarVAOs;
-    std::vector<unsigned int> pillarVertexVBOs;
-    std::vector<unsigned int> pillarColorVBOs;
-    std::vector<unsigned int> pillarEBOs;
+enum FeatureKind {
+    PILLARS,
+    PSDS,
+    SPEED_BUMPS,
+    ROADS,
+    KIND_COUNT
+};
 
-    std::vector<unsigned int> psdVAOs;
-    std::vector<unsigned int> psdVertexVBOs;
-    std::vector<unsigned int> psdColorVBOs;
-    std::vector<unsigned int> psdEBOs;
+const char *const kKindNames[KIND_COUNT] = {"pillars", "psds", "speed_bumps", "roads"};
 
-    std::vector<unsigned int> speedBumpVAOs;
-    std::vector<unsigned int> speedBumpVertexVBOs;
-    std::vector<unsigned int> speedBumpColorVBOs;
-    std::vector<unsigned int> speedBumpEBOs;
+// 远处合并绘制的柱子排, 放在各楼层layers的末尾, 随pillars一起显示
+constexpr int kPillarRows = KIND_COUNT;
 
-    std::vector<unsigned int> roadVAOs;
-    std::vector<unsigned int> roadVertexVBOs;
-    std::vector<unsigned int> roadColorVBOs;
-    std::vector<unsigned int> roadEBOs;
+struct FloorLayers {
+    float floorName{};
+    FloorBounds bounds;
+    std::shared_ptr<FootprintLod> pillarLod;
 
-    std::vector<unsigned int> roadPointNums;
+    std::vector<LayerToggle> layers;  // 按FeatureKind排列, 最后是kPillarRows
 };
 
+// rows为true时是排图层的过滤: 只画合并的排; 否则是柱子图层的过滤: 只画不在合并排中的柱子
+std::function<bool(const FeatureRange &)> pillarLodFilter(const std::shared_ptr<FootprintLod> &lod, bool rows) {
+    return [lod, rows](const FeatureRange &range) {
+        return rows ? lod->merged(range.id) : !lod->featureMerged(range.id);
+    };
+}
+
+// 包围盒的8个角点都在视锥同一个裁剪面之外时整层跳过
+bool boxVisible(const glm::mat4 &viewProjection, const FloorBounds &bounds) {
+    if (bounds.min[0] > bounds.max[0]) {
+        return false;
+    }
+    int outside[6] = {};
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 p = viewProjection * glm::vec4(corner & 1 ? bounds.max[0] : bounds.min[0],
+            corner & 2 ? bounds.max[1] : bounds.min[1], corner & 4 ? bounds.max[2] : bounds.min[2], 1.0f);
+        for (int axis = 0; axis < 3; ++axis) {
+            outside[axis * 2] += p[axis] < -p.w;
+            outside[axis * 2 + 1] += p[axis] > p.w;
+        }
+    }
+    return std::none_of(outside, outside + 6, [](int count) { return count == 8; });
+}
+
+// 相机所在的楼层: 底面不高于相机的最高一层, floors按底面高度升序
+int cameraFloor(const std::vector<FloorLayers> &floors, float z) {
+    int current = 0;
+    for (int i = 0; i < static_cast<int>(floors.size()); ++i) {
+        if (floors[i].bounds.min[0] <= floors[i].bounds.max[0] && floors[i].bounds.min[2] <= z) {
+            current = i;
+        }
+    }
+    return current;
+}
+
 int main(int argc, char *argv[])
 {
     /************** 处理命令输入，生成HMIMap对象 *************/
-    if (argc != 2 && argc != 3) {
-        cout << "Usage: \n./offline_hmi_map <map_file> \n./offline_hmi_map <db_file> <partition_id>" << endl;
+    // 末尾可加--layers=psds,roads指定启动时可见的要素类别, 其余类别在首次打开时才转换上传;
+    // --floor-range=N只加载并绘制当前楼层上下N层内的楼层, 默认全部楼层;
+    // --lod-distance=D相机距离超过D米的一排柱子合并成一个轮廓绘制(默认100), 0关闭;
+    // --no-indirect剔除结果用glMultiDraw*提交, 不使用glMultiDraw*Indirect;
+    // --no-render-thread在主线程上处理输入和绘制, 不使用单独的渲染线程;
+    // --capture=dir从第一帧开始把每帧写成dir下的PNG序列
+    bool visible[KIND_COUNT] = {true, true, true, true};
+    string captureDir;
+    bool noIndirect = false, renderThread = true;
+    int floorRange = -1;  // 小于0时不按楼层筛选
+    float lodDistance = 100.0f;
+    bool args_ok = true;
+    while (argc > 2 && string(argv[argc - 1]).rfind("--", 0) == 0) {
+        string arg = argv[argc - 1];
+        if (arg.rfind("--layers=", 0) == 0) {
+            string list = "," + arg.substr(9) + ",";
+            for (int kind = 0; kind < KIND_COUNT; ++kind) {
+                visible[kind] = list.find("," + string(kKindNames[kind]) + ",") != string::npos;
+            }
+        } else if (arg.rfind("--floor-range=", 0) == 0) {
+            args_ok = args_ok && sscanf(arg.c_str() + 14, "%d", &floorRange) == 1 && floorRange >= 0;
+        } else if (arg.rfind("--lod-distance=", 0) == 0) {
+            char *end = nullptr;
+            lodDistance = strtof(arg.c_str() + 15, &end);
+            args_ok = args_ok && *end == '\0' && lodDistance >= 0.0f;
+        } else if (arg == "--no-indirect") {
+            noIndirect = true;
+        } else if (arg == "--no-render-thread") {
+            renderThread = false;
+        } else if (arg.rfind("--capture=", 0) == 0 && arg.size() > 10) {
+            captureDir = arg.substr(10);
+        } else {
+            args_ok = false;
+        }
+        --argc;
+    }
+    if (!args_ok || (argc != 2 && argc != 3)) {
+        cout << "Usage: \n./offline_hmi_map <map_file> [--layers=...] [--floor-range=N] [--lod-distance=D]"
+                " [--no-indirect] [--no-render-thread] [--capture=dir]\n"
+                "./offline_hmi_map <db_file> <partition_id> [--layers=...] [--floor-range=N] [--lod-distance=D]"
+                " [--no-indirect] [--no-render-thread] [--capture=dir]" << endl;
         return 1;
     }
     std::string filename = argv[1];
@@ -76,133 +158,224 @@ int main(int argc, char *argv[])
         glm::vec3(endPoint[0], endPoint[1], endPoint[2]));
 
 
-    std::vector<FloorVAO> floorVAOs;
+    std::vector<FloorLayers> floorLayers;
     auto floorNames = hmi_map->getFloorNames();
+    auto map = hmi_map.get();
     for (auto floorName : floorNames) {
-        FloorVAO floorVAO;
-        floorVAO.floorName = floorName;
-
-        size_t objNum{};
-
-        objNum = hmi_map->getPillars(floorName).size();
-        floorVAO.pillarVAOs.resize(objNum);
-        floorVAO.pillarVertexVBOs.resize(objNum);
-        floorVAO.pillarColorVBOs.resize(objNum);
-        floorVAO.pillarEBOs.resize(objNum);
-        glGenVertexArrays(objNum, floorVAO.pillarVAOs.data());
-        glGenBuffers(objNum, floorVAO.pillarVertexVBOs.data());
-        glGenBuffers(objNum, floorVAO.pillarColorVBOs.data());
-        glGenBuffers(objNum, floorVAO.pillarEBOs.data());
-        hmi_map->bindPillarsData(floorName,
-            floorVAO.pillarVAOs, floorVAO.pillarVertexVBOs, floorVAO.pillarColorVBOs, floorVAO.pillarEBOs);
-
-        objNum = hmi_map->getPsds(floorName).size();
-        floorVAO.psdVAOs.resize(objNum);
-        floorVAO.psdVertexVBOs.resize(objNum);
-        floorVAO.psdColorVBOs.resize(objNum);
-        floorVAO.psdEBOs.resize(objNum);
-        glGenVertexArrays(objNum, floorVAO.psdVAOs.data());
-        glGenBuffers(objNum, floorVAO.psdVertexVBOs.data());
-        glGenBuffers(objNum, floorVAO.psdColorVBOs.data());
-        glGenBuffers(objNum, floorVAO.psdEBOs.data());
-        hmi_map->bindPsdsData(floorName,
-            floorVAO.psdVAOs, floorVAO.psdVertexVBOs, floorVAO.psdColorVBOs, floorVAO.psdEBOs);
-
-        objNum = hmi_map->getSpeedBumps(floorName).size();
-        floorVAO.speedBumpVAOs.resize(objNum);
-        floorVAO.speedBumpVertexVBOs.resize(objNum);
-        floorVAO.speedBumpColorVBOs.resize(objNum);
-        floorVAO.speedBumpEBOs.resize(objNum);
-        glGenVertexArrays(objNum, floorVAO.speedBumpVAOs.data());
-        glGenBuffers(objNum, floorVAO.speedBumpVertexVBOs.data());
-        glGenBuffers(objNum, floorVAO.speedBumpColorVBOs.data());
-        glGenBuffers(objNum, floorVAO.speedBumpEBOs.data());
-        hmi_map->bindSpeedBumpsData(floorName,
-            floorVAO.speedBumpVAOs, floorVAO.speedBumpVertexVBOs, floorVAO.speedBumpColorVBOs, floorVAO.speedBumpEBOs);
-
-        objNum = hmi_map->getRoads(floorName).size();
-        floorVAO.roadVAOs.resize(objNum);
-        floorVAO.roadVertexVBOs.resize(objNum);
-        floorVAO.roadColorVBOs.resize(objNum);
-        floorVAO.roadEBOs.resize(objNum);
-        glGenVertexArrays(objNum, floorVAO.roadVAOs.data());
-        glGenBuffers(objNum, floorVAO.roadVertexVBOs.data());
-        glGenBuffers(objNum, floorVAO.roadColorVBOs.data());
-        glGenBuffers(objNum, floorVAO.roadEBOs.data());
-        floorVAO.roadPointNums = hmi_map->bindRoadsData(floorName,
-            floorVAO.roadVAOs, floorVAO.roadVertexVBOs, floorVAO.roadColorVBOs, floorVAO.roadEBOs);
-
-        floorVAOs.push_back(floorVAO);
+        FloorLayers floor;
+        floor.floorName = floorName;
+        floor.bounds = hmi_map->getFloorBounds(floorName);
+        floor.pillarLod = std::make_shared<FootprintLod>();
+        auto lod = floor.pillarLod;
+        string prefix = to_string(floorName) + "/";
+        floor.layers.emplace_back(prefix + kKindNames[PILLARS], [map, floorName, lod](LayerBuffer &b) {
+            map->bindPillarsData(floorName, b);
+            b.setFilter(pillarLodFilter(lod, false));
+        }, visible[PILLARS]);
+        floor.layers.emplace_back(prefix + kKindNames[PSDS],
+            [map, floorName](LayerBuffer &b) { map->bindPsdsData(floorName, b); }, visible[PSDS]);
+        floor.layers.emplace_back(prefix + kKindNames[SPEED_BUMPS],
+            [map, floorName](LayerBuffer &b) { map->bindSpeedBumpsData(floorName, b); }, visible[SPEED_BUMPS]);
+        floor.layers.emplace_back(prefix + kKindNames[ROADS],
+            [map, floorName](LayerBuffer &b) { map->bindRoadsData(floorName, b); }, visible[ROADS]);
+        // 重置后全部为单独绘制, 下一次update时按距离切换并重建柱子和排的批次
+        floor.layers.emplace_back(prefix + "pillar_rows", [map, floorName, lod](LayerBuffer &b) {
+            lod->reset(map->getPillarRows(floorName));
+            map->bindPillarRowsData(floorName, b);
+            b.setFilter(pillarLodFilter(lod, true));
+        }, false);
+        floorLayers.push_back(std::move(floor));
+    }
+    // 楼层按底面高度自下而上排列, "当前楼层±N"按这个顺序计算
+    std::stable_sort(floorLayers.begin(), floorLayers.end(), [](const FloorLayers &a, const FloorLayers &b) {
+        return a.bounds.min[2] < b.bounds.min[2];
+    });
+    // 默认按相机高度自动选择当前楼层, PageUp/PageDown手动切换后关闭, Home恢复
+    bool autoFloor = true;
+    bool lodEnabled = lodDistance > 0.0f;
+    int currentFloor = cameraFloor(floorLayers, gl_util.cameraPosition().z);
+    auto floorActive = [&](int index) {
+        return floorRange < 0 || std::abs(index - currentFloor) <= floorRange;
+    };
+    for (int i = 0; i < static_cast<int>(floorLayers.size()); ++i) {
+        for (int kind = 0; kind < KIND_COUNT; ++kind) {
+            floorLayers[i].layers[kind].setVisible(visible[kind] && floorActive(i), glfwGetTime());
+            floorLayers[i].layers[kind].update(glfwGetTime(), kLayerUnloadDelay);
+        }
+        floorLayers[i].layers[kPillarRows].setVisible(lodEnabled && visible[PILLARS] && floorActive(i),
+                                                      glfwGetTime());
+        floorLayers[i].layers[kPillarRows].update(glfwGetTime(), kLayerUnloadDelay);
     }
+    std::vector<LayerBuffer *> psdLayers;
+    for (auto &floor : floorLayers) {
+        psdLayers.push_back(&floor.layers[PSDS].buffer());
+    }
+
+    // 按T将目标车位切到下一个车位, 用于演示局部状态更新; 首次按下时才读取车位列表
+    std::vector<int> psdIds;
+    bool psdIdsLoaded = false;
+
+    // 右键拾取可见图层中的要素并高亮
+    FeaturePicker picker;
+    picker.init(gl_util);
 
+    // 右上角范围内楼层的俯视小地图, 与主视图共用图层缓冲, 不做视锥剔除, 只在楼层范围或图层变化时重画; 按M显示/隐藏
+    Minimap minimap;
+    minimap.init();
+    bool showMinimap = true;
 
+    // 视锥剔除在工作线程上进行, 与交换缓冲并行, 下一帧按结果提交间接绘制命令
+    CullPass cull;
+    cull.init(noIndirect);
 
-    float lastFrame = static_cast<float>(glfwGetTime());
-    float deltaTime = 0.0f;
-    // render loop
+    if (!captureDir.empty()) {
+        gl_util.capture().startSequence(captureDir);
+    }
+    // render loop: 主线程处理输入, 以下在渲染线程上执行
     // -----------
-    while (!glfwWindowShouldClose(gl_util.window()))
-    {
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-        // input
-        // -----
-        gl_util.processInput(deltaTime);
-
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    gl_util.run([&]() {
+        gl_util.clear();
         gl_util.updateTransforms();
 
-        for (const auto &floorVAO : floorVAOs) {
-            for (auto &vao : floorVAO.pillarVAOs) {
-                glBindVertexArray(vao);
-                glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        // 之后可能重新加载或过滤图层, 先等上一帧的剔除完成
+        cull.wait();
+        int lastFloor = currentFloor, lastRange = floorRange;
+        int floorCount = static_cast<int>(floorLayers.size());
+        if (gl_util.keyPressed(GLFW_KEY_PAGE_UP) && currentFloor + 1 < floorCount) {
+            autoFloor = false;
+            ++currentFloor;
+        }
+        if (gl_util.keyPressed(GLFW_KEY_PAGE_DOWN) && currentFloor > 0) {
+            autoFloor = false;
+            --currentFloor;
+        }
+        if (gl_util.keyPressed(GLFW_KEY_HOME)) {
+            autoFloor = true;
+        }
+        if (autoFloor) {
+            currentFloor = cameraFloor(floorLayers, gl_util.cameraPosition().z);
+        }
+        // ]扩大N, 超过楼层数后回到全部楼层; [缩小N
+        if (gl_util.keyPressed(GLFW_KEY_RIGHT_BRACKET)) {
+            floorRange = floorRange < 0 ? -1 : (floorRange + 1 < floorCount ? floorRange + 1 : -1);
+        }
+        if (gl_util.keyPressed(GLFW_KEY_LEFT_BRACKET)) {
+            floorRange = floorRange < 0 ? std::max(0, floorCount - 2) : std::max(0, floorRange - 1);
+        }
+        if ((currentFloor != lastFloor || floorRange != lastRange) && floorCount > 0) {
+            cout << "floor " << floorLayers[currentFloor].floorName << (autoFloor ? " (auto)" : "") << ", range "
+                 << (floorRange < 0 ? string("all") : "+-" + to_string(floorRange)) << endl;
+        }
+
+        for (int kind = 0; kind < KIND_COUNT; ++kind) {
+            if (gl_util.keyPressed(GLFW_KEY_1 + kind)) {
+                visible[kind] = !visible[kind];
             }
-            for (auto &vao : floorVAO.psdVAOs) {
-                glBindVertexArray(vao);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        }
+        bool lodToggled = gl_util.keyPressed(GLFW_KEY_L);
+        if (lodToggled) {
+            lodEnabled = !lodEnabled;
+            cout << "pillar row lod: " << (lodEnabled ? "on" : "off") << endl;
+        }
+        // 范围外的楼层按隐藏处理, 超过卸载延迟后释放显存
+        auto eye = gl_util.cameraPosition();
+        for (int i = 0; i < floorCount; ++i) {
+            auto &layers = floorLayers[i].layers;
+            for (int kind = 0; kind < KIND_COUNT; ++kind) {
+                layers[kind].setVisible(visible[kind] && floorActive(i), glfwGetTime());
+                layers[kind].update(glfwGetTime(), kLayerUnloadDelay);
+            }
+            layers[kPillarRows].setVisible(lodEnabled && visible[PILLARS] && floorActive(i), glfwGetTime());
+            layers[kPillarRows].update(glfwGetTime(), kLayerUnloadDelay);
+            // 只在有排切换细节级别时重建柱子和排的绘制批次
+            float distance = lodEnabled ? lodDistance : 0.0f;
+            if ((lodToggled || layers[kPillarRows].loaded()) &&
+                floorLayers[i].pillarLod->update({eye.x, eye.y, eye.z}, distance)) {
+                layers[PILLARS].buffer().setFilter(pillarLodFilter(floorLayers[i].pillarLod, false));
+                layers[kPillarRows].buffer().setFilter(pillarLodFilter(floorLayers[i].pillarLod, true));
+            }
+        }
+
+        bool nextTarget = gl_util.keyPressed(GLFW_KEY_T);
+        if (nextTarget && !psdIdsLoaded) {
+            for (auto floorName : floorNames) {
+                for (const auto &psd : hmi_map->getPsds(floorName)) {
+                    psdIds.push_back(psd.psdId);
+                }
             }
+            psdIdsLoaded = true;
+        }
+        if (nextTarget && !psdIds.empty()) {
+            auto it = std::find(psdIds.begin(), psdIds.end(), hmi_map->getTargetId());
+            int next = (it == psdIds.end() || it + 1 == psdIds.end()) ? psdIds.front() : *(it + 1);
+            hmi_map->setTargetId(next, psdLayers);
+        }
 
-            for (auto &vao : floorVAO.speedBumpVAOs) {
-                glBindVertexArray(vao);
-                glDrawElements(GL_LINES, 2, GL_UNSIGNED_INT, 0);
+        // 绘制列表只收集范围内且包围盒在视锥内的楼层, 其余楼层整层跳过
+        glm::mat4 viewProjection = gl_util.projectionMatrix() * gl_util.viewMatrix();
+        std::vector<LayerToggle *> drawList;
+        for (int i = 0; i < floorCount; ++i) {
+            if (!floorActive(i) || !boxVisible(viewProjection, floorLayers[i].bounds)) {
+                continue;
+            }
+            for (auto &layer : floorLayers[i].layers) {
+                if (layer.visible() && layer.loaded()) {
+                    drawList.push_back(&layer);
+                }
             }
+        }
+        for (auto *layer : drawList) {
+            layer->draw(cull);
+        }
 
-            for (std::size_t i = 0; i < floorVAO.roadVAOs.size(); ++i) {
-                size_t vao = floorVAO.roadVAOs[i];
-                size_t count = floorVAO.roadPointNums[i];
-                glBindVertexArray(vao);
-                glDrawElements(GL_LINE_STRIP, count, GL_UNSIGNED_INT, 0);
+        if (gl_util.mouseButtonPressed(GLFW_MOUSE_BUTTON_RIGHT)) {
+            auto cursor = gl_util.cursorPosition();
+            picker.request(cursor.x, cursor.y);
+        }
+        std::vector<LayerBuffer *> pickLayers;
+        for (auto *layer : drawList) {
+            pickLayers.push_back(&layer->buffer());
+        }
+        picker.render(gl_util, pickLayers);
+        PickResult picked;
+        if (picker.poll(picked)) {
+            picker.select(picked);
+            string name = "nothing";
+            for (auto &floor : floorLayers) {
+                for (auto &layer : floor.layers) {
+                    if (picked.hit && picked.buffer == &layer.buffer()) {
+                        name = layer.name() + " id " + to_string(picked.id);
+                    }
+                }
             }
+            cout << "picked " << name << endl;
         }
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-        // -------------------------------------------------------------------------------
-        glfwSwapBuffers(gl_util.window());
-        glfwPollEvents();
-    }
+        if (gl_util.keyPressed(GLFW_KEY_M)) {
+            showMinimap = !showMinimap;
+        }
+        if (showMinimap) {
+            std::vector<LayerBuffer *> minimapLayers;
+            for (int i = 0; i < floorCount; ++i) {
+                for (auto &layer : floorLayers[i].layers) {
+                    if (floorActive(i) && layer.visible() && layer.loaded()) {
+                        minimapLayers.push_back(&layer.buffer());
+                    }
+                }
+            }
+            minimap.render(gl_util, minimapLayers);
+        }
+        std::vector<const LayerBuffer *> cullLayers(pickLayers.begin(), pickLayers.end());
+        cull.start(cullLayers, viewProjection);
+    }, renderThread);
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
-    for (const auto &floorVAO : floorVAOs) {
-        glDeleteVertexArrays(floorVAO.pillarVAOs.size(), floorVAO.pillarVAOs.data());
-        glDeleteBuffers(floorVAO.pillarVertexVBOs.size(), floorVAO.pillarVertexVBOs.data());
-        glDeleteBuffers(floorVAO.pillarColorVBOs.size(), floorVAO.pillarColorVBOs.data());
-        glDeleteBuffers(floorVAO.pillarEBOs.size(), floorVAO.pillarEBOs.data());
-
-        glDeleteVertexArrays(floorVAO.psdVAOs.size(), floorVAO.psdVAOs.data());
-        glDeleteBuffers(floorVAO.psdVertexVBOs.size(), floorVAO.psdVertexVBOs.data());
-        glDeleteBuffers(floorVAO.psdColorVBOs.size(), floorVAO.psdColorVBOs.data());
-        glDeleteBuffers(floorVAO.psdEBOs.size(), floorVAO.psdEBOs.data());
-
-        glDeleteVertexArrays(floorVAO.speedBumpVAOs.size(), floorVAO.speedBumpVAOs.data());
-        glDeleteBuffers(floorVAO.speedBumpVertexVBOs.size(), floorVAO.speedBumpVertexVBOs.data());
-        glDeleteBuffers(floorVAO.speedBumpColorVBOs.size(), floorVAO.speedBumpColorVBOs.data());
-        glDeleteBuffers(floorVAO.speedBumpEBOs.size(), floorVAO.speedBumpEBOs.data());
-
-        glDeleteVertexArrays(floorVAO.roadVAOs.size(), floorVAO.roadVAOs.data());
-        glDeleteBuffers(floorVAO.roadVertexVBOs.size(), floorVAO.roadVertexVBOs.data());
-        glDeleteBuffers(floorVAO.roadColorVBOs.size(), floorVAO.roadColorVBOs.data());
-        glDeleteBuffers(floorVAO.roadEBOs.size(), floorVAO.roadEBOs.data());
+    cull.release();
+    picker.release();
+    minimap.release();
+    for (auto &floor : floorLayers) {
+        for (auto &layer : floor.layers) {
+            layer.release();
+        }
     }
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
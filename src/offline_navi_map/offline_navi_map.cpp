@@ -1,183 +1,393 @@
 #include "navi_map/navi_map.h"
+#include "navi_map/navi_map_stream.h"
 
 #include <string>
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <functional>
 
 #include "utils/sql_util.h"
 #include "utils/gl_util.h"
+#include "utils/layer_toggle.h"
+#include "utils/feature_picker.h"
+#include "utils/cull_pass.h"
+#include "utils/minimap.h"
 
 
 using namespace std;
 
-struct TotalVAO {
-
-    // 路径点
-    std::vector<unsigned int> roadVAOs;
-    std::vector<unsigned int> roadVertexVBOs;
-    std::vector<unsigned int> roadColorVBOs;
-    std::vector<unsigned int> roadPointNums;
-
-    // 路口，出入口
-    std::vector<unsigned int> poiVAOs;
-    std::vector<unsigned int> poiVertexVBOs;
-    std::vector<unsigned int> poiColorVBOs;
-    std::vector<unsigned int> poiPointNums;
-    // 减速带
-    std::vector<unsigned int> roadMarkVAOs;
-    std::vector<unsigned int> roadMarkVertexVBOs;
-    std::vector<unsigned int> roadMarkColorVBOs;
-    // 墙柱子
-    std::vector<unsigned int> roadObstacleVAOs;
-    std::vector<unsigned int> roadObstacleVertexVBOs;
-    std::vector<unsigned int> roadObstacleColorVBOs;
-    std::vector<unsigned int> roadObstaclePointNums;
-
-    // 车位
-    std::vector<unsigned int> psdVAOs;
-    std::vector<unsigned int> psdVertexVBOs;
-    std::vector<unsigned int> psdColorVBOs;
-    std::vector<unsigned int> psdEBOs;
+// 按数字键1-5切换, 隐藏超过该时间(秒)的图层释放显存
+constexpr double kLayerUnloadDelay = 10.0;
+
+enum NaviLayer {
+    ROADS,           // 路径点
+    POIS,            // 路口，出入口
+    ROAD_MARKS,      // 减速带
+    ROAD_OBSTACLES,  // 墙柱子
+    PSDS,            // 车位
+    LAYER_COUNT
 };
 
-void glGen(int objNum, std::vector<unsigned int> &VAOs, std::vector<unsigned int> &VertexVBOs, std::vector<unsigned int> &ColorVBOs) {
-    VAOs.resize(objNum);
-    VertexVBOs.resize(objNum);
-    ColorVBOs.resize(objNum);
-    glGenVertexArrays(objNum, VAOs.data());
-    glGenBuffers(objNum, VertexVBOs.data());
-    glGenBuffers(objNum, ColorVBOs.data());
-}
+const char *const kLayerNames[LAYER_COUNT] = {"roads", "pois", "road_marks", "road_obstacles", "psds"};
 
-void glDelete(std::vector<unsigned int> &VAOs, std::vector<unsigned int> &VertexVBOs, std::vector<unsigned int> &ColorVBOs) {
-    glDeleteVertexArrays(VAOs.size(), VAOs.data());
-    glDeleteBuffers(VertexVBOs.size(), VertexVBOs.data());
-    glDeleteBuffers(ColorVBOs.size(), ColorVBOs.data());
+std::array<float, 3> toArray(const glm::vec3 &v) {
+    return {v.x, v.y, v.z};
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        cout << "Usage: ./offline_navi_map <db_file> <partition_id>" << endl;
+    // --stream: 以partition_id为起始分区, 随相机移动加载相邻分区
+    // --low-memory: 上传后只保留紧凑的ENU要素数据
+    // --layers=roads,psds: 启动时可见的图层, 其余图层在首次打开时才解码上传
+    // --corridor[=width]: 启动时进入走廊模式, 只加载规划路线两侧共width米(默认30)内的要素
+    // --floors=first[-last]: 启动时只绘制该楼层区间(按高度聚类, 自下而上从0开始)
+    // --lod-distance=D: 相机距离超过D米的一排车位合并成一个轮廓绘制(默认100), 0关闭
+    // --no-indirect: 剔除结果用glMultiDraw*提交, 不使用glMultiDraw*Indirect
+    // --no-render-thread: 在主线程上处理输入和绘制, 不使用单独的渲染线程
+    // --capture=dir: 从第一帧开始把每帧写成dir下的PNG序列
+    bool streaming = false, low_memory = false, corridor = false, noIndirect = false, renderThread = true;
+    string captureDir;
+    float corridorWidth = 30.0f;
+    float lodDistance = 100.0f;
+    int floorFirst = 0, floorLast = -1;  // first > last时绘制全部楼层
+    bool visible[LAYER_COUNT] = {true, true, true, true, true};
+    bool args_ok = argc >= 3;
+    for (int i = 3; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--stream") {
+            streaming = true;
+        } else if (arg == "--low-memory") {
+            low_memory = true;
+        } else if (arg == "--no-indirect") {
+            noIndirect = true;
+        } else if (arg == "--no-render-thread") {
+            renderThread = false;
+        } else if (arg.rfind("--capture=", 0) == 0 && arg.size() > 10) {
+            captureDir = arg.substr(10);
+        } else if (arg == "--corridor") {
+            corridor = true;
+        } else if (arg.rfind("--corridor=", 0) == 0) {
+            corridor = true;
+            corridorWidth = strtof(arg.c_str() + 11, nullptr);
+            args_ok = args_ok && corridorWidth > 0.0f;
+        } else if (arg.rfind("--floors=", 0) == 0) {
+            int matched = sscanf(arg.c_str() + 9, "%d-%d", &floorFirst, &floorLast);
+            if (matched == 1) {
+                floorLast = floorFirst;
+            }
+            args_ok = args_ok && matched >= 1 && floorFirst >= 0 && floorFirst <= floorLast;
+        } else if (arg.rfind("--lod-distance=", 0) == 0) {
+            char *end = nullptr;
+            lodDistance = strtof(arg.c_str() + 15, &end);
+            args_ok = args_ok && *end == '\0' && lodDistance >= 0.0f;
+        } else if (arg.rfind("--layers=", 0) == 0) {
+            string list = "," + arg.substr(9) + ",";
+            for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+                visible[layer] = list.find("," + string(kLayerNames[layer]) + ",") != string::npos;
+            }
+        } else {
+            args_ok = false;
+        }
+    }
+    if (!args_ok) {
+        cout << "Usage: ./offline_navi_map <db_file> <partition_id> [--stream] [--low-memory] [--layers=roads,psds,...]"
+                " [--corridor[=width]] [--floors=first[-last]] [--lod-distance=D] [--no-indirect]"
+                " [--no-render-thread] [--capture=dir]" << endl;
         return 1;
     }
     string db_path = argv[1];
     int partition_id = atoi(argv[2]);
 
-    std::shared_ptr<navi_map::NaviMap> navi_map = navi_map::NaviMap::createNaviMap(db_path, partition_id,
-                                                                                   navi_map::BlobType::LOC);
+    std::shared_ptr<navi_map::NaviMapStream> stream;
+    std::shared_ptr<navi_map::NaviMap> navi_map;
+    if (streaming) {
+        stream = navi_map::NaviMapStream::createNaviMapStream(db_path, partition_id, navi_map::BlobType::LOC);
+        navi_map = stream->origin();
+    } else {
+        navi_map = navi_map::NaviMap::createNaviMap(db_path, partition_id, navi_map::BlobType::LOC, low_memory);
+    }
     auto startPoint = navi_map->getStartPoint();
     auto endPoint = navi_map->getEndPoint();
     GLUtil gl_util;
     gl_util.init(glm::vec3(startPoint[0], startPoint[1], startPoint[2] + 10),
                  glm::vec3(endPoint[0], endPoint[1], endPoint[2]));
 
-    TotalVAO totalVAO;
-    {
-        size_t objNum{};
-        objNum = navi_map->getRoads().size();
-        glGen(objNum, totalVAO.roadVAOs, totalVAO.roadVertexVBOs, totalVAO.roadColorVBOs);
-        totalVAO.roadPointNums = navi_map->bindRoadsData(
-                totalVAO.roadVAOs, totalVAO.roadVertexVBOs, totalVAO.roadColorVBOs);
-
-        objNum = navi_map->getPOI().size();
-        glGen(objNum, totalVAO.poiVAOs, totalVAO.poiVertexVBOs, totalVAO.poiColorVBOs);
-        totalVAO.poiPointNums = navi_map->bindPoiData(totalVAO.poiVAOs, totalVAO.poiVertexVBOs, totalVAO.poiColorVBOs);
-
-        objNum = navi_map->getRoadMark().size();
-        glGen(objNum, totalVAO.roadMarkVAOs, totalVAO.roadMarkVertexVBOs, totalVAO.roadMarkColorVBOs);
-        navi_map->bindRoadMarkData(totalVAO.roadMarkVAOs, totalVAO.roadMarkVertexVBOs, totalVAO.roadMarkColorVBOs);
-
-        objNum = navi_map->getRoadObstacle().size();
-        glGen(objNum, totalVAO.roadObstacleVAOs, totalVAO.roadObstacleVertexVBOs, totalVAO.roadObstacleColorVBOs);
-        totalVAO.roadObstaclePointNums = navi_map->bindRoadObstacleData(totalVAO.roadObstacleVAOs, totalVAO.roadObstacleVertexVBOs, totalVAO.roadObstacleColorVBOs);
-
-        objNum = navi_map->getParkingSpaces().size();
-        totalVAO.psdVAOs.resize(objNum);
-        totalVAO.psdVertexVBOs.resize(objNum);
-        totalVAO.psdColorVBOs.resize(objNum);
-        totalVAO.psdEBOs.resize(objNum);
-        glGenVertexArrays(objNum, totalVAO.psdVAOs.data());
-        glGenBuffers(objNum, totalVAO.psdVertexVBOs.data());
-        glGenBuffers(objNum, totalVAO.psdColorVBOs.data());
-        glGenBuffers(objNum, totalVAO.psdEBOs.data());
-        navi_map->bindPsdsData(
-                totalVAO.psdVAOs, totalVAO.psdVertexVBOs, totalVAO.psdColorVBOs, totalVAO.psdEBOs);
+    // 按G显示/隐藏从起点到目标车位的规划路线, 按V开关走廊模式; 切换目标车位时重新规划
+    LayerBuffer routeLayer;
+    bool showRoute = false;
+    auto planRoute = [&]() {
+        auto start = navi_map->getStartPoint();
+        double begin = glfwGetTime();
+        auto route = navi_map->findRouteToParkingSpace(
+                {static_cast<float>(start[0]), static_cast<float>(start[1]), static_cast<float>(start[2])},
+                navi_map->getTargetId());
+        double micros = (glfwGetTime() - begin) * 1e6;
+        if (route.found) {
+            cout << "route to " << navi_map->getTargetId() << ": " << route.length << " m, " << route.road_ids.size()
+                 << " roads, " << micros << " us" << endl;
+        } else {
+            cout << "no route to " << navi_map->getTargetId() << endl;
+        }
+        return route;
+    };
+    auto applyCorridor = [&](const navi_map::Route &route) {
+        navi_map->setCorridor(route, corridorWidth);
+        if (route.found) {
+            cout << "corridor " << corridorWidth << " m: " << navi_map->corridorFeatureCount() << " features" << endl;
+        }
+    };
+    corridor = corridor && !streaming;
+    if (corridor) {
+        applyCorridor(planRoute());
     }
 
+    // 远处的车位按排合并绘制, 按L开关. 车位和排的过滤同时考虑当前楼层区间
+    FootprintLod parkingLod;
+    bool lodEnabled = lodDistance > 0.0f && !streaming;
+    auto inFloors = [&](navi_map::SpatialLayer layer, uint32_t id) {
+        int first, last;
+        return floorFirst > floorLast || !navi_map->getFeatureFloors(layer, id, first, last) ||
+               (first <= floorLast && last >= floorFirst);
+    };
+    std::vector<FootprintCluster> parkingRows;
+    std::function<bool(const FeatureRange &)> psdFilter = [&](const FeatureRange &range) {
+        return !parkingLod.featureMerged(range.id) && inFloors(navi_map::SPATIAL_PARKING_SPACES, range.id);
+    };
+    std::function<bool(const FeatureRange &)> rowFilter = [&](const FeatureRange &range) {
+        return parkingLod.merged(range.id) &&
+               inFloors(navi_map::SPATIAL_PARKING_SPACES, parkingRows[range.id].members.front());
+    };
+    LayerToggle rowLayer("parking_rows", [&](LayerBuffer &b) {
+        parkingRows = navi_map->getParkingRows();
+        cout << "parking rows: " << parkingRows.size() << endl;
+        // 重置后全部为单独绘制, 下一次update时按距离切换并重建两个图层的批次
+        parkingLod.reset(parkingRows);
+        navi_map->bindParkingRowsData(b);
+        b.setFilter(rowFilter);
+    }, false);
+
+    // 流式模式下各分区的图层由NaviMapStream管理, 不受开关控制
+    std::vector<LayerToggle> layers;
+    if (!streaming) {
+        // 图层顺序与navi_map::SpatialLayer一致, 绑定后按当前楼层区间过滤
+        auto map = navi_map.get();
+        using Bind = void (navi_map::NaviMap::*)(LayerBuffer &);
+        auto loader = [map, &floorFirst, &floorLast](NaviLayer layer, Bind bind) {
+            return [map, layer, bind, &floorFirst, &floorLast](LayerBuffer &b) {
+                (map->*bind)(b);
+                map->setFloorFilter(static_cast<navi_map::SpatialLayer>(layer), floorFirst, floorLast, b);
+            };
+        };
+        layers.emplace_back(kLayerNames[ROADS], loader(ROADS, &navi_map::NaviMap::bindRoadsData), visible[ROADS]);
+        layers.emplace_back(kLayerNames[POIS], loader(POIS, &navi_map::NaviMap::bindPoiData), visible[POIS]);
+        layers.emplace_back(kLayerNames[ROAD_MARKS], loader(ROAD_MARKS, &navi_map::NaviMap::bindRoadMarkData),
+                            visible[ROAD_MARKS]);
+        layers.emplace_back(kLayerNames[ROAD_OBSTACLES],
+                            loader(ROAD_OBSTACLES, &navi_map::NaviMap::bindRoadObstacleData), visible[ROAD_OBSTACLES]);
+        layers.emplace_back(kLayerNames[PSDS], [&](LayerBuffer &b) {
+            navi_map->bindPsdsData(b);
+            b.setFilter(psdFilter);
+        }, visible[PSDS]);
+        rowLayer.setVisible(lodEnabled && visible[PSDS], glfwGetTime());
+        rowLayer.update(glfwGetTime(), kLayerUnloadDelay);
+        for (auto &layer : layers) {
+            layer.update(glfwGetTime(), kLayerUnloadDelay);
+        }
+        cout << "resident map data: " << navi_map->residentBytes() / 1024 << " KiB" << endl;
+    }
 
-    float lastFrame = static_cast<float>(glfwGetTime());
-    float deltaTime = 0.0f;
+    // 按T将目标车位切到下一个车位, 用于演示局部状态更新; 首次按下时才读取车位列表
+    std::vector<int> psdIds;
+    bool psdIdsLoaded = false;
+
+    // 右键拾取可见图层中的要素并高亮, 流式模式下不支持
+    FeaturePicker picker;
+    // 右上角的俯视小地图, 与主视图共用图层缓冲, 只在图层变化时重画; 按M显示/隐藏, 流式模式下不支持
+    Minimap minimap;
+    bool showMinimap = !streaming;
+    // 视锥剔除在工作线程上进行, 与交换缓冲并行, 下一帧按结果提交间接绘制命令
+    CullPass cull;
+    if (!streaming) {
+        picker.init(gl_util);
+        minimap.init();
+        cull.init(noIndirect);
+    }
 
-    while (!glfwWindowShouldClose(gl_util.window())) {
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+    if (!captureDir.empty()) {
+        gl_util.capture().startSequence(captureDir);
+    }
+    // 主线程处理输入, 以下在渲染线程上执行; 按键和相机都来自本帧的输入快照
+    gl_util.run([&]() {
+        gl_util.clear();
+        gl_util.updateTransforms();
 
-        gl_util.processInput(deltaTime);
+        // 之后可能重新加载或过滤图层, 先等上一帧的剔除完成
+        cull.wait();
+        for (int layer = 0; layer < static_cast<int>(layers.size()); ++layer) {
+            if (gl_util.keyPressed(GLFW_KEY_1 + layer)) {
+                layers[layer].toggle(glfwGetTime());
+            }
+            layers[layer].update(glfwGetTime(), kLayerUnloadDelay);
+        }
+        if (!streaming && gl_util.keyPressed(GLFW_KEY_L)) {
+            lodEnabled = !lodEnabled;
+            cout << "parking row lod: " << (lodEnabled ? "on" : "off") << endl;
+            if (!lodEnabled) {
+                parkingLod.update(toArray(gl_util.cameraPosition()), 0.0f);
+                layers[PSDS].buffer().setFilter(psdFilter);
+            }
+        }
+        if (!streaming) {
+            rowLayer.setVisible(lodEnabled && layers[PSDS].visible(), glfwGetTime());
+            rowLayer.update(glfwGetTime(), kLayerUnloadDelay);
+        }
+        // 只在有排切换细节级别时重建两个图层的绘制批次
+        if (lodEnabled && rowLayer.loaded() &&
+            parkingLod.update(toArray(gl_util.cameraPosition()), lodDistance)) {
+            layers[PSDS].buffer().setFilter(psdFilter);
+            rowLayer.buffer().setFilter(rowFilter);
+        }
 
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        gl_util.updateTransforms();
+        // 按F依次只绘制各楼层: 全部 -> 0 -> 1 -> ... -> 全部
+        if (!streaming && gl_util.keyPressed(GLFW_KEY_F)) {
+            auto floors = navi_map->getFloors();
+            if (floorFirst > floorLast) {
+                floorFirst = floorLast = 0;
+            } else if (floorFirst + 1 < static_cast<int>(floors.size())) {
+                floorFirst = floorLast = floorFirst + 1;
+            } else {
+                floorFirst = 0;
+                floorLast = -1;
+            }
+            if (floorFirst > floorLast || floors.empty()) {
+                cout << "floor: all" << endl;
+            } else {
+                cout << "floor " << floorFirst << "/" << floors.size() << ": " << floors[floorFirst].z << " m, "
+                 << floors[floorFirst].feature_count << " features" << endl;
+            }
+            for (int layer = 0; layer < PSDS; ++layer) {
+                navi_map->setFloorFilter(static_cast<navi_map::SpatialLayer>(layer), floorFirst, floorLast,
+                                         layers[layer].buffer());
+            }
+            layers[PSDS].buffer().setFilter(psdFilter);
+            rowLayer.buffer().setFilter(rowFilter);
+        }
+
+        bool nextTarget = gl_util.keyPressed(GLFW_KEY_T);
+        if (nextTarget && !psdIdsLoaded) {
+            for (const auto &psd : navi_map->getParkingSpaces()) {
+                psdIds.push_back(static_cast<int>(psd.id));
+            }
+            psdIdsLoaded = true;
+        }
+        if (nextTarget && !psdIds.empty()) {
+            auto it = std::find(psdIds.begin(), psdIds.end(), navi_map->getTargetId());
+            int next = (it == psdIds.end() || it + 1 == psdIds.end()) ? psdIds.front() : *(it + 1);
+            if (streaming) {
+                stream->setTargetId(next);
+            } else {
+                navi_map->setTargetId(next, layers[PSDS].buffer());
+            }
+        }
+        bool toggleRoute = gl_util.keyPressed(GLFW_KEY_G);
+        if (toggleRoute) {
+            showRoute = !showRoute;
+        }
+        bool toggleCorridor = !streaming && gl_util.keyPressed(GLFW_KEY_V);
+        if (toggleCorridor) {
+            corridor = !corridor;
+        }
+        bool retarget = nextTarget && !psdIds.empty();
+        if ((showRoute && (toggleRoute || retarget)) || toggleCorridor || (corridor && retarget)) {
+            auto route = planRoute();
+            if (showRoute) {
+                navi_map->bindRouteData(route, routeLayer);
+            }
+            if (toggleCorridor || (corridor && retarget)) {
+                applyCorridor(corridor ? route : navi_map::Route{});
+                // 走廊内的车位重新聚类, 排的图层先于车位加载以便车位按新的排过滤
+                rowLayer.reload();
+                rowLayer.update(glfwGetTime(), kLayerUnloadDelay);
+                for (auto &layer : layers) {
+                    layer.reload();
+                    layer.update(glfwGetTime(), kLayerUnloadDelay);
+                }
+            }
+        }
 
         {
             glPointSize(10.0f);
 
-            for (size_t i = 0; i < totalVAO.roadVAOs.size(); ++i) {
-                size_t vao = totalVAO.roadVAOs[i];
-                size_t count = totalVAO.roadPointNums[i];
-                glBindVertexArray(vao);
-                glDrawArrays(GL_LINES, 0, count);
-            }
-
-            for (size_t i = 0; i < totalVAO.poiVAOs.size(); ++i) {
-                size_t vao = totalVAO.poiVAOs[i];
-                size_t count = totalVAO.poiPointNums[i];
-                glBindVertexArray(vao);
-                if (count == 1) {
-                    glDrawArrays(GL_POINTS, 0, count);
-                } else if (count == 2) {
-                    glDrawArrays(GL_LINES, 0, count);
-                } else {
-                    glDrawArrays(GL_TRIANGLE_FAN, 0, count);
-                }
+            if (streaming) {
+                stream->update(gl_util.cameraPosition());
+                stream->draw(gl_util);
             }
-
-            for (size_t i = 0; i < totalVAO.roadMarkVAOs.size(); ++i) {
-                size_t vao = totalVAO.roadMarkVAOs[i];
-                glBindVertexArray(vao);
-                glDrawArrays(GL_LINES, 0, 2);
+            for (auto &layer : layers) {
+                layer.draw(cull);
+            }
+            rowLayer.draw(cull);
+            if (showRoute) {
+                routeLayer.draw();
             }
+        }
 
-            for (size_t i = 0; i < totalVAO.roadObstacleVAOs.size(); ++i) {
-                size_t vao = totalVAO.roadObstacleVAOs[i];
-                size_t count = totalVAO.roadObstaclePointNums[i];
-                glBindVertexArray(vao);
-                if (count == 2) {
-                    glDrawArrays(GL_LINES, 0, count);
-                } else {
-                    glDrawArrays(GL_TRIANGLE_FAN, 0, count);
+        if (!streaming) {
+            if (gl_util.mouseButtonPressed(GLFW_MOUSE_BUTTON_RIGHT)) {
+                auto cursor = gl_util.cursorPosition();
+                picker.request(cursor.x, cursor.y);
+            }
+            std::vector<LayerBuffer *> pickLayers;
+            for (auto &layer : layers) {
+                if (layer.visible() && layer.loaded()) {
+                    pickLayers.push_back(&layer.buffer());
+                }
+            }
+            if (rowLayer.visible() && rowLayer.loaded()) {
+                pickLayers.push_back(&rowLayer.buffer());
+            }
+            picker.render(gl_util, pickLayers);
+            PickResult picked;
+            if (picker.poll(picked)) {
+                picker.select(picked);
+                string name = "nothing";
+                for (auto &layer : layers) {
+                    if (picked.hit && picked.buffer == &layer.buffer()) {
+                        name = layer.name() + " id " + to_string(picked.id);
+                    }
+                }
+                if (picked.hit && picked.buffer == &rowLayer.buffer()) {
+                    name = "parking_rows id " + to_string(picked.id) + ", " +
+                           to_string(parkingRows[picked.id].members.size()) + " psds";
                 }
+                cout << "picked " << name << endl;
             }
 
-            for (auto &vao: totalVAO.psdVAOs) {
-                glBindVertexArray(vao);
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            if (gl_util.keyPressed(GLFW_KEY_M)) {
+                showMinimap = !showMinimap;
+            }
+            if (showMinimap) {
+                auto minimapLayers = pickLayers;
+                if (showRoute) {
+                    minimapLayers.push_back(&routeLayer);
+                }
+                minimap.render(gl_util, minimapLayers);
             }
-        }
 
-        glfwSwapBuffers(gl_util.window());
-        glfwPollEvents();
+            std::vector<const LayerBuffer *> cullLayers(pickLayers.begin(), pickLayers.end());
+            cull.start(cullLayers, gl_util.projectionMatrix() * gl_util.viewMatrix());
+        }
+    }, renderThread);
+
+    cull.release();
+    picker.release();
+    minimap.release();
+    routeLayer.release();
+    rowLayer.release();
+    for (auto &layer : layers) {
+        layer.release();
     }
-
-    {
-        glDelete(totalVAO.roadVAOs, totalVAO.roadVertexVBOs, totalVAO.roadColorVBOs);
-        glDelete(totalVAO.poiVAOs, totalVAO.poiVertexVBOs, totalVAO.poiColorVBOs);
-        glDelete(totalVAO.roadMarkVAOs, totalVAO.roadMarkVertexVBOs, totalVAO.roadMarkColorVBOs);
-        glDelete(totalVAO.roadObstacleVAOs, totalVAO.roadObstacleVertexVBOs, totalVAO.roadObstacleColorVBOs);
-
-        glDeleteVertexArrays(totalVAO.psdVAOs.size(), totalVAO.psdVAOs.data());
-        glDeleteBuffers(totalVAO.psdVertexVBOs.size(), totalVAO.psdVertexVBOs.data());
-        glDeleteBuffers(totalVAO.psdColorVBOs.size(), totalVAO.psdColorVBOs.data());
-        glDeleteBuffers(totalVAO.psdEBOs.size(), totalVAO.psdEBOs.data());
+    if (streaming) {
+        stream->release();
     }
 
     glfwTerminate();
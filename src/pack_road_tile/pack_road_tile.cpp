@@ -0,0 +1,117 @@
+#include <iostream>
+#include <string>
+
+#include "utils/packed_geometry.h"
+#include "utils/sql_util.h"
+
+using namespace std;
+using namespace hdmap::data::proto;
+
+// 将数据库中每个分区blob_data里的Polyline/Polygon点列改写为打包的buffer形式(格式见packed_geometry.h)
+
+namespace {
+    struct PackStats {
+        size_t shapes{};
+        size_t points{};
+    };
+
+    template<typename Points>
+    std::string packShape(const Points &shape, PackedEncoding encoding, PackStats &stats) {
+        std::vector<double> values;
+        values.reserve(shape.size() * 3);
+        for (const auto &p : shape) {
+            values.push_back(p.longitude());
+            values.push_back(p.latitude());
+            values.push_back(p.altitude());
+        }
+        stats.shapes += 1;
+        stats.points += shape.size();
+        return pack_points(values.data(), shape.size(), encoding);
+    }
+
+    void packPolyline(Polyline *line, PackedEncoding encoding, PackStats &stats) {
+        if (line->points_size() == 0) {
+            return;
+        }
+        line->set_buffer(packShape(line->points(), encoding, stats));
+        line->clear_points();
+    }
+
+    void packPolygon(Polygon *polygon, PackedEncoding encoding, PackStats &stats) {
+        if (polygon->shape_size() == 0) {
+            return;
+        }
+        polygon->set_buffer(packShape(polygon->shape(), encoding, stats));
+        polygon->clear_shape();
+    }
+
+    void packLaneGroup(LaneGroup *group, PackedEncoding encoding, PackStats &stats) {
+        for (auto &lane : *group->mutable_lanes()) {
+            packPolyline(lane.mutable_center_line(), encoding, stats);
+        }
+        for (auto &boundary_group : *group->mutable_lane_boundary_groups()) {
+            for (auto &parallel : *boundary_group.mutable_parallel_lane_boundaries()) {
+                for (auto &boundary : *parallel.mutable_sequential_lane_boundaries()) {
+                    packPolyline(boundary.mutable_geometry(), encoding, stats);
+                }
+            }
+        }
+    }
+
+    void packTile(RoadTile &tile, PackedEncoding encoding, PackStats &stats) {
+        for (auto &road : *tile.mutable_road()) {
+            packPolyline(road.mutable_road_center(), encoding, stats);
+            for (auto &group : *road.mutable_lane_group_ab()) {
+                packLaneGroup(&group, encoding, stats);
+            }
+            for (auto &group : *road.mutable_lane_group_ba()) {
+                packLaneGroup(&group, encoding, stats);
+            }
+        }
+        for (auto &intersection : *tile.mutable_intersection()) {
+            packPolygon(intersection.mutable_bound(), encoding, stats);
+            for (auto &boundary : *intersection.mutable_boundaries()) {
+                packPolyline(boundary.mutable_geometry(), encoding, stats);
+            }
+        }
+        for (auto &experience : *tile.mutable_experience_trajectory_for_lane()) {
+            for (auto &trajectory : *experience.mutable_experience_trajectory_list()) {
+                packPolyline(trajectory.mutable_geometry(), encoding, stats);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2 && !(argc == 3 && string(argv[2]) == "--raw")) {
+        cout << "Usage: ./pack_road_tile <db_file> [--raw]" << endl;
+        cout << "  默认使用DELTA_I32(约1mm精度), --raw保留原始double" << endl;
+        return 1;
+    }
+    string db_path = argv[1];
+    auto encoding = argc == 3 ? PackedEncoding::RAW_F64 : PackedEncoding::DELTA_I32;
+
+    size_t before = 0, after = 0;
+    for (int partition_id : query_partition_ids(db_path)) {
+        auto blob = query_for_blob(db_path, partition_id);
+        RoadTile tile;
+        if (!tile.ParseFromString(blob)) {
+            cerr << "partition " << partition_id << ": failed to parse blob_data, skipped" << endl;
+            continue;
+        }
+        PackStats stats;
+        packTile(tile, encoding, stats);
+        if (stats.shapes == 0) {
+            cout << "partition " << partition_id << ": nothing to pack" << endl;
+            continue;
+        }
+        auto packed = tile.SerializeAsString();
+        update_blob(db_path, partition_id, packed);
+        before += blob.size();
+        after += packed.size();
+        cout << "partition " << partition_id << ": " << stats.shapes << " shapes, " << stats.points << " points, "
+             << blob.size() << " -> " << packed.size() << " bytes" << endl;
+    }
+    cout << "total " << before << " -> " << after << " bytes" << endl;
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "camera_path.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    float distance(const std::array<float, 3> &a, const std::array<float, 3> &b) {
+        return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+    }
+}
+
+CameraPath::CameraPath(const std::vector<float> &points, float spacing, float smoothing) {
+    std::vector<std::array<float, 3>> input;
+    for (size_t i = 0; i + 2 < points.size(); i += 3) {
+        std::array<float, 3> p = {points[i], points[i + 1], points[i + 2]};
+        if (input.empty() || distance(input.back(), p) > 1e-4f) {
+            input.push_back(p);
+        }
+    }
+    if (input.size() < 2) {
+        samples_ = input;
+        distances_.assign(samples_.size(), 0.0f);
+        return;
+    }
+    std::vector<float> cumulative(input.size(), 0.0f);
+    for (size_t i = 1; i < input.size(); ++i) {
+        cumulative[i] = cumulative[i - 1] + distance(input[i - 1], input[i]);
+    }
+
+    // 按弧长等距重采样
+    size_t count = std::max<size_t>(2, static_cast<size_t>(std::ceil(cumulative.back() / spacing)) + 1);
+    float step = cumulative.back() / static_cast<float>(count - 1);
+    std::vector<std::array<float, 3>> resampled(count);
+    for (size_t i = 0, segment = 0; i < count; ++i) {
+        float s = std::min(step * static_cast<float>(i), cumulative.back());
+        while (segment + 2 < input.size() && cumulative[segment + 1] < s) {
+            ++segment;
+        }
+        float span = cumulative[segment + 1] - cumulative[segment];
+        float t = span > 0.0f ? std::clamp((s - cumulative[segment]) / span, 0.0f, 1.0f) : 0.0f;
+        for (int c = 0; c < 3; ++c) {
+            resampled[i][c] = input[segment][c] + (input[segment + 1][c] - input[segment][c]) * t;
+        }
+    }
+
+    // 对称窗口的滑动平均, 靠近端点时窗口收窄, 首尾点不动
+    auto radius = static_cast<size_t>(std::lround(smoothing / step));
+    std::vector<std::array<double, 3>> prefix(count + 1, {0.0, 0.0, 0.0});
+    for (size_t i = 0; i < count; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            prefix[i + 1][c] = prefix[i][c] + resampled[i][c];
+        }
+    }
+    samples_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        size_t k = std::min({radius, i, count - 1 - i});
+        for (int c = 0; c < 3; ++c) {
+            samples_[i][c] = static_cast<float>((prefix[i + k + 1][c] - prefix[i - k][c]) / static_cast<double>(2 * k + 1));
+        }
+    }
+    distances_.assign(count, 0.0f);
+    for (size_t i = 1; i < count; ++i) {
+        distances_[i] = distances_[i - 1] + distance(samples_[i - 1], samples_[i]);
+    }
+    length_ = distances_.back();
+}
+
+std::array<float, 3> CameraPath::at(float s) const {
+    if (samples_.empty()) {
+        return {0.0f, 0.0f, 0.0f};
+    }
+    if (samples_.size() == 1 || s <= 0.0f) {
+        return samples_.front();
+    }
+    if (s >= length_) {
+        return samples_.back();
+    }
+    size_t i = std::upper_bound(distances_.begin(), distances_.end(), s) - distances_.begin();
+    float span = distances_[i] - distances_[i - 1];
+    float t = span > 0.0f ? (s - distances_[i - 1]) / span : 0.0f;
+    std::array<float, 3> p{};
+    for (int c = 0; c < 3; ++c) {
+        p[c] = samples_[i - 1][c] + (samples_[i][c] - samples_[i - 1][c]) * t;
+    }
+    return p;
+}
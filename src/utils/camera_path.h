@@ -0,0 +1,25 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <array>
+#include <vector>
+
+// 沿折线(如规划路线)飞行的相机路径. 折线按弧长等距重采样后做滑动平均, 去掉路口处的折角,
+// 首尾点保持不动; 之后按弧长插值取点
+class CameraPath {
+  public:
+    // points为[x, y, z, ...]; spacing为重采样间距, smoothing为平滑窗口半宽, 单位均为米
+    CameraPath(const std::vector<float> &points, float spacing = 0.5f, float smoothing = 4.0f);
+
+    [[nodiscard]] float length() const { return length_; }
+    [[nodiscard]] bool empty() const { return samples_.empty(); }
+    // 弧长s处的点, s超出[0, length()]时取端点
+    [[nodiscard]] std::array<float, 3> at(float s) const;
+
+  private:
+    float length_{};
+    std::vector<std::array<float, 3>> samples_;
+    std::vector<float> distances_;  // 平滑后各采样点的累计弧长
+};
+
+#endif //CAMERA_PATH_H
@@ -0,0 +1,131 @@
+#include "cull_pass.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // 视锥各边外扩的比例(相对于w), 覆盖一帧内相机的平移和旋转
+    constexpr float kCullMargin = 0.1f;
+    // 间接命令环形缓冲的初始容量, 3段每段1MB约容纳5万个索引绘制命令; 一帧写不下时加倍
+    constexpr size_t kCommandCapacity = 3 << 20;
+    constexpr size_t kCommandSegments = 3;
+}
+
+CullPass::~CullPass() {
+    if (worker_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+}
+
+void CullPass::init(bool forceFallback) {
+    indirect_ = !forceFallback && GLAD_GL_VERSION_4_3 && glMultiDrawElementsIndirect != nullptr &&
+                glMultiDrawArraysIndirect != nullptr;
+    std::cout << "cull pass: " << (indirect_ ? "glMultiDraw*Indirect" : "glMultiDraw* fallback") << std::endl;
+    if (indirect_) {
+        commands_.init(GL_DRAW_INDIRECT_BUFFER, kCommandCapacity, kCommandSegments);
+        frame_bytes_ = 0;
+    }
+    if (!worker_.joinable()) {
+        worker_ = std::thread(&CullPass::run, this);
+    }
+}
+
+void CullPass::start(const std::vector<const LayerBuffer *> &layers, const glm::mat4 &viewProjection) {
+    if (commands_.buffer() != 0) {
+        commands_.endFrame();
+        frame_bytes_ = 0;
+    }
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        layers_ = layers;
+        view_projection_ = viewProjection;
+        busy_ = true;
+    }
+    cv_.notify_all();
+}
+
+void CullPass::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !busy_; });
+}
+
+void CullPass::draw(LayerBuffer &layer) {
+    auto it = results_.find(&layer);
+    if (it == results_.end()) {
+        layer.draw();
+        return;
+    }
+    const auto &commands = it->second;
+    if (!commands.indirect || commands.words.empty()) {
+        layer.draw(commands);
+        return;
+    }
+    size_t bytes = commands.words.size() * sizeof(uint32_t);
+    if (frame_bytes_ + bytes > commands_.segmentSize()) {
+        // 本帧之前提交的绘制仍引用旧缓冲, 删除由驱动推迟到其不再使用
+        size_t capacity = commands_.segmentSize() * kCommandSegments;
+        while (capacity / kCommandSegments < frame_bytes_ + bytes + 256) {  // 段大小按256字节向下对齐
+            capacity *= 2;
+        }
+        std::cout << "cull pass: indirect command buffer grown to " << capacity / 1024 << " KiB" << std::endl;
+        commands_.init(GL_DRAW_INDIRECT_BUFFER, capacity, kCommandSegments);
+    }
+    auto allocation = commands_.allocate(bytes, sizeof(uint32_t));
+    if (allocation.ptr == nullptr) {
+        layer.draw();
+        return;
+    }
+    std::memcpy(allocation.ptr, commands.words.data(), bytes);
+    commands_.commit(allocation);
+    frame_bytes_ += bytes;
+    layer.draw(commands, commands_.buffer(), allocation.offset);
+}
+
+void CullPass::release() {
+    wait();
+    commands_.release();
+}
+
+size_t CullPass::visibleCount() const {
+    size_t count = 0;
+    for (const auto &result : results_) {
+        count += result.second.visible;
+    }
+    return count;
+}
+
+size_t CullPass::totalCount() const {
+    size_t count = 0;
+    for (const auto &result : results_) {
+        count += result.second.total;
+    }
+    return count;
+}
+
+void CullPass::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return busy_ || quit_; });
+        if (quit_) {
+            return;
+        }
+        // busy_期间渲染线程不访问layers_和results_, 解锁后剔除
+        lock.unlock();
+        for (auto it = results_.begin(); it != results_.end();) {
+            it = std::find(layers_.begin(), layers_.end(), it->first) == layers_.end() ? results_.erase(it)
+                                                                                        : std::next(it);
+        }
+        for (const auto *layer : layers_) {
+            layer->cull(view_projection_, kCullMargin, indirect_, results_[layer]);
+        }
+        lock.lock();
+        busy_ = false;
+        cv_.notify_all();
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef CULL_PASS_H
+#define CULL_PASS_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "gl_util.h"
+#include "layer_buffer.h"
+
+// 在工作线程上为各图层做视锥剔除并生成间接绘制命令. 每帧提交后用本帧的相机start(), 剔除与
+// 交换缓冲/下一帧的输入处理并行, 下一帧按其结果绘制, 因此视锥外扩kCullMargin容忍一帧的相机移动.
+// 渲染线程每个批次只做一次glMultiDraw*Indirect, 与要素数无关; 各图层的间接命令依次写入共用的StreamBuffer,
+// 不为每个图层每帧重新分配缓冲. 与LayerBuffer一样不在析构时释放GL对象, 需显式调用release()
+class CullPass {
+  public:
+    CullPass() = default;
+    CullPass(const CullPass &) = delete;
+    CullPass &operator=(const CullPass &) = delete;
+    ~CullPass();
+
+    // 需要GL上下文: GL 4.3以上使用glMultiDraw*Indirect, 否则回退到glMultiDraw*; forceFallback用于对比测试
+    void init(bool forceFallback = false);
+    [[nodiscard]] bool indirect() const { return indirect_; }
+
+    // 每帧提交后调用: 结束本帧的间接命令段, 在工作线程上剔除layers, 先等待上一次剔除完成
+    void start(const std::vector<const LayerBuffer *> &layers, const glm::mat4 &viewProjection);
+    // 等待剔除完成. 修改已提交的图层(upload/setFilter/release等)之前必须调用
+    void wait();
+    // 有该图层的剔除结果时按结果绘制, 否则(新加载的图层等)按全部批次绘制
+    void draw(LayerBuffer &layer);
+    // 需要GL上下文, 先等待剔除完成
+    void release();
+
+    // 上一次剔除后可见的要素数与要素总数
+    [[nodiscard]] size_t visibleCount() const;
+    [[nodiscard]] size_t totalCount() const;
+
+  private:
+    void run();
+
+    bool indirect_{false};
+    StreamBuffer commands_;       // 间接命令的环形缓冲, 每帧一段
+    size_t frame_bytes_{};        // 本帧已写入commands_的字节数
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool busy_{false};
+    bool quit_{false};
+    std::vector<const LayerBuffer *> layers_;
+    glm::mat4 view_projection_{1.0f};
+    std::unordered_map<const LayerBuffer *, DrawCommands> results_;
+};
+
+#endif //CULL_PASS_H
@@ -0,0 +1,239 @@
+#include "feature_picker.h"
+#include "gl_util.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace {
+    const char *kPickVertex = R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in uint aFeature;
+
+flat out uint featureId;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform uint layerTag;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    featureId = (layerTag << 24) | aFeature;
+})";
+
+    const char *kPickFragment = R"(#version 330 core
+flat in uint featureId;
+out uint pickId;
+
+void main()
+{
+    pickId = featureId;
+})";
+
+    // 与add()时uniforms的顺序一致
+    enum PickUniform { U_MODEL, U_VIEW, U_PROJECTION, U_LAYER_TAG };
+
+    constexpr uint32_t kFeatureMask = 0xFFFFFFu;
+}
+
+bool FeaturePicker::init(GLUtil &gl_util) {
+    program_ = gl_util.shaders().add("pick", kPickVertex, kPickFragment, {"model", "view", "projection", "layerTag"});
+
+    glGenTextures(1, &color_);
+    glBindTexture(GL_TEXTURE_2D, color_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, kSize, kSize, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, kSize, kSize);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (!complete) {
+        std::cerr << "FeaturePicker: pick framebuffer incomplete, picking disabled" << std::endl;
+        release();
+        return false;
+    }
+
+    for (auto &slot : slots_) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, kSize * kSize * sizeof(uint32_t), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    inited_ = true;
+    return true;
+}
+
+void FeaturePicker::request(double x, double y) {
+    x_ = x;
+    y_ = y;
+    pending_ = true;
+}
+
+void FeaturePicker::render(GLUtil &gl_util, const std::vector<LayerBuffer *> &layers) {
+    if (!inited_ || !pending_) {
+        return;
+    }
+    auto &slot = slots_[next_slot_];
+    if (slot.fence != nullptr) {
+        // 读回都还在途中, 请求留到下一帧
+        return;
+    }
+    pending_ = false;
+
+    int width = gl_util.windowSize().x, height = gl_util.windowSize().y;
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    // 把光标处kSize x kSize像素的窗口放大到整个裁剪空间
+    float ndcX = static_cast<float>(2.0 * x_ / width - 1.0);
+    float ndcY = static_cast<float>(1.0 - 2.0 * y_ / height);
+    float scaleX = static_cast<float>(width) / kSize;
+    float scaleY = static_cast<float>(height) / kSize;
+    glm::mat4 pick(1.0f);
+    pick[0][0] = scaleX;
+    pick[1][1] = scaleY;
+    pick[3][0] = -ndcX * scaleX;
+    pick[3][1] = -ndcY * scaleY;
+    glm::mat4 projection = pick * gl_util.projectionMatrix();
+    glm::mat4 model(1.0f);
+
+    GLint previousFbo = 0, viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, kSize, kSize);
+    const GLuint zero[4] = {0, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, zero);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    auto &shaders = gl_util.shaders();
+    shaders.use(program_);
+    glUniformMatrix4fv(shaders.uniform(program_, U_MODEL), 1, GL_FALSE, &model[0][0]);
+    glUniformMatrix4fv(shaders.uniform(program_, U_VIEW), 1, GL_FALSE, &gl_util.viewMatrix()[0][0]);
+    glUniformMatrix4fv(shaders.uniform(program_, U_PROJECTION), 1, GL_FALSE, &projection[0][0]);
+    size_t count = std::min<size_t>(layers.size(), 255);
+    for (size_t i = 0; i < count; ++i) {
+        glUniform1ui(shaders.uniform(program_, U_LAYER_TAG), static_cast<GLuint>(i + 1));
+        layers[i]->drawPick();
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glReadPixels(0, 0, kSize, kSize, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.layers.assign(layers.begin(), layers.begin() + static_cast<std::ptrdiff_t>(count));
+    next_slot_ = (next_slot_ + 1) % kSlots;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+bool FeaturePicker::poll(PickResult &result) {
+    if (!inited_) {
+        return false;
+    }
+    auto &slot = slots_[oldest_slot_];
+    if (slot.fence == nullptr) {
+        return false;
+    }
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    oldest_slot_ = (oldest_slot_ + 1) % kSlots;
+
+    // 取离窗口中心最近的非零像素
+    uint32_t value = 0;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    auto pixels = static_cast<const uint32_t *>(
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, kSize * kSize * sizeof(uint32_t), GL_MAP_READ_BIT));
+    if (pixels) {
+        int best = std::numeric_limits<int>::max();
+        for (int y = 0; y < kSize; ++y) {
+            for (int x = 0; x < kSize; ++x) {
+                uint32_t pixel = pixels[y * kSize + x];
+                int distance = (x - kRadius) * (x - kRadius) + (y - kRadius) * (y - kRadius);
+                if (pixel != 0 && distance < best) {
+                    best = distance;
+                    value = pixel;
+                }
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    result = PickResult{};
+    uint32_t layer = value >> 24;
+    uint32_t feature = value & kFeatureMask;
+    // 读回期间图层可能已被卸载或重新上传, 越界时视为未命中
+    if (layer != 0 && layer <= slot.layers.size() && feature != 0) {
+        auto buffer = slot.layers[layer - 1];
+        if (feature <= buffer->ranges().size()) {
+            result.hit = true;
+            result.layer = layer - 1;
+            result.buffer = buffer;
+            result.id = buffer->ranges()[feature - 1].id;
+        }
+    }
+    slot.layers.clear();
+    return true;
+}
+
+void FeaturePicker::select(const PickResult &result) {
+    // 选中期间状态被其他逻辑(如切换目标车位)改掉时不再覆盖
+    if (selected_.hit && selected_.buffer->getFeatureState(selected_.id) == style::SELECTED) {
+        selected_.buffer->setFeatureState(selected_.id, selected_state_);
+    }
+    selected_ = PickResult{};
+    if (!result.hit) {
+        return;
+    }
+    selected_ = result;
+    selected_state_ = result.buffer->getFeatureState(result.id);
+    result.buffer->setFeatureState(result.id, style::SELECTED);
+}
+
+void FeaturePicker::release() {
+    for (auto &slot : slots_) {
+        if (slot.fence != nullptr) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        if (slot.pbo != 0) {
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+        slot.layers.clear();
+    }
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+    }
+    if (color_ != 0) {
+        glDeleteTextures(1, &color_);
+    }
+    if (depth_ != 0) {
+        glDeleteRenderbuffers(1, &depth_);
+    }
+    fbo_ = color_ = depth_ = 0;
+    next_slot_ = oldest_slot_ = 0;
+    pending_ = false;
+    inited_ = false;
+    selected_ = PickResult{};
+}
@@ -0,0 +1,68 @@
+#ifndef FEATURE_PICKER_H
+#define FEATURE_PICKER_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include "layer_buffer.h"
+
+class GLUtil;
+
+struct PickResult {
+    bool hit{false};
+    size_t layer{};                 // render()传入的layers中的下标
+    LayerBuffer *buffer = nullptr;
+    uint32_t id{};                  // 要素id
+};
+
+// GPU拾取: 把光标附近的小窗口以"图层序号<<24 | 要素下标+1"绘制到R32UI渲染目标,
+// 通过PBO + fence异步读回, 结果在一到两帧后由poll()取得, 不会让CPU等待GPU.
+// 另外维护一个选中要素, 用LayerBuffer的要素状态高亮为SELECTED.
+// 与LayerBuffer一样不在析构时释放GL对象, 需显式调用release().
+class FeaturePicker {
+  public:
+    // 读回窗口为(2 * kRadius + 1)^2像素, 便于选中细线和点
+    static constexpr int kRadius = 2;
+    static constexpr int kSize = 2 * kRadius + 1;
+
+    FeaturePicker() = default;
+    FeaturePicker(const FeaturePicker &) = delete;
+    FeaturePicker &operator=(const FeaturePicker &) = delete;
+
+    bool init(GLUtil &gl_util);
+    // 请求拾取窗口坐标(x, y)处的要素, 在下一次render()时执行
+    void request(double x, double y);
+    // 每帧在主绘制之后调用, 有请求时绘制拾取帧并发起读回; layers不超过255个
+    void render(GLUtil &gl_util, const std::vector<LayerBuffer *> &layers);
+    // 最早的读回已完成时返回true; 未命中时result.hit为false
+    bool poll(PickResult &result);
+
+    // 恢复上一个选中要素的状态, 并把result对应的要素设为SELECTED; 未命中时只取消选中
+    void select(const PickResult &result);
+    [[nodiscard]] const PickResult &selected() const { return selected_; }
+
+    void release();
+
+  private:
+    static constexpr size_t kSlots = 3;
+
+    struct Slot {
+        GLuint pbo{};
+        GLsync fence{};
+        std::vector<LayerBuffer *> layers;  // 发起读回时的图层, poll()时用来解析要素id
+    };
+
+    bool inited_{false};
+    GLuint fbo_{}, color_{}, depth_{};
+    size_t program_{};
+    Slot slots_[kSlots];
+    size_t next_slot_{};                    // 下一个可用的槽, 按发起顺序循环使用
+    size_t oldest_slot_{};                  // 最早发起且未取回的槽
+    bool pending_{false};
+    double x_{}, y_{};
+
+    PickResult selected_{};
+    uint8_t selected_state_{};              // 选中前的状态, 取消选中时恢复
+};
+
+#endif //FEATURE_PICKER_H
@@ -0,0 +1,209 @@
+#include "footprint_lod.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+    // 垂直方向的投影重叠不少于较窄一方的该比例才算同一排, 排除只在角上相碰的斜对角要素
+    constexpr float kMinOverlap = 0.5f;
+    // 沿排方向的间隙也可以达到较窄一方宽度的该倍数, 车位之间常夹着柱子
+    constexpr float kGapRatio = 1.5f;
+
+    struct Box {
+        float lo[2], hi[2];
+        float z;
+    };
+
+    uint32_t findRoot(std::vector<uint32_t> &parent, uint32_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    // 沿axis方向连接相邻的要素, 返回每个要素所在排的根
+    std::vector<uint32_t> linkRows(const std::vector<Box> &boxes, int axis, float gap, float max_dz) {
+        int other = 1 - axis;
+        std::vector<uint32_t> parent(boxes.size());
+        std::iota(parent.begin(), parent.end(), 0u);
+        std::vector<uint32_t> order(parent);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return boxes[a].lo[axis] < boxes[b].lo[axis];
+        });
+        for (size_t i = 0; i < order.size(); ++i) {
+            const auto &a = boxes[order[i]];
+            float reach = std::max(gap, kGapRatio * (a.hi[axis] - a.lo[axis]));
+            for (size_t j = i + 1; j < order.size() && boxes[order[j]].lo[axis] <= a.hi[axis] + reach; ++j) {
+                const auto &b = boxes[order[j]];
+                float spacing = b.lo[axis] - a.hi[axis];
+                float overlap = std::min(a.hi[other], b.hi[other]) - std::max(a.lo[other], b.lo[other]);
+                float narrow = std::min(a.hi[other] - a.lo[other], b.hi[other] - b.lo[other]);
+                if (spacing > std::max(gap, kGapRatio * std::min(a.hi[axis] - a.lo[axis], b.hi[axis] - b.lo[axis])) ||
+                    std::fabs(a.z - b.z) > max_dz || overlap < kMinOverlap * narrow) {
+                    continue;
+                }
+                parent[findRoot(parent, order[i])] = findRoot(parent, order[j]);
+            }
+        }
+        for (uint32_t i = 0; i < parent.size(); ++i) {
+            parent[i] = findRoot(parent, i);
+        }
+        return parent;
+    }
+
+    double cross(const std::array<double, 2> &o, const std::array<double, 2> &a, const std::array<double, 2> &b) {
+        return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+    }
+
+    // Andrew单调链, 逆时针, 不含共线点
+    std::vector<std::array<double, 2>> convexHull(std::vector<std::array<double, 2>> points) {
+        std::sort(points.begin(), points.end());
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+        if (points.size() < 3) {
+            return points;
+        }
+        std::vector<std::array<double, 2>> hull(points.size() * 2);
+        size_t k = 0;
+        for (const auto &p : points) {
+            while (k >= 2 && cross(hull[k - 2], hull[k - 1], p) <= 0.0) {
+                --k;
+            }
+            hull[k++] = p;
+        }
+        for (size_t i = points.size() - 1, lower = k + 1; i-- > 0;) {
+            while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0) {
+                --k;
+            }
+            hull[k++] = points[i];
+        }
+        hull.resize(k - 1);
+        return hull;
+    }
+}
+
+std::vector<FootprintCluster> cluster_footprints(const std::vector<const std::vector<float> *> &polygons,
+                                                 float gap, float max_dz) {
+    // 网格方向: 边方向角的4倍按边长加权平均, 相互垂直的边方向一致
+    double c = 0.0, s = 0.0;
+    for (const auto *polygon : polygons) {
+        size_t n = polygon->size() / 3;
+        for (size_t i = 0; i < n; ++i) {
+            const float *p = polygon->data() + i * 3, *q = polygon->data() + (i + 1) % n * 3;
+            double dx = q[0] - p[0], dy = q[1] - p[1];
+            double length = std::hypot(dx, dy);
+            double angle = std::atan2(dy, dx) * 4.0;
+            c += std::cos(angle) * length;
+            s += std::sin(angle) * length;
+        }
+    }
+    double axis = std::atan2(s, c) / 4.0;
+    auto cos_a = static_cast<float>(std::cos(axis)), sin_a = static_cast<float>(std::sin(axis));
+
+    std::vector<Box> boxes(polygons.size());
+    for (size_t i = 0; i < polygons.size(); ++i) {
+        auto &box = boxes[i];
+        const auto &points = *polygons[i];
+        box.lo[0] = box.lo[1] = INFINITY;
+        box.hi[0] = box.hi[1] = -INFINITY;
+        box.z = 0.0f;
+        size_t n = points.size() / 3;
+        for (size_t k = 0; k < n; ++k) {
+            float x = points[k * 3], y = points[k * 3 + 1];
+            float uv[2] = {x * cos_a + y * sin_a, -x * sin_a + y * cos_a};
+            for (int d = 0; d < 2; ++d) {
+                box.lo[d] = std::min(box.lo[d], uv[d]);
+                box.hi[d] = std::max(box.hi[d], uv[d]);
+            }
+            box.z += points[k * 3 + 2] / static_cast<float>(n);
+        }
+    }
+
+    std::vector<uint32_t> roots[2] = {linkRows(boxes, 0, gap, max_dz), linkRows(boxes, 1, gap, max_dz)};
+    auto rowCount = [](std::vector<uint32_t> r) {
+        std::sort(r.begin(), r.end());
+        return std::unique(r.begin(), r.end()) - r.begin();
+    };
+    const auto &root = rowCount(roots[0]) <= rowCount(roots[1]) ? roots[0] : roots[1];
+
+    std::vector<std::vector<uint32_t>> rows(polygons.size());
+    for (uint32_t i = 0; i < root.size(); ++i) {
+        rows[root[i]].push_back(i);
+    }
+    std::vector<FootprintCluster> clusters;
+    for (auto &members : rows) {
+        if (members.size() < 2) {
+            continue;
+        }
+        FootprintCluster cluster;
+        std::vector<std::array<double, 2>> points;
+        float z = 0.0f;
+        for (uint32_t i : members) {
+            const auto &polygon = *polygons[i];
+            for (size_t k = 0; k + 2 < polygon.size(); k += 3) {
+                points.push_back({polygon[k], polygon[k + 1]});
+            }
+            z += boxes[i].z / static_cast<float>(members.size());
+        }
+        for (const auto &p : convexHull(std::move(points))) {
+            cluster.footprint.insert(cluster.footprint.end(), {static_cast<float>(p[0]), static_cast<float>(p[1]), z});
+        }
+        fit_cluster_bounds(cluster);
+        cluster.members = std::move(members);
+        clusters.push_back(std::move(cluster));
+    }
+    return clusters;
+}
+
+void fit_cluster_bounds(FootprintCluster &cluster) {
+    size_t n = cluster.footprint.size() / 3;
+    cluster.center = {0.0f, 0.0f, 0.0f};
+    cluster.radius = 0.0f;
+    if (n == 0) {
+        return;
+    }
+    for (size_t k = 0; k < n; ++k) {
+        cluster.center[0] += cluster.footprint[k * 3];
+        cluster.center[1] += cluster.footprint[k * 3 + 1];
+    }
+    cluster.center = {cluster.center[0] / static_cast<float>(n), cluster.center[1] / static_cast<float>(n),
+                      cluster.footprint[2]};
+    for (size_t k = 0; k < n; ++k) {
+        cluster.radius = std::max(cluster.radius, std::hypot(cluster.footprint[k * 3] - cluster.center[0],
+                                                             cluster.footprint[k * 3 + 1] - cluster.center[1]));
+    }
+}
+
+void FootprintLod::reset(const std::vector<FootprintCluster> &clusters) {
+    spheres_.clear();
+    feature_cluster_.clear();
+    for (uint32_t i = 0; i < clusters.size(); ++i) {
+        const auto &cluster = clusters[i];
+        spheres_.push_back({cluster.center[0], cluster.center[1], cluster.center[2], cluster.radius});
+        for (uint32_t id : cluster.members) {
+            feature_cluster_.emplace(id, i);
+        }
+    }
+    merged_.assign(clusters.size(), 0);
+}
+
+bool FootprintLod::update(const std::array<float, 3> &eye, float distance) {
+    bool changed = false;
+    for (size_t i = 0; i < spheres_.size(); ++i) {
+        const auto &sphere = spheres_[i];
+        float dx = eye[0] - sphere[0], dy = eye[1] - sphere[1], dz = eye[2] - sphere[2];
+        char merged = distance > 0.0f && std::sqrt(dx * dx + dy * dy + dz * dz) - sphere[3] > distance;
+        changed = changed || merged != merged_[i];
+        merged_[i] = merged;
+    }
+    return changed;
+}
+
+bool FootprintLod::featureMerged(uint32_t id) const {
+    auto it = feature_cluster_.find(id);
+    return it != feature_cluster_.end() && merged_[it->second];
+}
+
+size_t FootprintLod::mergedCount() const {
+    return static_cast<size_t>(std::count(merged_.begin(), merged_.end(), 1));
+}
@@ -0,0 +1,46 @@
+#ifndef FOOTPRINT_LOD_H
+#define FOOTPRINT_LOD_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// 一排相邻要素(车位, 柱子)合并后的轮廓
+struct FootprintCluster {
+    std::vector<uint32_t> members;   // cluster_footprints返回输入下标, 地图接口返回要素id
+    std::vector<float> footprint;    // 成员所有顶点的水平凸包, [x, y, z, ...]逆时针不闭合, z为成员平均高度
+    std::array<float, 3> center{};
+    float radius{};                  // 包围球半径
+};
+
+// 按排聚类多边形. 先由边的方向估计整体的网格方向, 在该方向上成员沿排方向的间隙不超过gap(或较窄一方宽度的1.5倍),
+// 垂直方向的投影相互重叠且平均高度相差不超过max_dz时归为一排; 两个网格方向各聚一次, 取排数较少的方向.
+// 背靠背的车位, 相邻排的柱子不会被并到一起. 只返回至少两个成员的排
+std::vector<FootprintCluster> cluster_footprints(const std::vector<const std::vector<float> *> &polygons,
+                                                 float gap, float max_dz);
+
+// 由footprint计算center(z取轮廓高度)和radius, 从缓存恢复的排与聚类结果一致
+void fit_cluster_bounds(FootprintCluster &cluster);
+
+// 按相机距离在单个要素与所在排的合并轮廓之间切换, 不属于任何排的要素总是单独绘制
+class FootprintLod {
+  public:
+    // clusters的members为要素id, 簇的下标即合并轮廓的要素id
+    void reset(const std::vector<FootprintCluster> &clusters);
+
+    // 相机到包围球的距离超过distance的排改用合并轮廓, distance <= 0时全部单独绘制. 有排切换时返回true
+    bool update(const std::array<float, 3> &eye, float distance);
+
+    [[nodiscard]] bool merged(uint32_t cluster) const { return cluster < merged_.size() && merged_[cluster]; }
+    [[nodiscard]] bool featureMerged(uint32_t id) const;
+    [[nodiscard]] size_t mergedCount() const;
+
+  private:
+    std::vector<std::array<float, 4>> spheres_;  // center, radius
+    std::vector<char> merged_;
+    std::unordered_map<uint32_t, uint32_t> feature_cluster_;
+};
+
+#endif //FOOTPRINT_LOD_H
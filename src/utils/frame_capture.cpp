@@ -0,0 +1,307 @@
+#include "frame_capture.h"
+#include "png_writer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // 每个编码线程最多排队的帧数, 编码跟不上时渲染线程等待, 避免内存无限增长(每帧约7MB)
+    constexpr size_t kQueuePerWorker = 4;
+    constexpr int kPngLevel = 1;
+
+    double secondsSince(std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    void waitFence(GLsync fence) {
+        GLenum result;
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+}
+
+FrameCapture::~FrameCapture() {
+    closePipe();
+    if (workers_.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+void FrameCapture::screenshot(const std::string &path) {
+    screenshot_path_ = path;
+}
+
+void FrameCapture::startSequence(const std::string &directory) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec) {
+        std::cerr << "capture: cannot create " << directory << ": " << ec.message() << std::endl;
+        return;
+    }
+    directory_ = directory;
+    sequence_frame_ = 0;
+    recording_ = true;
+    std::cout << "capture: recording to " << directory_ << std::endl;
+}
+
+void FrameCapture::stopSequence() {
+    if (recording_) {
+        std::cout << "capture: " << sequence_frame_ << " frames to " << directory_ << std::endl;
+    }
+    recording_ = false;
+}
+
+bool FrameCapture::startPipe(const std::string &command) {
+    if (pipe_ != nullptr) {
+        std::cerr << "capture: pipe already open" << std::endl;
+        return false;
+    }
+    pipe_ = popen(command.c_str(), "w");
+    if (pipe_ == nullptr) {
+        std::cerr << "capture: cannot start " << command << std::endl;
+        return false;
+    }
+    pipe_quit_ = false;
+    pipe_writer_ = std::thread(&FrameCapture::writePipe, this);
+    piping_ = true;
+    return true;
+}
+
+void FrameCapture::capture(int width, int height) {
+    // 先按从旧到新回收已完成的读回, 不等待; 遇到未完成的槽即停止, 保证帧按提交顺序写出
+    for (size_t i = 0; i < kSlots; ++i) {
+        auto &slot = slots_[(head_ + i) % kSlots];
+        if (slot.fence != nullptr) {
+            GLenum result = glClientWaitSync(slot.fence, 0, 0);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+                break;
+            }
+            retire(slot);
+        }
+    }
+
+    std::vector<std::string> paths;
+    if (!screenshot_path_.empty()) {
+        paths.push_back(std::move(screenshot_path_));
+        screenshot_path_.clear();
+    }
+    if (recording_) {
+        char name[32];
+        snprintf(name, sizeof(name), "frame_%06zu.png", sequence_frame_++);
+        paths.push_back((fs::path(directory_) / name).string());
+    }
+    if ((paths.empty() && !piping_) || width <= 0 || height <= 0) {
+        return;
+    }
+    if (workers_.empty() && !paths.empty()) {
+        startWorkers();
+    }
+
+    auto &slot = slots_[head_];
+    if (slot.fence != nullptr) {
+        // 环中的读回都还在途中, 只能等最旧的一个
+        auto begin = std::chrono::steady_clock::now();
+        waitFence(slot.fence);
+        retire(slot);
+        stall_seconds_ += secondsSince(begin);
+    }
+    size_t size = static_cast<size_t>(width) * height * 4;
+    if (slot.pbo == 0) {
+        glGenBuffers(1, &slot.pbo);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.size != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
+        slot.size = size;
+    }
+    // 目标是PBO时glReadPixels只提交拷贝命令, 立即返回
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.paths = std::move(paths);
+    slot.pipe = piping_;
+    head_ = (head_ + 1) % kSlots;
+}
+
+void FrameCapture::flush() {
+    for (size_t i = 0; i < kSlots; ++i) {
+        auto &slot = slots_[(head_ + i) % kSlots];
+        if (slot.fence != nullptr) {
+            waitFence(slot.fence);
+            retire(slot);
+        }
+    }
+}
+
+void FrameCapture::release() {
+    flush();
+    for (auto &slot : slots_) {
+        if (slot.pbo != 0) {
+            glDeleteBuffers(1, &slot.pbo);
+        }
+        slot.pbo = 0;
+        slot.size = 0;
+    }
+    if (!piping_) {
+        closePipe();
+    }
+}
+
+void FrameCapture::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return jobs_.empty() && pipe_jobs_.empty() && active_ == 0; });
+}
+
+size_t FrameCapture::writtenCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+}
+
+void FrameCapture::retire(Slot &slot) {
+    Job job;
+    job.paths = std::move(slot.paths);
+    job.width = slot.width;
+    job.height = slot.height;
+    size_t size = static_cast<size_t>(slot.width) * slot.height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const auto *data = static_cast<const uint8_t *>(
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT));
+    if (data != nullptr) {
+        job.pixels.assign(data, data + size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    slot.paths.clear();
+    bool pipe = slot.pipe && pipe_ != nullptr;
+    slot.pipe = false;
+    if (data == nullptr) {
+        std::cerr << "capture: failed to map pixel buffer" << std::endl;
+        return;
+    }
+
+    // 队列满时等待, 编码线程和管道线程都从队列中取走任务后通知done_cv_
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto enqueue = [&](std::deque<Job> &queue, size_t limit, Job &&item) {
+        if (queue.size() >= limit) {
+            auto begin = std::chrono::steady_clock::now();
+            done_cv_.wait(lock, [&] { return queue.size() < limit; });
+            stall_seconds_ += secondsSince(begin);
+        }
+        queue.push_back(std::move(item));
+        cv_.notify_all();
+    };
+    if (pipe) {
+        Job piped;
+        piped.width = job.width;
+        piped.height = job.height;
+        piped.pixels = job.paths.empty() ? std::move(job.pixels) : job.pixels;
+        enqueue(pipe_jobs_, kQueuePerWorker, std::move(piped));
+    }
+    if (!job.paths.empty()) {
+        enqueue(jobs_, kQueuePerWorker * workers_.size(), std::move(job));
+    }
+}
+
+void FrameCapture::startWorkers() {
+    size_t count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    for (size_t i = 0; i < std::max<size_t>(count, 1); ++i) {
+        workers_.emplace_back(&FrameCapture::work, this);
+    }
+}
+
+void FrameCapture::closePipe() {
+    if (pipe_ == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pipe_quit_ = true;
+    }
+    cv_.notify_all();
+    pipe_writer_.join();
+    int status = pclose(pipe_);
+    pipe_ = nullptr;
+    piping_ = false;
+    if (status != 0) {
+        std::cerr << "capture: encoder exited with status " << status << std::endl;
+    }
+}
+
+void FrameCapture::writePipe() {
+    std::vector<uint8_t> row;
+    bool failed = false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return !pipe_jobs_.empty() || pipe_quit_; });
+        if (pipe_jobs_.empty()) {
+            return;
+        }
+        Job job = std::move(pipe_jobs_.front());
+        pipe_jobs_.pop_front();
+        ++active_;
+        done_cv_.notify_all();
+        lock.unlock();
+        // 读回的行自下而上且带alpha, 编码器需要自上而下的rgb24
+        row.resize(static_cast<size_t>(job.width) * 3);
+        for (int y = job.height - 1; y >= 0 && !failed; --y) {
+            const uint8_t *src = job.pixels.data() + static_cast<size_t>(y) * job.width * 4;
+            for (int x = 0; x < job.width; ++x) {
+                row[x * 3] = src[x * 4];
+                row[x * 3 + 1] = src[x * 4 + 1];
+                row[x * 3 + 2] = src[x * 4 + 2];
+            }
+            if (fwrite(row.data(), 1, row.size(), pipe_) != row.size()) {
+                std::cerr << "capture: encoder pipe closed, dropping frames" << std::endl;
+                failed = true;
+            }
+        }
+        lock.lock();
+        written_ += failed ? 0 : 1;
+        --active_;
+        done_cv_.notify_all();
+    }
+}
+
+void FrameCapture::work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return !jobs_.empty() || quit_; });
+        if (jobs_.empty()) {
+            return;  // 退出前先写完队列中的帧
+        }
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        ++active_;
+        done_cv_.notify_all();
+        lock.unlock();
+        size_t written = 0;
+        for (const auto &path : job.paths) {
+            if (write_png_rgb(path, job.width, job.height, job.pixels.data(), kPngLevel)) {
+                ++written;
+            } else {
+                std::cerr << "capture: failed to write " << path << std::endl;
+            }
+        }
+        lock.lock();
+        written_ += written;
+        --active_;
+        done_cv_.notify_all();
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/glad.h>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 截图与连续录制. 每帧把当前读帧缓冲异步读回到PBO环中的一个, 插入fence; 之后的帧里fence已完成的PBO
+// 才映射拷出, 交给编码线程池并行压缩写PNG(或交给管道线程按顺序写入外部编码器), 渲染线程不等待GPU也不等待编码.
+// 用法: 每帧交换缓冲前调用capture(), 退出前在GL上下文中调用flush(). 不依赖窗口, 无窗口模式下同样可用
+class FrameCapture {
+  public:
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture &operator=(const FrameCapture &) = delete;
+    // 等待编码队列全部写完
+    ~FrameCapture();
+
+    // 下一次capture()的帧写到path
+    void screenshot(const std::string &path);
+    // 之后每次capture()的帧依次写到directory/frame_000000.png ...
+    void startSequence(const std::string &directory);
+    void stopSequence();
+    [[nodiscard]] bool recording() const { return recording_; }
+    // 之后每次capture()的帧按顺序以rgb24原始像素(自上而下)写入command的标准输入, 如ffmpeg -f rawvideo -i -;
+    // 帧尺寸需保持不变. 进程启动失败时返回false
+    bool startPipe(const std::string &command);
+    // 不再送入新帧, 在途的帧在release()时写完后关闭管道并等待进程退出
+    void stopPipe() { piping_ = false; }
+
+    // 需要GL上下文: 回收已完成的读回, 有截图请求或正在录制时读回width x height
+    void capture(int width, int height);
+    // 需要GL上下文: 等待所有在途的读回并交给编码线程
+    void flush();
+    // 需要GL上下文: flush()后释放PBO, 关闭已停止的管道
+    void release();
+    // 等待已交出的帧全部编码写完, 不需要GL上下文
+    void wait();
+
+    // 写出的帧数; 等待PBO或编码队列的累计耗时(秒), 持续增长说明编码跟不上帧率
+    [[nodiscard]] size_t writtenCount() const;
+    [[nodiscard]] double stallSeconds() const { return stall_seconds_; }
+
+  private:
+    static constexpr size_t kSlots = 3;
+
+    struct Slot {
+        unsigned int pbo{};
+        size_t size{};
+        GLsync fence{};
+        int width{}, height{};
+        std::vector<std::string> paths;   // 录制中截图时一帧写两个文件
+        bool pipe{false};
+    };
+    struct Job {
+        std::vector<std::string> paths;
+        int width{}, height{};
+        std::vector<uint8_t> pixels;
+    };
+
+    void retire(Slot &slot);
+    void startWorkers();
+    void work();
+    void writePipe();
+    void closePipe();
+
+    std::array<Slot, kSlots> slots_{};
+    size_t head_{};               // 下一次读回使用的槽
+    std::string screenshot_path_;
+    bool recording_{false};
+    std::string directory_;
+    size_t sequence_frame_{};
+    double stall_seconds_{};
+
+    std::vector<std::thread> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    std::deque<Job> jobs_;
+    size_t active_{};             // 已从队列取出尚未写完的帧数
+    size_t written_{};
+    bool quit_{false};
+
+    bool piping_{false};
+    FILE *pipe_{nullptr};
+    std::thread pipe_writer_;
+    std::deque<Job> pipe_jobs_;
+    bool pipe_quit_{false};
+};
+
+#endif //FRAME_CAPTURE_H
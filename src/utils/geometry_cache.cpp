@@ -0,0 +1,219 @@
+#include "geometry_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const char kMagic[4] = {'M', 'M', 'T', 'G'};
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t key;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t rangeCount;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(FileHeader) == 32, "cache header layout changed");
+    static_assert(sizeof(FeatureRange) == 24, "FeatureRange layout changed, bump kFormatVersion");
+
+    // 各段按4字节对齐排列: header | ranges | vertices | styles | pad | indices
+    size_t stylesPadding(size_t vertexCount) {
+        return (vertexCount * sizeof(uint16_t)) % 4;
+    }
+
+    // 同一进程内多个分区并发加载时, 清单的读写与旧文件清理需串行, 否则可能删掉另一个分区刚绑定的文件
+    std::mutex manifest_mutex;
+
+    // 先写临时文件再rename, 并发启动或中途退出都不会留下半个文件, 读者也不会读到截断中的文件
+    std::string temporaryPath(const std::string &target) {
+        return target + ".tmp" + std::to_string(getpid()) + "_" +
+               std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    }
+
+    size_t fileSize(const FileHeader &header) {
+        return sizeof(FileHeader) + header.rangeCount * sizeof(FeatureRange) +
+               header.vertexCount * 3 * sizeof(float) + header.vertexCount * sizeof(uint16_t) +
+               stylesPadding(header.vertexCount) + header.indexCount * sizeof(uint32_t);
+    }
+
+    std::string hex(uint64_t key) {
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(key));
+        return buf;
+    }
+}
+
+uint64_t fnv1a64(const void *data, size_t size, uint64_t seed) {
+    auto bytes = static_cast<const uint8_t *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+MappedLayer::~MappedLayer() {
+    if (addr_ != nullptr) {
+        munmap(addr_, size_);
+    }
+}
+
+std::unique_ptr<MappedLayer> MappedLayer::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        close(fd);
+        return nullptr;
+    }
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedLayer> mapped(new MappedLayer());
+    mapped->addr_ = addr;
+    mapped->size_ = st.st_size;
+
+    FileHeader header{};
+    std::memcpy(&header, addr, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, 4) != 0 || header.version != GeometryCache::kFormatVersion ||
+        fileSize(header) != mapped->size_) {
+        std::cerr << "GeometryCache: ignore corrupt file " << path << std::endl;
+        return nullptr;
+    }
+
+    auto cursor = static_cast<const uint8_t *>(addr) + sizeof(FileHeader);
+    auto &view = mapped->view_;
+    view.rangeCount = header.rangeCount;
+    view.vertexCount = header.vertexCount;
+    view.indexCount = header.indexCount;
+    view.ranges = reinterpret_cast<const FeatureRange *>(cursor);
+    cursor += header.rangeCount * sizeof(FeatureRange);
+    view.vertices = reinterpret_cast<const float *>(cursor);
+    cursor += header.vertexCount * 3 * sizeof(float);
+    view.styles = reinterpret_cast<const uint16_t *>(cursor);
+    cursor += header.vertexCount * sizeof(uint16_t) + stylesPadding(header.vertexCount);
+    view.indices = reinterpret_cast<const uint32_t *>(cursor);
+    return mapped;
+}
+
+GeometryCache::GeometryCache(const std::string &db_path) {
+    std::error_code ec;
+    fs::path dir = db_path + ".cache";
+    fs::create_directories(dir, ec);
+    if (ec || !fs::is_directory(dir, ec)) {
+        std::cerr << "GeometryCache: disabled, cannot create " << dir << std::endl;
+        return;
+    }
+    dir_ = dir.string();
+}
+
+std::string GeometryCache::path(uint64_t key, const std::string &layer) const {
+    return dir_ + "/" + hex(key) + "." + layer + ".geom";
+}
+
+std::unique_ptr<MappedLayer> GeometryCache::open(uint64_t key, const std::string &layer) const {
+    if (!enabled()) {
+        return nullptr;
+    }
+    return MappedLayer::open(path(key, layer));
+}
+
+bool GeometryCache::store(uint64_t key, const std::string &layer, const LayerData &data) const {
+    if (!enabled()) {
+        return false;
+    }
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, 4);
+    header.version = kFormatVersion;
+    header.key = key;
+    header.vertexCount = static_cast<uint32_t>(data.vertexCount());
+    header.indexCount = static_cast<uint32_t>(data.indices.size());
+    header.rangeCount = static_cast<uint32_t>(data.ranges.size());
+
+    auto target = path(key, layer);
+    auto tmp = temporaryPath(target);
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        const uint32_t pad = 0;
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(data.ranges.data()), data.ranges.size() * sizeof(FeatureRange));
+        out.write(reinterpret_cast<const char *>(data.vertices.data()), data.vertices.size() * sizeof(float));
+        out.write(reinterpret_cast<const char *>(data.styles.data()), data.styles.size() * sizeof(uint16_t));
+        out.write(reinterpret_cast<const char *>(&pad), stylesPadding(header.vertexCount));
+        out.write(reinterpret_cast<const char *>(data.indices.data()), data.indices.size() * sizeof(uint32_t));
+        if (!out) {
+            std::error_code ec;
+            fs::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, target, ec);
+    return !ec;
+}
+
+void GeometryCache::bindPartition(const std::string &partition, uint64_t key) const {
+    if (!enabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(manifest_mutex);
+    auto manifest = dir_ + "/" + partition + ".key";
+    std::string old_key;
+    {
+        std::ifstream in(manifest);
+        in >> old_key;
+    }
+    if (old_key == hex(key)) {
+        return;
+    }
+    auto tmp = temporaryPath(manifest);
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << hex(key) << std::endl;
+    }
+    std::error_code ec;
+    fs::rename(tmp, manifest, ec);
+    if (ec || old_key.empty()) {
+        fs::remove(tmp, ec);
+        return;
+    }
+
+    for (const auto &entry : fs::directory_iterator(dir_, ec)) {
+        if (entry.path().extension() == ".key") {
+            std::ifstream in(entry.path());
+            std::string other;
+            in >> other;
+            if (other == old_key) {
+                return;
+            }
+        }
+    }
+    std::vector<fs::path> stale;
+    for (const auto &entry : fs::directory_iterator(dir_, ec)) {
+        if (entry.path().filename().string().rfind(old_key + ".", 0) == 0) {
+            stale.push_back(entry.path());
+        }
+    }
+    for (const auto &file : stale) {
+        fs::remove(file, ec);
+    }
+}
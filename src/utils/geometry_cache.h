@@ -0,0 +1,56 @@
+#ifndef GEOMETRY_CACHE_H
+#define GEOMETRY_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "layer_buffer.h"
+
+uint64_t fnv1a64(const void *data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
+// 只读映射的缓存文件, 析构时解除映射
+class MappedLayer {
+  public:
+    MappedLayer(const MappedLayer &) = delete;
+    MappedLayer &operator=(const MappedLayer &) = delete;
+    ~MappedLayer();
+
+    static std::unique_ptr<MappedLayer> open(const std::string &path);
+
+    [[nodiscard]] const LayerView &view() const { return view_; }
+
+  private:
+    MappedLayer() = default;
+
+    void *addr_ = nullptr;
+    size_t size_{};
+    LayerView view_{};
+};
+
+// 分区图层的磁盘缓存, 目录为 <db_path>.cache/.
+// 文件按内容键命名(blob哈希 + 参考点 + 格式版本), 相同blob的分区共用同一份文件;
+// 每个分区另记一份清单指向当前键, blob改变后旧文件在无其他分区引用时删除.
+// 缓存文件与清单都先写临时文件再rename; bindPartition()在进程内串行, 可从多个加载线程调用.
+class GeometryCache {
+  public:
+    // 文件布局或图层构建逻辑变化时递增, 旧缓存自动失效
+    static constexpr uint32_t kFormatVersion = 4;
+
+    explicit GeometryCache(const std::string &db_path);
+
+    [[nodiscard]] bool enabled() const { return !dir_.empty(); }
+
+    // 未命中返回nullptr
+    [[nodiscard]] std::unique_ptr<MappedLayer> open(uint64_t key, const std::string &layer) const;
+    bool store(uint64_t key, const std::string &layer, const LayerData &data) const;
+
+    // 记录分区当前使用的键, 并清理不再被任何分区引用的旧文件
+    void bindPartition(const std::string &partition, uint64_t key) const;
+
+  private:
+    [[nodiscard]] std::string path(uint64_t key, const std::string &layer) const;
+
+    std::string dir_;
+};
+
+#endif //GEOMETRY_CACHE_H
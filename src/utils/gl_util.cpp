@@ -1,9 +1,16 @@
 #include "gl_util.h"
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <thread>
 
 
-const GLchar *vertexShaderSource = R"(#version 330 core
+// STYLE_COUNT 由 init() 根据 style_palette.h 注入
+const GLchar *vertexShaderSource = R"(
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec4 aColor;
+layout (location = 1) in uint aStyle;
 
 out vec4 vertexColor;
 
@@ -11,10 +18,16 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+layout (std140) uniform Palette {
+    vec4 colors[STYLE_COUNT * STATE_COUNT];
+};
+
 void main()
 {
     gl_Position = projection * view * model * vec4(aPos, 1.0);
-    vertexColor = aColor;
+    uint styleId = min(aStyle & 0xFFu, uint(STYLE_COUNT - 1));
+    uint state = min(aStyle >> 8, uint(STATE_COUNT - 1));
+    vertexColor = colors[state * uint(STYLE_COUNT) + styleId];
 })";
 const GLchar *fragmentShaderSource = R"(#version 330 core
 in vec4 vertexColor;
@@ -28,6 +41,16 @@ void main()
 })";
 
 
+// 截图/录制的默认文件名, 如screenshot_20240101_120000
+std::string timestamp_name(const char *prefix) {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char name[64];
+    std::strftime(name, sizeof(name), "_%Y%m%d_%H%M%S", &local);
+    return prefix + std::string(name);
+}
+
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
     if (button == GLFW_MOUSE_BUTTON_LEFT) {
         auto* context = static_cast<MouseContext*>(glfwGetWindowUserPointer(window));
@@ -63,7 +86,13 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     }
 }
 
-bool GLUtil::init(glm::vec3 position, glm::vec3 target) {
+bool GLUtil::init(glm::vec3 position, glm::vec3 target, bool headless) {
+#ifdef GLFW_PLATFORM_NULL
+    if (headless) {
+        // 无显示环境: GLFW null平台 + OSMesa软件渲染
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+#endif
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -72,6 +101,12 @@ bool GLUtil::init(glm::vec3 position, glm::vec3 target) {
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    if (headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+    }
 
     mouse_context_ = std::make_unique<MouseContext>(Camera(position, target));
 
@@ -83,7 +118,7 @@ bool GLUtil::init(glm::vec3 position, glm::vec3 target) {
         return false;
     }
     glfwMakeContextCurrent(window_);
-    glfwSetFramebufferSizeCallback(window_, [](GLFWwindow* window, int width, int height){glViewport(0, 0, width, height);});
+    // 视口由clear()按快照中的帧缓冲尺寸设置, 回调所在的主线程可能没有GL上下文
     glfwSetWindowUserPointer(window_, mouse_context_.get());
     glfwSetMouseButtonCallback(window_, mouse_button_callback);
     glfwSetCursorPosCallback(window_, mouse_callback);
@@ -94,22 +129,76 @@ bool GLUtil::init(glm::vec3 position, glm::vec3 target) {
         return false;
     }
     glEnable(GL_DEPTH_TEST);
-    shader_ = std::make_unique<Shader>(vertexShaderSource, fragmentShaderSource);
-    shader_->use();
-    shader_->setVec4("mainColor", 1.0f, 1.0f, 0.0f, 1.0f);
+    std::string vertexSource = "#version 330 core\n"
+            "#define STYLE_COUNT " + std::to_string(style::STYLE_COUNT) + "\n"
+            "#define STATE_COUNT " + std::to_string(style::STATE_COUNT) + "\n" + vertexShaderSource;
+    // 这里只提交编译, 第一次updateTransforms()时才等待, 期间可以加载地图数据
+    shaders_.init(ShaderManager::defaultCacheDir());
+    main_program_ = shaders_.add("main", vertexSource, fragmentShaderSource, {"model", "view", "projection"},
+                                 {{"Palette", kPaletteBinding}});
+
+    palette_ = StylePalette::create(theme_);
+    glGenBuffers(1, &palette_ubo_);
+    glBindBuffer(GL_UNIFORM_BUFFER, palette_ubo_);
+    glBufferData(GL_UNIFORM_BUFFER, palette_.byteSize(), palette_.data(), GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kPaletteBinding, palette_ubo_);
+
+    // run()之前cameraPosition()等也返回初始相机
+    sampleInput(0.0f);
+    beginFrame();
 
     inited = true;
     return true;
 }
 
-void GLUtil::processInput(float deltaTime) {
+void GLUtil::run(const std::function<void()> &frame, bool renderThread) {
     if (!inited) {
         std::cerr << "Failed to initialize OpenGL context" << std::endl;
         return;
     }
+    double lastTime = glfwGetTime();
+    auto sample = [&]() {
+        double now = glfwGetTime();
+        sampleInput(static_cast<float>(now - lastTime));
+        lastTime = now;
+    };
+    if (!renderThread) {
+        while (!glfwWindowShouldClose(window_)) {
+            glfwPollEvents();
+            sample();
+            beginFrame();
+            frame();
+            present();
+        }
+        capture_.stopSequence();
+        capture_.release();
+        return;
+    }
+
+    glfwMakeContextCurrent(nullptr);
+    std::thread render([&]() {
+        glfwMakeContextCurrent(window_);
+        while (!glfwWindowShouldClose(window_)) {
+            beginFrame();
+            frame();
+            present();
+        }
+        capture_.stopSequence();
+        capture_.release();
+        glfwMakeContextCurrent(nullptr);
+    });
+    while (!glfwWindowShouldClose(window_)) {
+        // 没有事件时也按固定间隔采样, 按住移动键时相机匀速移动
+        glfwWaitEventsTimeout(kInputInterval);
+        sample();
+    }
+    render.join();
+    glfwMakeContextCurrent(window_);
+}
+
+void GLUtil::sampleInput(float deltaTime) {
     if(glfwGetKey(window_, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window_, true);
-
     if (glfwGetKey(window_, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS || glfwGetKey(window_, GLFW_KEY_RIGHT_CONTROL) == GLFW_PRESS) {
         deltaTime = deltaTime * 0.1f;
     }
@@ -125,6 +214,58 @@ void GLUtil::processInput(float deltaTime) {
         mouse_context_->camera.ProcessKeyboard(UP, deltaTime);
     if (glfwGetKey(window_, GLFW_KEY_C) == GLFW_PRESS)
         mouse_context_->camera.ProcessKeyboard(DOWN, deltaTime);
+
+    for (int key = GLFW_KEY_SPACE; key <= GLFW_KEY_LAST; ++key) {
+        bool down = glfwGetKey(window_, key) == GLFW_PRESS;
+        input_.keyPresses[key] += down && !key_down_[key];
+        key_down_[key] = down;
+    }
+    for (int button = 0; button <= GLFW_MOUSE_BUTTON_LAST; ++button) {
+        bool down = glfwGetMouseButton(window_, button) == GLFW_PRESS;
+        input_.buttonPresses[button] += down && !button_down_[button];
+        button_down_[button] = down;
+    }
+    glfwGetCursorPos(window_, &input_.cursor.x, &input_.cursor.y);
+    glfwGetWindowSize(window_, &input_.windowSize.x, &input_.windowSize.y);
+    glfwGetFramebufferSize(window_, &input_.framebufferSize.x, &input_.framebufferSize.y);
+    input_.view = mouse_context_->camera.GetViewMatrix();
+    input_.position = mouse_context_->camera.getPosition();
+    input_.zoom = mouse_context_->camera.getZoom();
+    snapshots_.back() = input_;
+    snapshots_.publish();
+
+    std::lock_guard<std::mutex> lock(title_mutex_);
+    if (!pending_title_.empty()) {
+        glfwSetWindowTitle(window_, pending_title_.c_str());
+        pending_title_.clear();
+    }
+}
+
+void GLUtil::beginFrame() {
+    if (snapshots_.consume()) {
+        frame_ = snapshots_.front();
+    }
+    if (keyPressed(GLFW_KEY_N))
+        setTheme(theme_ == Theme::DAY ? Theme::NIGHT : Theme::DAY);
+    if (keyPressed(GLFW_KEY_R))
+        setDynamicResolution(!dynamic_.enabled, dynamic_.targetMs, dynamic_.minScale);
+    if (keyPressed(GLFW_KEY_P)) {
+        std::string path = timestamp_name("screenshot") + ".png";
+        capture_.screenshot(path);
+        std::cout << "screenshot: " << path << std::endl;
+    }
+    if (keyPressed(GLFW_KEY_O)) {
+        if (capture_.recording()) {
+            capture_.stopSequence();
+        } else {
+            capture_.startSequence(timestamp_name("capture"));
+        }
+    }
+}
+
+void GLUtil::setWindowTitle(const std::string &title) {
+    std::lock_guard<std::mutex> lock(title_mutex_);
+    pending_title_ = title;
 }
 
 void GLUtil::updateTransforms() {
@@ -134,29 +275,293 @@ void GLUtil::updateTransforms() {
     }
 
     // render the triangle
-    shader_->use();
+    shaders_.use(main_program_);
 
     // pass projection matrix to shader (note that in this case it could change every frame)
-    glm::mat4 projection = glm::perspective(glm::radians(mouse_context_->camera.getZoom()), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 500.0f);
-    shader_->setMat4("projection", projection);
+    projection_ = glm::perspective(glm::radians(frame_.zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 500.0f);
+    glUniformMatrix4fv(shaders_.uniform(main_program_, U_PROJECTION), 1, GL_FALSE, &projection_[0][0]);
 
     // camera/view transformation
-    glm::mat4 view = mouse_context_->camera.GetViewMatrix();
-    shader_->setMat4("view", view);
+    view_ = frame_.view;
+    glUniformMatrix4fv(shaders_.uniform(main_program_, U_VIEW), 1, GL_FALSE, &view_[0][0]);
 
     glm::mat4 model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
-    shader_->setMat4("model", model);
+    glUniformMatrix4fv(shaders_.uniform(main_program_, U_MODEL), 1, GL_FALSE, &model[0][0]);
+}
+
+void GLUtil::setViewProjection(const glm::mat4 &view, const glm::mat4 &projection) {
+    if (!inited) {
+        return;
+    }
+    shaders_.use(main_program_);
+    glUniformMatrix4fv(shaders_.uniform(main_program_, U_PROJECTION), 1, GL_FALSE, &projection[0][0]);
+    glUniformMatrix4fv(shaders_.uniform(main_program_, U_VIEW), 1, GL_FALSE, &view[0][0]);
+    glm::mat4 model = glm::mat4(1.0f);
+    glUniformMatrix4fv(shaders_.uniform(main_program_, U_MODEL), 1, GL_FALSE, &model[0][0]);
+}
+
+void GLUtil::setCamera(glm::vec3 position, glm::vec3 target) {
+    mouse_context_->camera = Camera(position, target);
+    frame_.view = mouse_context_->camera.GetViewMatrix();
+    frame_.position = mouse_context_->camera.getPosition();
+    frame_.zoom = mouse_context_->camera.getZoom();
+}
+
+void GLUtil::setModel(const glm::mat4 &model) {
+    if (!inited) {
+        return;
+    }
+    glUniformMatrix4fv(shaders_.uniform(main_program_, U_MODEL), 1, GL_FALSE, &model[0][0]);
+}
+
+void GLUtil::setTheme(Theme theme) {
+    theme_ = theme;
+    palette_ = StylePalette::create(theme);
+    updatePalette();
+}
+
+void GLUtil::updatePalette() {
+    if (!inited) {
+        return;
+    }
+    // 整张样式表只有几KB, 换主题/改色只需这一次上传, 不用重新绑定几何数据
+    glBindBuffer(GL_UNIFORM_BUFFER, palette_ubo_);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, palette_.byteSize(), palette_.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    ++palette_revision_;
 }
 
+void GLUtil::clear() {
+    if (dynamic_.enabled && inited) {
+        double now = glfwGetTime();
+        float frameMs = static_cast<float>((now - dynamic_.lastTime) * 1000.0);
+        dynamic_.lastTime = now;
 
+        bool moving = frame_.view != dynamic_.lastView || frame_.zoom != dynamic_.lastZoom;
+        dynamic_.lastView = frame_.view;
+        dynamic_.lastZoom = frame_.zoom;
 
+        if (moving && frameMs > 0.0f) {
+            // 填充耗时约与像素数即scale^2成正比, 取四次方根作为带阻尼的调节量
+            float ratio = dynamic_.targetMs / frameMs;
+            dynamic_.scale = std::clamp(dynamic_.scale * std::pow(ratio, 0.25f), dynamic_.minScale, 1.0f);
+        }
+        dynamic_.active = moving && dynamic_.scale < 0.999f;
+
+        int width = frame_.framebufferSize.x, height = frame_.framebufferSize.y;
+        if (dynamic_.active && (width != dynamic_.width || height != dynamic_.height)) {
+            resizeDynamicTarget(width, height);
+            dynamic_.active = dynamic_.enabled;
+        }
+        if (dynamic_.active) {
+            dynamic_.scaledWidth = std::max(1, static_cast<int>(width * dynamic_.scale));
+            dynamic_.scaledHeight = std::max(1, static_cast<int>(height * dynamic_.scale));
+            glBindFramebuffer(GL_FRAMEBUFFER, dynamic_.fbo);
+            glViewport(0, 0, dynamic_.scaledWidth, dynamic_.scaledHeight);
+        } else {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, width, height);
+        }
+
+        if (now - dynamic_.titleTime > 0.5) {
+            dynamic_.titleTime = now;
+            std::string title = "LearnOpenGL - " + std::to_string(static_cast<int>(renderScale() * 100.0f)) + "% " +
+                                std::to_string(static_cast<int>(frameMs)) + " ms";
+            setWindowTitle(title);
+        }
+    } else if (inited) {
+        glViewport(0, 0, frame_.framebufferSize.x, frame_.framebufferSize.y);
+    }
+    glClearColor(palette_.background.x, palette_.background.y, palette_.background.z, palette_.background.w);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void GLUtil::present() {
+    if (dynamic_.active) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, dynamic_.fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, dynamic_.scaledWidth, dynamic_.scaledHeight, 0, 0, dynamic_.width, dynamic_.height,
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    capture_.capture(frame_.framebufferSize.x, frame_.framebufferSize.y);
+    glfwSwapBuffers(window_);
+}
+
+void GLUtil::setDynamicResolution(bool enabled, float targetFrameMs, float minScale) {
+    dynamic_.enabled = enabled;
+    dynamic_.targetMs = targetFrameMs;
+    dynamic_.minScale = std::clamp(minScale, 0.1f, 1.0f);
+    dynamic_.active = false;
+    dynamic_.lastTime = glfwGetTime();
+    if (!enabled && inited) {
+        if (dynamic_.fbo) {
+            glDeleteFramebuffers(1, &dynamic_.fbo);
+            glDeleteRenderbuffers(1, &dynamic_.color);
+            glDeleteRenderbuffers(1, &dynamic_.depth);
+            dynamic_.fbo = dynamic_.color = dynamic_.depth = 0;
+            dynamic_.width = dynamic_.height = 0;
+        }
+        setWindowTitle("LearnOpenGL");
+    }
+    std::cout << "dynamic resolution " << (enabled ? "on" : "off") << ", target " << targetFrameMs << " ms" << std::endl;
+}
 
+void GLUtil::resizeDynamicTarget(int width, int height) {
+    // 按窗口全尺寸分配一次, 每帧只使用左下角的缩小区域, 比例变化时不重新分配
+    if (dynamic_.fbo == 0) {
+        glGenFramebuffers(1, &dynamic_.fbo);
+        glGenRenderbuffers(1, &dynamic_.color);
+        glGenRenderbuffers(1, &dynamic_.depth);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, dynamic_.color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, dynamic_.depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, dynamic_.fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, dynamic_.color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, dynamic_.depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "dynamic resolution: framebuffer incomplete, disabled" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        setDynamicResolution(false);
+        return;
+    }
+    dynamic_.width = width;
+    dynamic_.height = height;
+}
 
+bool GLUtil::keyPressed(int key) {
+    if (key < 0 || key > GLFW_KEY_LAST) {
+        return false;
+    }
+    bool pressed = frame_.keyPresses[key] != key_consumed_[key];
+    key_consumed_[key] = frame_.keyPresses[key];
+    return pressed;
+}
 
+bool GLUtil::mouseButtonPressed(int button) {
+    if (button < 0 || button > GLFW_MOUSE_BUTTON_LAST) {
+        return false;
+    }
+    bool pressed = frame_.buttonPresses[button] != button_consumed_[button];
+    button_consumed_[button] = frame_.buttonPresses[button];
+    return pressed;
+}
 
+bool StreamBuffer::init(GLenum target, size_t capacity, size_t segments, bool forceFallback) {
+    release();
+    target_ = target;
+    segments = std::max<size_t>(segments, 1);
+    segment_size_ = capacity / segments / 256 * 256;  // 段起点保持256字节对齐
+    capacity_ = segment_size_ * segments;
+    segment_ = 0;
+    head_ = 0;
+    stall_seconds_ = 0;
+
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(target_, buffer_);
+    if (!forceFallback && GLAD_GL_VERSION_4_4 && glBufferStorage != nullptr) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target_, static_cast<GLsizeiptr>(capacity_), nullptr, flags);
+        mapped_ = static_cast<uint8_t *>(glMapBufferRange(target_, 0, static_cast<GLsizeiptr>(capacity_), flags));
+        fences_.assign(segments, nullptr);
+    }
+    if (mapped_ == nullptr) {
+        // GL 3.3: 写满后orphan整块缓冲, 其余时间用UNSYNCHRONIZED映射追加写入
+        glBufferData(target_, static_cast<GLsizeiptr>(capacity_), nullptr, GL_STREAM_DRAW);
+        segment_size_ = capacity_;
+        fences_.clear();
+    }
+    glBindBuffer(target_, 0);
+    return buffer_ != 0;
+}
 
+StreamBuffer::Allocation StreamBuffer::allocate(size_t size, size_t alignment) {
+    Allocation allocation;
+    if (buffer_ == 0 || size == 0 || size > segment_size_) {
+        std::cerr << "StreamBuffer: cannot allocate " << size << " bytes" << std::endl;
+        return allocation;
+    }
+    size_t begin = (head_ + alignment - 1) / alignment * alignment;
 
+    if (mapped_ != nullptr) {
+        if (begin + size > segment_size_) {
+            std::cerr << "StreamBuffer: segment overflow, increase capacity" << std::endl;
+            return allocation;
+        }
+        allocation.offset = static_cast<GLintptr>(segment_ * segment_size_ + begin);
+        allocation.ptr = mapped_ + allocation.offset;
+    } else {
+        glBindBuffer(target_, buffer_);
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        if (begin + size > capacity_) {
+            glBufferData(target_, static_cast<GLsizeiptr>(capacity_), nullptr, GL_STREAM_DRAW);
+            begin = 0;
+        }
+        allocation.offset = static_cast<GLintptr>(begin);
+        allocation.ptr = glMapBufferRange(target_, allocation.offset, static_cast<GLsizeiptr>(size), access);
+    }
+    allocation.size = static_cast<GLsizeiptr>(size);
+    head_ = begin + size;
+    return allocation;
+}
 
+void StreamBuffer::commit(const Allocation &allocation) {
+    if (mapped_ != nullptr || allocation.ptr == nullptr) {
+        return;  // 持久映射是coherent的, 无需额外操作
+    }
+    glBindBuffer(target_, buffer_);
+    glUnmapBuffer(target_);
+}
 
+void StreamBuffer::endFrame() {
+    if (mapped_ == nullptr) {
+        return;
+    }
+    // 为刚写完的段插入fence, 下一段在复用前等待其GPU读取完成
+    fences_[segment_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    segment_ = (segment_ + 1) % fences_.size();
+    head_ = 0;
+    waitSegment(segment_);
+}
 
+void StreamBuffer::waitSegment(size_t segment) {
+    GLsync fence = fences_[segment];
+    if (fence == nullptr) {
+        return;
+    }
+    double start = glfwGetTime();
+    GLbitfield flags = 0;
+    while (true) {
+        GLenum result = glClientWaitSync(fence, flags, 1000000);  // 1ms
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+            break;
+        }
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    }
+    stall_seconds_ += glfwGetTime() - start;
+    glDeleteSync(fence);
+    fences_[segment] = nullptr;
+}
 
+void StreamBuffer::release() {
+    for (auto &fence : fences_) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+        }
+    }
+    fences_.clear();
+    if (buffer_ != 0) {
+        if (mapped_ != nullptr) {
+            glBindBuffer(target_, buffer_);
+            glUnmapBuffer(target_);
+            glBindBuffer(target_, 0);
+        }
+        glDeleteBuffers(1, &buffer_);
+    }
+    buffer_ = 0;
+    mapped_ = nullptr;
+}
@@ -2,9 +2,19 @@
 #define GL_UTIL_H
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <camera.h>
-#include "shader.h"
+#include "shader_manager.h"
+#include "frame_capture.h"
+#include "style_palette.h"
+#include "triple_buffer.h"
+#include <array>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory>
 
 const unsigned int SCR_WIDTH = 1600;
 const unsigned int SCR_HEIGHT = 1200;
@@ -17,20 +27,170 @@ struct MouseContext {
     bool leftMouseButton = false;
 };
 
+// 主线程(GLFW)每次处理完输入后发布给渲染线程的快照, 渲染线程只读快照, 不访问相机和窗口
+struct InputSnapshot {
+    glm::mat4 view{1.0f};
+    glm::vec3 position{0.0f};
+    float zoom{45.0f};
+    glm::dvec2 cursor{0.0};
+    glm::ivec2 windowSize{0};
+    glm::ivec2 framebufferSize{0};
+    // 累计按下次数而不是当前状态, 渲染线程来不及读而被覆盖的快照不会丢失按键
+    std::array<uint32_t, GLFW_KEY_LAST + 1> keyPresses{};
+    std::array<uint32_t, GLFW_MOUSE_BUTTON_LAST + 1> buttonPresses{};
+};
+
+// 动态数据(车辆位姿/实时占用/轨迹等)的流式上传环形缓冲.
+// 支持GL 4.4时使用持久映射 + 每段一个fence; 否则退化为GL 3.3的orphaning方式.
+// 用法: allocate() -> 写ptr -> commit() -> 以offset绑定绘制 -> 每帧结束调用endFrame()
+class StreamBuffer {
+public:
+    struct Allocation {
+        void *ptr = nullptr;        // 可写地址, 分配失败时为nullptr
+        GLintptr offset = 0;        // 在buffer()中的字节偏移
+        GLsizeiptr size = 0;
+    };
+
+    StreamBuffer() = default;
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    // capacity按segments等分, 每帧使用一段; forceFallback用于对比测试
+    bool init(GLenum target, size_t capacity, size_t segments = 3, bool forceFallback = false);
+    Allocation allocate(size_t size, size_t alignment = 16);
+    void commit(const Allocation &allocation);
+    void endFrame();
+    void release();
+
+    [[nodiscard]] unsigned int buffer() const { return buffer_; }
+    [[nodiscard]] bool persistent() const { return mapped_ != nullptr; }
+    // 一帧内可分配的字节数, 回退路径中为整个缓冲
+    [[nodiscard]] size_t segmentSize() const { return segment_size_; }
+    // 等待fence累计耗时(秒), 持续增长说明capacity不足以覆盖GPU延迟
+    [[nodiscard]] double stallSeconds() const { return stall_seconds_; }
+
+private:
+    void waitSegment(size_t segment);
+
+    GLenum target_{GL_ARRAY_BUFFER};
+    unsigned int buffer_{};
+    size_t capacity_{};
+    size_t segment_size_{};
+    size_t segment_{};
+    size_t head_{};             // 当前段内的写入位置(回退路径中为整个缓冲内)
+    uint8_t *mapped_ = nullptr;
+    std::vector<GLsync> fences_;
+    double stall_seconds_{};
+};
+
 class GLUtil {
 public:
     GLUtil() = default;
-    bool init(glm::vec3 position, glm::vec3 target);
-    void processInput(float deltaTime);
+    // headless为true时不显示窗口, 供服务器上的离线渲染/基准测试使用
+    bool init(glm::vec3 position, glm::vec3 target, bool headless = false);
+    // 循环执行frame并交换缓冲直到窗口关闭. renderThread为true时调用线程(必须是主线程)只处理GLFW事件和
+    // 相机输入, GL上下文交给渲染线程执行frame, 两者通过三缓冲的InputSnapshot交接, 交换缓冲不再阻塞输入;
+    // 返回前上下文回到调用线程. 否则在调用线程上依次处理输入和绘制
+    void run(const std::function<void()> &frame, bool renderThread = true);
     void updateTransforms();
+    // 其他视图(如小地图)用主程序绘制前设置自己的矩阵, 之后主视图的updateTransforms()会恢复;
+    // 不影响viewMatrix()/projectionMatrix()
+    void setViewProjection(const glm::mat4 &view, const glm::mat4 &projection);
+    // 多分区共用一个ENU坐标系时, 绘制每个分区前设置其平移
+    void setModel(const glm::mat4 &model);
+    // 每帧开始时调用; 动态分辨率生效时绑定离屏FBO并把视口缩小到当前比例
+    void clear();
+    // 代替glfwSwapBuffers: 若本帧渲染在离屏FBO中, 先线性放大到窗口再交换; 交换前交给capture()读回
+    void present();
+
+    // 动态分辨率: 相机移动时按帧时间调节渲染比例(最低minScale), 使帧时间不超过targetFrameMs;
+    // 相机静止后立即恢复全分辨率直接渲染到窗口. 按R切换
+    void setDynamicResolution(bool enabled, float targetFrameMs = 33.3f, float minScale = 0.5f);
+    [[nodiscard]] bool dynamicResolution() const {return dynamic_.enabled;}
+    // 本帧的渲染比例, 全分辨率时为1
+    [[nodiscard]] float renderScale() const {return dynamic_.active ? dynamic_.scale : 1.0f;}
+
+    void setTheme(Theme theme);
+    // 修改palette()后调用, 将样式表重新上传到UBO
+    void updatePalette();
+    StylePalette &palette() {return palette_;}
+    // 每次updatePalette()加一, 缓存了绘制结果的视图据此判断样式是否变化
+    [[nodiscard]] uint64_t paletteRevision() const {return palette_revision_;}
+    // 其他绘制路径(拾取/叠加层等)在此注册自己的程序
+    ShaderManager &shaders() {return shaders_;}
+    // 截图/录制窗口画面, 按P截图, 按O开始/停止录制; run()返回前写完所有在途的帧
+    FrameCapture &capture() {return capture_;}
 
     GLFWwindow* window() {return window_;}
+    // 以下读取本帧的输入快照, 在run()的frame中调用
+    [[nodiscard]] glm::vec3 cameraPosition() const {return frame_.position;}
+    [[nodiscard]] glm::dvec2 cursorPosition() const {return frame_.cursor;}
+    [[nodiscard]] glm::ivec2 windowSize() const {return frame_.windowSize;}
+    // 不经过输入直接放置相机, 供离线渲染使用; 相机归主线程所有, 不能在run()的frame中调用
+    void setCamera(glm::vec3 position, glm::vec3 target);
+    // 最近一次updateTransforms()使用的矩阵
+    [[nodiscard]] const glm::mat4 &viewMatrix() const {return view_;}
+    [[nodiscard]] const glm::mat4 &projectionMatrix() const {return projection_;}
+
+    // 按键按下沿检测, 每次按下只返回一次true; 两次调用之间按了多次也只返回一次
+    bool keyPressed(int key);
+    // 鼠标按键按下沿检测, 与keyPressed相同
+    bool mouseButtonPressed(int button);
 
 private:
+    static constexpr unsigned int kPaletteBinding = 0;
+    // 渲染线程模式下主线程没有事件时的输入采样间隔(秒)
+    static constexpr double kInputInterval = 0.004;
+    // 与init()中注册的uniform顺序一致
+    enum MainUniform { U_MODEL, U_VIEW, U_PROJECTION };
+
+    struct DynamicResolution {
+        bool enabled{false};
+        bool active{false};      // 本帧是否渲染到离屏FBO
+        float targetMs{33.3f};
+        float minScale{0.5f};
+        float scale{1.0f};       // 相机静止时保留, 下次移动从该比例开始
+        int width{}, height{};   // FBO尺寸, 与窗口帧缓冲一致
+        int scaledWidth{}, scaledHeight{};
+        unsigned int fbo{}, color{}, depth{};
+        glm::mat4 lastView{1.0f};
+        float lastZoom{};
+        double lastTime{};
+        double titleTime{};
+    };
+    void resizeDynamicTarget(int width, int height);
+    // 主线程: 处理退出和相机移动, 统计按键按下沿, 发布快照
+    void sampleInput(float deltaTime);
+    // 渲染线程: 取最新快照, 处理主题和动态分辨率开关
+    void beginFrame();
+    // 窗口标题只能在主线程上设置, 先记下由sampleInput()应用
+    void setWindowTitle(const std::string &title);
+
     bool inited{false};
     GLFWwindow* window_ = nullptr;
     std::unique_ptr<MouseContext> mouse_context_ = nullptr;
-    std::unique_ptr<Shader> shader_ = nullptr;
+    ShaderManager shaders_;
+    ShaderManager::Handle main_program_{};
+
+    Theme theme_{Theme::DAY};
+    StylePalette palette_{};
+    unsigned int palette_ubo_{};
+    uint64_t palette_revision_{};
+    // 主线程侧的按键状态与快照
+    std::array<bool, GLFW_KEY_LAST + 1> key_down_{};
+    std::array<bool, GLFW_MOUSE_BUTTON_LAST + 1> button_down_{};
+    InputSnapshot input_;
+    TripleBuffer<InputSnapshot> snapshots_;
+    std::mutex title_mutex_;
+    std::string pending_title_;
+    // 渲染线程侧: 本帧快照与已消费的按下次数
+    InputSnapshot frame_;
+    std::array<uint32_t, GLFW_KEY_LAST + 1> key_consumed_{};
+    std::array<uint32_t, GLFW_MOUSE_BUTTON_LAST + 1> button_consumed_{};
+    glm::mat4 view_{1.0f};
+    glm::mat4 projection_{1.0f};
+    DynamicResolution dynamic_;
+    FrameCapture capture_;
 };
 
 
@@ -0,0 +1,344 @@
+#include "layer_buffer.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <utility>
+
+namespace {
+    std::atomic<uint64_t> next_generation{1};
+}
+
+void LayerData::addFeature(uint32_t id, GLenum mode, const std::vector<float> &points,
+                           const std::vector<uint16_t> &featureStyles,
+                           const std::vector<uint32_t> &featureIndices) {
+    FeatureRange range;
+    range.id = id;
+    range.mode = mode;
+    range.first = static_cast<uint32_t>(vertexCount());
+    range.count = static_cast<uint32_t>(points.size() / 3);
+    range.firstIndex = static_cast<uint32_t>(indices.size());
+    range.indexCount = static_cast<uint32_t>(featureIndices.size());
+
+    vertices.insert(vertices.end(), points.begin(), points.begin() + range.count * 3);
+    // 每个顶点一个样式键; featureStyles不足时用最后一个(为空时用默认样式)补齐, 多余的忽略
+    size_t given = std::min<size_t>(featureStyles.size(), range.count);
+    styles.insert(styles.end(), featureStyles.begin(), featureStyles.begin() + static_cast<std::ptrdiff_t>(given));
+    styles.insert(styles.end(), range.count - given, given > 0 ? featureStyles[given - 1] : uint16_t{0});
+    for (auto index : featureIndices) {
+        indices.push_back(range.first + index);
+    }
+    ranges.push_back(range);
+}
+
+void LayerData::addFeature(uint32_t id, GLenum mode, const std::vector<float> &points, uint16_t styleKey,
+                           const std::vector<uint32_t> &featureIndices) {
+    addFeature(id, mode, points, std::vector<uint16_t>(points.size() / 3, styleKey), featureIndices);
+}
+
+LayerData LayerData::fromView(const LayerView &view) {
+    LayerData data;
+    data.vertices.assign(view.vertices, view.vertices + view.vertexCount * 3);
+    data.styles.assign(view.styles, view.styles + view.vertexCount);
+    data.indices.assign(view.indices, view.indices + view.indexCount);
+    data.ranges.assign(view.ranges, view.ranges + view.rangeCount);
+    return data;
+}
+
+LayerBuffer::LayerBuffer(LayerBuffer &&other) noexcept {
+    *this = std::move(other);
+}
+
+LayerBuffer &LayerBuffer::operator=(LayerBuffer &&other) noexcept {
+    std::swap(vao_, other.vao_);
+    std::swap(vertex_vbo_, other.vertex_vbo_);
+    std::swap(style_vbo_, other.style_vbo_);
+    std::swap(ebo_, other.ebo_);
+    std::swap(pick_vbo_, other.pick_vbo_);
+    std::swap(ranges_, other.ranges_);
+    std::swap(bounds_, other.bounds_);
+    std::swap(styles_, other.styles_);
+    std::swap(id_index_, other.id_index_);
+    std::swap(batches_, other.batches_);
+    std::swap(generation_, other.generation_);
+    std::swap(revision_, other.revision_);
+    std::swap(gpu_bytes_, other.gpu_bytes_);
+    return *this;
+}
+
+void LayerBuffer::upload(const LayerView &view) {
+    if (vao_ == 0) {
+        glGenVertexArrays(1, &vao_);
+        glGenBuffers(1, &vertex_vbo_);
+        glGenBuffers(1, &style_vbo_);
+        glGenBuffers(1, &ebo_);
+    }
+    ranges_.assign(view.ranges, view.ranges + view.rangeCount);
+    styles_.assign(view.styles, view.styles + view.vertexCount);
+
+    glBindVertexArray(vao_);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, view.vertexCount * 3 * sizeof(float), view.vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
+    glEnableVertexAttribArray(0);
+
+    // 样式键会随要素状态改变, 单独放一个缓冲
+    glBindBuffer(GL_ARRAY_BUFFER, style_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, styles_.size() * sizeof(uint16_t), styles_.data(), GL_DYNAMIC_DRAW);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_SHORT, sizeof(uint16_t), (void *) 0);
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, view.indexCount * sizeof(uint32_t), view.indices, GL_STATIC_DRAW);
+
+    // 要素区间变了, 拾取属性在下次drawPick()时重新生成
+    if (pick_vbo_ != 0) {
+        glDisableVertexAttribArray(2);
+        glDeleteBuffers(1, &pick_vbo_);
+        pick_vbo_ = 0;
+    }
+
+    glBindVertexArray(0);
+    gpu_bytes_ = view.vertexCount * 3 * sizeof(float) + styles_.size() * sizeof(uint16_t) +
+                 view.indexCount * sizeof(uint32_t);
+
+    id_index_.clear();
+    bounds_.resize(ranges_.size());
+    for (uint32_t i = 0; i < ranges_.size(); ++i) {
+        id_index_.emplace(ranges_[i].id, i);
+        auto &box = bounds_[i];
+        box = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+               std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+               std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+        for (uint32_t v = ranges_[i].first; v < ranges_[i].first + ranges_[i].count; ++v) {
+            for (int axis = 0; axis < 3; ++axis) {
+                box[axis] = std::min(box[axis], view.vertices[v * 3 + axis]);
+                box[axis + 3] = std::max(box[axis + 3], view.vertices[v * 3 + axis]);
+            }
+        }
+    }
+    buildBatches(nullptr);
+}
+
+void LayerBuffer::setFilter(const std::function<bool(const FeatureRange &)> &visible) {
+    buildBatches(visible);
+}
+
+void LayerBuffer::buildBatches(const std::function<bool(const FeatureRange &)> &visible) {
+    batches_.clear();
+    generation_ = next_generation++;
+    revision_ = generation_;
+    for (uint32_t i = 0; i < ranges_.size(); ++i) {
+        const auto &range = ranges_[i];
+        if (visible && !visible(range)) {
+            continue;
+        }
+        bool indexed = range.indexCount > 0;
+        auto batch = std::find_if(batches_.begin(), batches_.end(), [&](const Batch &b) {
+            return b.mode == range.mode && b.indexed == indexed;
+        });
+        if (batch == batches_.end()) {
+            Batch added;
+            added.mode = range.mode;
+            added.indexed = indexed;
+            batches_.push_back(std::move(added));
+            batch = batches_.end() - 1;
+        }
+        batch->members.push_back(i);
+        if (indexed) {
+            batch->counts.push_back(static_cast<GLsizei>(range.indexCount));
+            batch->offsets.push_back(reinterpret_cast<const void *>(range.firstIndex * sizeof(uint32_t)));
+        } else {
+            batch->firsts.push_back(static_cast<GLint>(range.first));
+            batch->counts.push_back(static_cast<GLsizei>(range.count));
+        }
+    }
+}
+
+void LayerBuffer::cull(const glm::mat4 &viewProjection, float margin, bool indirect,
+                       DrawCommands &commands) const {
+    // 裁剪空间中 -(1+margin)w <= x, y, z <= (1+margin)w 对应的6个平面
+    glm::mat4 m = glm::transpose(viewProjection);
+    glm::vec4 planes[6];
+    for (int axis = 0; axis < 3; ++axis) {
+        planes[axis * 2] = m[3] * (1.0f + margin) + m[axis];
+        planes[axis * 2 + 1] = m[3] * (1.0f + margin) - m[axis];
+    }
+    auto inside = [&](const std::array<float, 6> &box) {
+        for (const auto &plane : planes) {
+            // 包围盒在平面法向上最远的角点
+            float x = plane.x >= 0.0f ? box[3] : box[0];
+            float y = plane.y >= 0.0f ? box[4] : box[1];
+            float z = plane.z >= 0.0f ? box[5] : box[2];
+            if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    commands.generation = generation_;
+    commands.indirect = indirect;
+    commands.batches.resize(batches_.size());
+    commands.words.clear();
+    commands.visible = commands.total = 0;
+    for (size_t b = 0; b < batches_.size(); ++b) {
+        const auto &batch = batches_[b];
+        auto &out = commands.batches[b];
+        out.mode = batch.mode;
+        out.indexed = batch.indexed;
+        out.drawCount = 0;
+        out.indirectOffset = static_cast<GLintptr>(commands.words.size() * sizeof(uint32_t));
+        out.firsts.clear();
+        out.counts.clear();
+        out.offsets.clear();
+        for (uint32_t i : batch.members) {
+            if (!inside(bounds_[i])) {
+                continue;
+            }
+            const auto &range = ranges_[i];
+            ++out.drawCount;
+            if (indirect && batch.indexed) {
+                // count, instanceCount, firstIndex, baseVertex, baseInstance
+                commands.words.insert(commands.words.end(), {range.indexCount, 1, range.firstIndex, 0, 0});
+            } else if (indirect) {
+                // count, instanceCount, first, baseInstance
+                commands.words.insert(commands.words.end(), {range.count, 1, range.first, 0});
+            } else if (batch.indexed) {
+                out.counts.push_back(static_cast<GLsizei>(range.indexCount));
+                out.offsets.push_back(reinterpret_cast<const void *>(range.firstIndex * sizeof(uint32_t)));
+            } else {
+                out.firsts.push_back(static_cast<GLint>(range.first));
+                out.counts.push_back(static_cast<GLsizei>(range.count));
+            }
+        }
+        commands.visible += out.drawCount;
+        commands.total += batch.members.size();
+    }
+}
+
+void LayerBuffer::draw(const DrawCommands &commands, unsigned int indirectBuffer, GLintptr indirectBase) {
+    if (commands.generation != generation_) {
+        draw();
+        return;
+    }
+    if (vao_ == 0 || commands.visible == 0) {
+        return;
+    }
+    glBindVertexArray(vao_);
+    if (commands.indirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    }
+    for (const auto &batch : commands.batches) {
+        if (batch.drawCount == 0) {
+            continue;
+        }
+        auto offset = reinterpret_cast<const void *>(indirectBase + batch.indirectOffset);
+        if (commands.indirect && batch.indexed) {
+            glMultiDrawElementsIndirect(batch.mode, GL_UNSIGNED_INT, offset, batch.drawCount, 0);
+        } else if (commands.indirect) {
+            glMultiDrawArraysIndirect(batch.mode, offset, batch.drawCount, 0);
+        } else if (batch.indexed) {
+            glMultiDrawElements(batch.mode, batch.counts.data(), GL_UNSIGNED_INT, batch.offsets.data(),
+                                batch.drawCount);
+        } else {
+            glMultiDrawArrays(batch.mode, batch.firsts.data(), batch.counts.data(), batch.drawCount);
+        }
+    }
+    if (commands.indirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    glBindVertexArray(0);
+}
+
+void LayerBuffer::draw() const {
+    if (vao_ == 0) {
+        return;
+    }
+    glBindVertexArray(vao_);
+    drawBatches();
+    glBindVertexArray(0);
+}
+
+void LayerBuffer::drawPick() {
+    if (vao_ == 0) {
+        return;
+    }
+    glBindVertexArray(vao_);
+    if (pick_vbo_ == 0) {
+        std::vector<uint32_t> pick(styles_.size(), 0);
+        for (uint32_t i = 0; i < ranges_.size(); ++i) {
+            std::fill_n(pick.begin() + ranges_[i].first, ranges_[i].count, i + 1);
+        }
+        glGenBuffers(1, &pick_vbo_);
+        glBindBuffer(GL_ARRAY_BUFFER, pick_vbo_);
+        glBufferData(GL_ARRAY_BUFFER, pick.size() * sizeof(uint32_t), pick.data(), GL_STATIC_DRAW);
+        glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void *) 0);
+        glEnableVertexAttribArray(2);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        gpu_bytes_ += pick.size() * sizeof(uint32_t);
+    }
+    drawBatches();
+    glBindVertexArray(0);
+}
+
+void LayerBuffer::drawBatches() const {
+    for (const auto &batch : batches_) {
+        if (batch.indexed) {
+            glMultiDrawElements(batch.mode, batch.counts.data(), GL_UNSIGNED_INT, batch.offsets.data(),
+                                static_cast<GLsizei>(batch.counts.size()));
+        } else {
+            glMultiDrawArrays(batch.mode, batch.firsts.data(), batch.counts.data(),
+                              static_cast<GLsizei>(batch.counts.size()));
+        }
+    }
+}
+
+void LayerBuffer::release() {
+    if (vao_ == 0) {
+        return;
+    }
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteBuffers(1, &vertex_vbo_);
+    glDeleteBuffers(1, &style_vbo_);
+    glDeleteBuffers(1, &ebo_);
+    if (pick_vbo_ != 0) {
+        glDeleteBuffers(1, &pick_vbo_);
+    }
+    vao_ = vertex_vbo_ = style_vbo_ = ebo_ = pick_vbo_ = 0;
+    ranges_.clear();
+    bounds_.clear();
+    styles_.clear();
+    id_index_.clear();
+    batches_.clear();
+    generation_ = next_generation++;
+    revision_ = generation_;
+    gpu_bytes_ = 0;
+}
+
+bool LayerBuffer::setFeatureState(uint32_t id, uint8_t state) {
+    auto [begin, end] = id_index_.equal_range(id);
+    if (begin == end || vao_ == 0) {
+        return false;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, style_vbo_);
+    for (auto it = begin; it != end; ++it) {
+        const auto &range = ranges_[it->second];
+        for (uint32_t i = range.first; i < range.first + range.count; ++i) {
+            styles_[i] = static_cast<uint16_t>((styles_[i] & 0xFFu) | state << 8);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, range.first * sizeof(uint16_t), range.count * sizeof(uint16_t),
+                        styles_.data() + range.first);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    revision_ = next_generation++;
+    return true;
+}
+
+uint8_t LayerBuffer::getFeatureState(uint32_t id) const {
+    auto it = id_index_.find(id);
+    if (it == id_index_.end() || ranges_[it->second].count == 0) {
+        return 0;
+    }
+    return static_cast<uint8_t>(styles_[ranges_[it->second].first] >> 8);
+}
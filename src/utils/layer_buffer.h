@@ -0,0 +1,150 @@
+#ifndef LAYER_BUFFER_H
+#define LAYER_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <unordered_map>
+
+// 单个要素在图层缓冲中的区间
+struct FeatureRange {
+    uint32_t id{};
+    GLenum mode{GL_TRIANGLES};
+    uint32_t first{};       // 首顶点
+    uint32_t count{};       // 顶点数
+    uint32_t firstIndex{};  // 首索引, 仅indexCount > 0时有效
+    uint32_t indexCount{};  // 为0时按glDrawArrays绘制
+};
+
+// 指向外部内存(如磁盘缓存的映射)的只读图层, 上传时不再拷贝
+struct LayerView {
+    const float *vertices{};
+    const uint16_t *styles{};
+    const uint32_t *indices{};
+    const FeatureRange *ranges{};
+    size_t vertexCount{};
+    size_t indexCount{};
+    size_t rangeCount{};
+};
+
+// 一个图层的全部几何, 顶点/样式/索引各自紧密排列, 可直接上传GPU
+struct LayerData {
+    std::vector<float> vertices;    // [x, y, z, x, y, z, ...]
+    std::vector<uint16_t> styles;   // 每顶点一个style::key
+    std::vector<uint32_t> indices;  // 已加上要素首顶点偏移
+    std::vector<FeatureRange> ranges;
+
+    // indices为要素内的局部索引, 为空时按glDrawArrays绘制; featureStyles应与points的点数一致
+    void addFeature(uint32_t id, GLenum mode, const std::vector<float> &points,
+                    const std::vector<uint16_t> &featureStyles,
+                    const std::vector<uint32_t> &featureIndices = {});
+    void addFeature(uint32_t id, GLenum mode, const std::vector<float> &points, uint16_t styleKey,
+                    const std::vector<uint32_t> &featureIndices = {});
+
+    [[nodiscard]] size_t vertexCount() const { return vertices.size() / 3; }
+    [[nodiscard]] LayerView view() const {
+        return {vertices.data(), styles.data(), indices.data(), ranges.data(), vertexCount(), indices.size(),
+                ranges.size()};
+    }
+    [[nodiscard]] static LayerData fromView(const LayerView &view);
+    [[nodiscard]] size_t byteSize() const {
+        return vertices.size() * sizeof(float) + styles.size() * sizeof(uint16_t) +
+               indices.size() * sizeof(uint32_t) + ranges.size() * sizeof(FeatureRange);
+    }
+};
+
+// LayerBuffer::cull()的结果: 按批次排列的间接绘制命令, 由LayerBuffer::draw(commands, ...)提交
+struct DrawCommands {
+    struct Batch {
+        GLenum mode{};
+        bool indexed{};
+        GLsizei drawCount{};
+        GLintptr indirectOffset{};          // 在words中的字节偏移
+        // 不支持间接绘制时的glMultiDraw*参数
+        std::vector<GLint> firsts;
+        std::vector<GLsizei> counts;
+        std::vector<const void *> offsets;
+    };
+    uint64_t generation{};                  // 剔除时图层的版本, 图层之后被修改过时命令作废
+    bool indirect{};
+    std::vector<Batch> batches;
+    // DrawElementsIndirectCommand(5个字)/DrawArraysIndirectCommand(4个字)按批次依次排列, 直接上传
+    std::vector<uint32_t> words;
+    size_t visible{};
+    size_t total{};
+};
+
+// 一个图层只占用一个VAO, 所有要素按绘制模式合批为glMultiDraw*调用.
+// 析构时不释放GL对象, 需在GL上下文销毁前显式调用release().
+class LayerBuffer {
+  public:
+    LayerBuffer() = default;
+    LayerBuffer(const LayerBuffer &) = delete;
+    LayerBuffer &operator=(const LayerBuffer &) = delete;
+    LayerBuffer(LayerBuffer &&other) noexcept;
+    LayerBuffer &operator=(LayerBuffer &&other) noexcept;
+
+    void upload(const LayerData &data) { upload(data.view()); }
+    void upload(const LayerView &view);
+    void draw() const;
+    // 拾取绘制: location 2为要素在ranges()中的下标+1, 首次调用时生成该属性缓冲
+    void drawPick();
+    void release();
+
+    // 只绘制和拾取visible返回true的要素, 立即按剩余要素重新合批, 不保存visible; 传空函数恢复全部.
+    // 重新upload后恢复全部
+    void setFilter(const std::function<bool(const FeatureRange &)> &visible);
+
+    // 对当前过滤后的要素做视锥剔除, 生成间接绘制命令. 视锥的裁剪范围各边外扩margin(相对于w)以容忍相机的移动.
+    // 只读取CPU端数据, 可在工作线程上调用, 期间不能修改该图层
+    void cull(const glm::mat4 &viewProjection, float margin, bool indirect, DrawCommands &commands) const;
+    // 提交cull()生成的命令: 间接命令由调用方写入indirectBuffer的indirectBase处后glMultiDraw*Indirect, 否则glMultiDraw*.
+    // 图层在cull()之后被修改过时按全部批次绘制
+    void draw(const DrawCommands &commands, unsigned int indirectBuffer = 0, GLintptr indirectBase = 0);
+
+    // 只改写该要素样式键的高8位, 通过glBufferSubData更新对应区间; 同一id的多个区间(如多种绘制模式)一起更新
+    bool setFeatureState(uint32_t id, uint8_t state);
+    [[nodiscard]] uint8_t getFeatureState(uint32_t id) const;
+
+    [[nodiscard]] const std::vector<FeatureRange> &ranges() const { return ranges_; }
+    // 与ranges()一一对应的包围盒, min xyz, max xyz
+    [[nodiscard]] const std::vector<std::array<float, 6>> &bounds() const { return bounds_; }
+    // 绘制结果的版本: 在generation之外, setFeatureState()也会更新; 缓存了绘制结果的视图(如小地图)据此判断是否需要重绘
+    [[nodiscard]] uint64_t revision() const { return revision_; }
+    [[nodiscard]] bool empty() const { return ranges_.empty(); }
+    // 顶点/样式/索引缓冲占用的显存字节数
+    [[nodiscard]] size_t gpuBytes() const { return gpu_bytes_; }
+
+  private:
+    void buildBatches(const std::function<bool(const FeatureRange &)> &visible);
+    void drawBatches() const;
+
+    struct Batch {
+        GLenum mode{};
+        bool indexed{};
+        std::vector<GLint> firsts;
+        std::vector<GLsizei> counts;
+        std::vector<const void *> offsets;
+        std::vector<uint32_t> members;  // ranges_下标, 供cull()使用
+    };
+
+    unsigned int vao_{};
+    unsigned int vertex_vbo_{};
+    unsigned int style_vbo_{};
+    unsigned int ebo_{};
+    unsigned int pick_vbo_{};
+
+    std::vector<FeatureRange> ranges_;
+    std::vector<std::array<float, 6>> bounds_;        // 每个要素的包围盒, min xyz, max xyz
+    std::vector<uint16_t> styles_;                    // 样式键的CPU副本
+    std::unordered_multimap<uint32_t, uint32_t> id_index_; // 要素id -> ranges_下标, 同一要素可能有多个区间
+    std::vector<Batch> batches_;
+    uint64_t generation_{};                           // upload/setFilter/release时更新, 全局唯一
+    uint64_t revision_{};
+    size_t gpu_bytes_{};
+};
+
+#endif //LAYER_BUFFER_H
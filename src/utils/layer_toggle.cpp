@@ -0,0 +1,45 @@
+#include "layer_toggle.h"
+#include "cull_pass.h"
+#include <iostream>
+
+void LayerToggle::setVisible(bool visible, double now) {
+    if (visible_ && !visible) {
+        hidden_since_ = now;
+    }
+    visible_ = visible;
+}
+
+void LayerToggle::update(double now, double unloadDelay) {
+    if (visible_ && !loaded_) {
+        loader_(buffer_);
+        loaded_ = true;
+        std::cout << "layer " << name_ << " loaded, " << buffer_.gpuBytes() / 1024 << " KiB" << std::endl;
+    } else if (!visible_ && loaded_ && now - hidden_since_ >= unloadDelay) {
+        buffer_.release();
+        loaded_ = false;
+        std::cout << "layer " << name_ << " unloaded" << std::endl;
+    }
+}
+
+void LayerToggle::draw() const {
+    if (visible_ && loaded_) {
+        buffer_.draw();
+    }
+}
+
+void LayerToggle::draw(CullPass &cull) {
+    if (visible_ && loaded_) {
+        cull.draw(buffer_);
+    }
+}
+
+void LayerToggle::release() {
+    buffer_.release();
+    loaded_ = false;
+}
+
+void LayerToggle::reload() {
+    if (loaded_) {
+        release();
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef LAYER_TOGGLE_H
+#define LAYER_TOGGLE_H
+
+#include <functional>
+#include <string>
+#include <utility>
+#include "layer_buffer.h"
+
+class CullPass;
+
+// 可开关的图层: 第一次可见时才调用loader(解码, 转换并上传), 隐藏超过卸载延迟后释放显存, 再次可见时重新加载.
+// 与LayerBuffer一样不在析构时释放GL对象.
+class LayerToggle {
+  public:
+    using Loader = std::function<void(LayerBuffer &)>;
+
+    LayerToggle(std::string name, Loader loader, bool visible = true)
+            : name_(std::move(name)), loader_(std::move(loader)), visible_(visible) {}
+
+    void setVisible(bool visible, double now);
+    void toggle(double now) { setVisible(!visible_, now); }
+    [[nodiscard]] bool visible() const { return visible_; }
+    [[nodiscard]] bool loaded() const { return loaded_; }
+    [[nodiscard]] const std::string &name() const { return name_; }
+
+    // 每帧调用: 可见且未加载时加载; 隐藏时间超过unloadDelay秒时卸载
+    void update(double now, double unloadDelay);
+    void draw() const;
+    // 按cull上一次的剔除结果绘制
+    void draw(CullPass &cull);
+    void release();
+    // 释放已加载的缓冲, 可见时下一次update按loader重新加载; 用于loader的输出发生变化后
+    void reload();
+
+    // 未加载时为空缓冲, 可安全调用setFeatureState
+    [[nodiscard]] LayerBuffer &buffer() { return buffer_; }
+
+  private:
+    std::string name_;
+    Loader loader_;
+    LayerBuffer buffer_;
+    bool visible_;
+    bool loaded_{false};
+    double hidden_since_{};
+};
+
+#endif //LAYER_TOGGLE_H
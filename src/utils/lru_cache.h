@@ -0,0 +1,103 @@
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// 按字节预算淘汰的LRU缓存, 每个条目由调用方给出占用字节数.
+// onEvict在条目被淘汰/删除时调用, 用于释放GL对象等外部资源.
+template<typename Key, typename Value>
+class LruCache {
+  public:
+    using EvictCallback = std::function<void(const Key &, Value &)>;
+
+    explicit LruCache(size_t budget = 0, EvictCallback onEvict = nullptr)
+            : budget_(budget), on_evict_(std::move(onEvict)) {}
+
+    // 命中时移到队首
+    Value *get(const Key &key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &it->second->value;
+    }
+
+    // 只查询, 不改变淘汰顺序
+    [[nodiscard]] bool contains(const Key &key) const { return index_.count(key) > 0; }
+
+    Value &put(const Key &key, Value value, size_t bytes) {
+        erase(key);
+        entries_.push_front({key, std::move(value), bytes});
+        index_[key] = entries_.begin();
+        used_ += bytes;
+        trim(1);
+        return entries_.front().value;
+    }
+
+    void erase(const Key &key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return;
+        }
+        evict(it->second);
+    }
+
+    void clear() {
+        while (!entries_.empty()) {
+            evict(std::prev(entries_.end()));
+        }
+    }
+
+    // 超出预算时从队尾淘汰, keep为队首至少保留的条目数
+    void trim(size_t keep = 0) {
+        while (used_ > budget_ && entries_.size() > keep) {
+            evict(std::prev(entries_.end()));
+        }
+    }
+
+    void setBudget(size_t budget) {
+        budget_ = budget;
+        trim();
+    }
+
+    template<typename Fn>
+    void forEach(Fn &&fn) {
+        for (auto &entry : entries_) {
+            fn(entry.key, entry.value);
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return entries_.size(); }
+    [[nodiscard]] size_t usedBytes() const { return used_; }
+    [[nodiscard]] size_t budget() const { return budget_; }
+
+  private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t bytes;
+    };
+    using Iterator = typename std::list<Entry>::iterator;
+
+    void evict(Iterator it) {
+        if (on_evict_) {
+            on_evict_(it->key, it->value);
+        }
+        used_ -= it->bytes;
+        index_.erase(it->key);
+        entries_.erase(it);
+    }
+
+    size_t budget_;
+    size_t used_{};
+    EvictCallback on_evict_;
+    std::list<Entry> entries_;
+    std::unordered_map<Key, Iterator> index_;
+};
+
+#endif //LRU_CACHE_H
@@ -0,0 +1,166 @@
+#include "minimap.h"
+#include "gl_util.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+    constexpr float kScale = 0.3f;     // 边长占视口短边的比例
+    constexpr int kMargin = 16;        // 与视口右上角的距离(像素)
+    constexpr int kBorder = 2;
+    constexpr int kMarker = 4;         // 相机标记的半宽(像素)
+    constexpr float kHeading = 12.0f;  // 朝向标记与相机标记的距离(像素)
+    constexpr float kPadding = 1.05f;  // 范围四周留白
+
+    // 用裁剪后的glClear填充, 覆盖颜色缓冲的清除色, 由调用方恢复
+    void fillRect(int x, int y, int width, int height, const glm::vec4 &color) {
+        glScissor(x, y, width, height);
+        glClearColor(color.x, color.y, color.z, color.w);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+}
+
+bool Minimap::init(int size) {
+    size_ = size;
+    glGenTextures(1, &color_);
+    glBindTexture(GL_TEXTURE_2D, color_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size_, size_, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size_, size_);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (!complete) {
+        std::cerr << "Minimap: framebuffer incomplete, minimap disabled" << std::endl;
+        release();
+        return false;
+    }
+    inited_ = true;
+    dirty_ = true;
+    return true;
+}
+
+void Minimap::render(GLUtil &gl_util, const std::vector<LayerBuffer *> &layers) {
+    if (!inited_) {
+        return;
+    }
+    GLint previousFbo = 0, viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    bool stale = dirty_ || signature_.size() != layers.size() || palette_revision_ != gl_util.paletteRevision();
+    for (size_t i = 0; i < layers.size() && !stale; ++i) {
+        stale = signature_[i].first != layers[i] || signature_[i].second != layers[i]->revision();
+    }
+    if (stale) {
+        redraw(gl_util, layers);
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        gl_util.setViewProjection(gl_util.viewMatrix(), gl_util.projectionMatrix());
+    }
+
+    // 拷到当前视口的右上角, 动态分辨率生效时视口是离屏FBO中缩小的区域, 随整帧一起放大
+    int side = static_cast<int>(static_cast<float>(std::min(viewport[2], viewport[3])) * kScale);
+    if (side <= 2 * kBorder) {
+        return;
+    }
+    int x0 = viewport[0] + viewport[2] - kMargin - side;
+    int y0 = viewport[1] + viewport[3] - kMargin - side;
+    const auto &palette = gl_util.palette();
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glEnable(GL_SCISSOR_TEST);
+    fillRect(x0 - kBorder, y0 - kBorder, side + 2 * kBorder, side + 2 * kBorder, palette.get(style::ROAD));
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    glBlitFramebuffer(0, 0, size_, size_, x0, y0, x0 + side, y0 + side, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFbo);
+
+    // 相机位置投影到小地图上, 超出范围时贴在边缘; 朝向取视线在水平面上的投影
+    glm::vec3 eye = gl_util.cameraPosition();
+    glm::vec4 clip = view_projection_ * glm::vec4(eye, 1.0f);
+    float px = std::clamp(clip.x * 0.5f + 0.5f, 0.0f, 1.0f) * static_cast<float>(side) + static_cast<float>(x0);
+    float py = std::clamp(clip.y * 0.5f + 0.5f, 0.0f, 1.0f) * static_cast<float>(side) + static_cast<float>(y0);
+    const auto &view = gl_util.viewMatrix();
+    glm::vec2 forward(-view[0][2], -view[1][2]);
+    const auto &marker = palette.get(style::ROUTE);
+    glEnable(GL_SCISSOR_TEST);
+    fillRect(static_cast<int>(px) - kMarker, static_cast<int>(py) - kMarker, 2 * kMarker, 2 * kMarker, marker);
+    float length = std::sqrt(forward.x * forward.x + forward.y * forward.y);
+    if (length > 1e-3f) {
+        int hx = static_cast<int>(px + forward.x / length * kHeading);
+        int hy = static_cast<int>(py + forward.y / length * kHeading);
+        fillRect(hx - kMarker / 2, hy - kMarker / 2, kMarker, kMarker, marker);
+    }
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+void Minimap::redraw(GLUtil &gl_util, const std::vector<LayerBuffer *> &layers) {
+    dirty_ = false;
+    palette_revision_ = gl_util.paletteRevision();
+    signature_.clear();
+    float lo[3], hi[3];
+    std::fill(lo, lo + 3, std::numeric_limits<float>::max());
+    std::fill(hi, hi + 3, std::numeric_limits<float>::lowest());
+    for (auto *layer : layers) {
+        signature_.emplace_back(layer, layer->revision());
+        for (const auto &box : layer->bounds()) {
+            for (int axis = 0; axis < 3; ++axis) {
+                lo[axis] = std::min(lo[axis], box[axis]);
+                hi[axis] = std::max(hi[axis], box[axis + 3]);
+            }
+        }
+    }
+    ++redraws_;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, size_, size_);
+    const auto &background = gl_util.palette().background;
+    const float one = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, &background[0]);
+    glClearBufferfv(GL_DEPTH, 0, &one);
+    if (lo[0] > hi[0]) {
+        return;
+    }
+
+    // 正上方俯视, 北(+y)朝上; 取长边为正方形范围, 保持比例
+    glm::vec3 center((lo[0] + hi[0]) * 0.5f, (lo[1] + hi[1]) * 0.5f, lo[2]);
+    float half = std::max({hi[0] - lo[0], hi[1] - lo[1], 1.0f}) * 0.5f * kPadding;
+    float height = hi[2] - lo[2] + 10.0f;
+    glm::mat4 view = glm::lookAt(glm::vec3(center.x, center.y, hi[2] + 10.0f), center, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::ortho(-half, half, -half, half, 1.0f, height + 10.0f);
+    view_projection_ = projection * view;
+    gl_util.setViewProjection(view, projection);
+    for (auto *layer : layers) {
+        layer->draw();
+    }
+}
+
+void Minimap::release() {
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+    }
+    if (color_ != 0) {
+        glDeleteTextures(1, &color_);
+    }
+    if (depth_ != 0) {
+        glDeleteRenderbuffers(1, &depth_);
+    }
+    fbo_ = color_ = depth_ = 0;
+    signature_.clear();
+    inited_ = false;
+}
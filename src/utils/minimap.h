@@ -0,0 +1,48 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "layer_buffer.h"
+
+class GLUtil;
+
+// 俯视小地图: 与主视图共用同一组LayerBuffer和GLUtil的主程序, 不复制几何数据. 用正交相机从正上方
+// 把图层画到一张纹理里缓存, 只在图层集合、图层内容(LayerBuffer::revision)或样式表变化时重画;
+// 其余帧只把纹理拷到当前帧缓冲的右上角, 再标出主视图相机的位置和朝向.
+// 与LayerBuffer一样不在析构时释放GL对象, 需显式调用release().
+class Minimap {
+  public:
+    Minimap() = default;
+    Minimap(const Minimap &) = delete;
+    Minimap &operator=(const Minimap &) = delete;
+
+    // size为缓存纹理的边长(像素)
+    bool init(int size = 512);
+    // 每帧在主绘制之后调用; 范围为layers包围盒的并集. 返回前恢复帧缓冲、视口和主程序的矩阵
+    void render(GLUtil &gl_util, const std::vector<LayerBuffer *> &layers);
+    // 下一次render()时强制重画
+    void invalidate() { dirty_ = true; }
+    // 缓存纹理的重画次数
+    [[nodiscard]] size_t redrawCount() const { return redraws_; }
+    void release();
+
+  private:
+    void redraw(GLUtil &gl_util, const std::vector<LayerBuffer *> &layers);
+
+    bool inited_{false};
+    int size_{};
+    unsigned int fbo_{}, color_{}, depth_{};
+    bool dirty_{true};
+    // 上次重画时的图层及其版本, 样式表版本
+    std::vector<std::pair<const LayerBuffer *, uint64_t>> signature_;
+    uint64_t palette_revision_{};
+    glm::mat4 view_projection_{1.0f};  // 缓存纹理的矩阵, 用于标出相机
+    size_t redraws_{};
+};
+
+#endif //MINIMAP_H
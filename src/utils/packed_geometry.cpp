@@ -0,0 +1,110 @@
+#include "packed_geometry.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    struct PackedHeader {
+        uint8_t version;
+        uint8_t encoding;
+        uint16_t reserved;
+        uint32_t count;
+    };
+    static_assert(sizeof(PackedHeader) == 8, "packed geometry header layout changed");
+
+    // 经纬度1e-8度约1.1mm, 高程1mm
+    const double kScale[3] = {1e-8, 1e-8, 1e-3};
+
+    bool quantize(double value, double scale, int64_t &out) {
+        double q = std::round(value / scale);
+        if (!(std::fabs(q) < 9.0e18)) {
+            return false;
+        }
+        out = static_cast<int64_t>(q);
+        return true;
+    }
+}
+
+bool unpack_points(const void *data, size_t size, std::vector<double> &points) {
+    PackedHeader header{};
+    if (size < sizeof(header)) {
+        return false;
+    }
+    auto bytes = static_cast<const uint8_t *>(data);
+    std::memcpy(&header, bytes, sizeof(header));
+    if (header.version != kPackedGeometryVersion) {
+        return false;
+    }
+    bytes += sizeof(header);
+    size_t values = static_cast<size_t>(header.count) * 3;
+
+    if (header.encoding == static_cast<uint8_t>(PackedEncoding::RAW_F64)) {
+        if (size != sizeof(header) + values * sizeof(double)) {
+            return false;
+        }
+        size_t first = points.size();
+        points.resize(first + values);
+        std::memcpy(points.data() + first, bytes, values * sizeof(double));
+        return true;
+    }
+    if (header.encoding == static_cast<uint8_t>(PackedEncoding::DELTA_I32)) {
+        if (size != sizeof(header) + 3 * sizeof(double) + values * sizeof(int32_t)) {
+            return false;
+        }
+        double origin[3];
+        std::memcpy(origin, bytes, sizeof(origin));
+        bytes += sizeof(origin);
+
+        int64_t q[3] = {0, 0, 0};
+        size_t first = points.size();
+        points.resize(first + values);
+        double *out = points.data() + first;
+        for (size_t i = 0; i < values; ++i) {
+            int32_t delta;
+            std::memcpy(&delta, bytes + i * sizeof(int32_t), sizeof(delta));
+            size_t axis = i % 3;
+            q[axis] += delta;
+            out[i] = origin[axis] + static_cast<double>(q[axis]) * kScale[axis];
+        }
+        return true;
+    }
+    return false;
+}
+
+std::string pack_points(const double *points, size_t count, PackedEncoding encoding) {
+    PackedHeader header{kPackedGeometryVersion, static_cast<uint8_t>(encoding), 0, static_cast<uint32_t>(count)};
+    size_t values = count * 3;
+
+    if (encoding == PackedEncoding::DELTA_I32 && count > 0) {
+        std::string out(sizeof(header) + 3 * sizeof(double) + values * sizeof(int32_t), '\0');
+        std::memcpy(&out[0], &header, sizeof(header));
+        // 以首点为原点, 增量在量化后的整数上累计, 不会累积舍入误差
+        std::memcpy(&out[sizeof(header)], points, 3 * sizeof(double));
+        char *dst = &out[sizeof(header) + 3 * sizeof(double)];
+        int64_t prev[3] = {0, 0, 0};
+        bool fits = true;
+        for (size_t i = 0; i < values && fits; ++i) {
+            size_t axis = i % 3;
+            int64_t q = 0;
+            fits = quantize(points[i] - points[axis], kScale[axis], q);
+            int64_t delta = q - prev[axis];
+            if (delta < std::numeric_limits<int32_t>::min() || delta > std::numeric_limits<int32_t>::max()) {
+                fits = false;
+            }
+            auto delta32 = static_cast<int32_t>(delta);
+            std::memcpy(dst + i * sizeof(int32_t), &delta32, sizeof(delta32));
+            prev[axis] = q;
+        }
+        if (fits) {
+            return out;
+        }
+    }
+
+    header.encoding = static_cast<uint8_t>(PackedEncoding::RAW_F64);
+    std::string out(sizeof(header) + values * sizeof(double), '\0');
+    std::memcpy(&out[0], &header, sizeof(header));
+    if (values > 0) {
+        std::memcpy(&out[sizeof(header)], points, values * sizeof(double));
+    }
+    return out;
+}
@@ -0,0 +1,29 @@
+#ifndef PACKED_GEOMETRY_H
+#define PACKED_GEOMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Polyline.buffer / Polygon.buffer 的打包格式, 小端:
+//   uint8  version         = kPackedGeometryVersion
+//   uint8  encoding        PackedEncoding
+//   uint16 reserved        = 0
+//   uint32 point_count
+//   RAW_F64:   double[point_count * 3]                    lon, lat, alt
+//   DELTA_I32: double origin[3], int32[point_count * 3]   相对上一点的增量, 经纬度单位1e-8度, 高程单位1mm
+constexpr uint8_t kPackedGeometryVersion = 1;
+
+enum class PackedEncoding : uint8_t {
+    RAW_F64 = 0,
+    DELTA_I32 = 1,
+};
+
+// 解码并追加到points, 版本/长度不符时返回false且不修改points
+bool unpack_points(const void *data, size_t size, std::vector<double> &points);
+
+// DELTA_I32在增量超出int32时自动改用RAW_F64
+std::string pack_points(const double *points, size_t count, PackedEncoding encoding = PackedEncoding::DELTA_I32);
+
+#endif //PACKED_GEOMETRY_H
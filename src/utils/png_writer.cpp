@@ -0,0 +1,58 @@
+#include "png_writer.h"
+#include <fstream>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+    void putU32(std::vector<uint8_t> &out, uint32_t value) {
+        out.insert(out.end(), {static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                               static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)});
+    }
+
+    // 长度 + 类型 + 数据 + 类型与数据的CRC
+    void putChunk(std::vector<uint8_t> &out, const char *type, const uint8_t *data, size_t size) {
+        putU32(out, static_cast<uint32_t>(size));
+        size_t begin = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data, data + size);
+        putU32(out, static_cast<uint32_t>(crc32(0, out.data() + begin, static_cast<uInt>(size + 4))));
+    }
+}
+
+bool write_png_rgb(const std::string &path, int width, int height, const uint8_t *rgba, int level) {
+    if (width <= 0 || height <= 0 || rgba == nullptr) {
+        return false;
+    }
+    size_t stride = static_cast<size_t>(width) * 3 + 1;
+    std::vector<uint8_t> filtered(stride * height);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *src = rgba + static_cast<size_t>(height - 1 - y) * width * 4;
+        uint8_t *dst = filtered.data() + stride * y;
+        dst[0] = 1;  // Sub: 减去左边像素的同一通道
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                uint8_t left = x > 0 ? src[(x - 1) * 4 + c] : 0;
+                dst[1 + x * 3 + c] = static_cast<uint8_t>(src[x * 4 + c] - left);
+            }
+        }
+    }
+    uLongf compressedSize = compressBound(static_cast<uLong>(filtered.size()));
+    std::vector<uint8_t> compressed(compressedSize);
+    if (compress2(compressed.data(), &compressedSize, filtered.data(), static_cast<uLong>(filtered.size()), level) !=
+        Z_OK) {
+        return false;
+    }
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> header;
+    putU32(header, static_cast<uint32_t>(width));
+    putU32(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), {8, 2, 0, 0, 0});  // 8位, RGB, deflate, 自适应滤波, 不隔行
+    putChunk(png, "IHDR", header.data(), header.size());
+    putChunk(png, "IDAT", compressed.data(), compressedSize);
+    putChunk(png, "IEND", nullptr, 0);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(png.data()), static_cast<std::streamsize>(png.size()));
+    return static_cast<bool>(file);
+}
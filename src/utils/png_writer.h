@@ -0,0 +1,11 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <cstdint>
+#include <string>
+
+// 把width x height的RGBA8像素(glReadPixels的行序, 自下而上)写成8位RGB的PNG, 丢弃alpha.
+// 每行使用Sub滤波, 地图画面大片同色, 用zlib最快的level压缩也很小. 返回是否写入成功
+bool write_png_rgb(const std::string &path, int width, int height, const uint8_t *rgba, int level = 1);
+
+#endif //PNG_WRITER_H
@@ -0,0 +1,365 @@
+#include "road_tile_decoder.h"
+#include <cstring>
+#include <stdexcept>
+#include "packed_geometry.h"
+
+namespace {
+    enum WireType : uint32_t {
+        VARINT = 0, FIXED64 = 1, LENGTH_DELIMITED = 2, FIXED32 = 5
+    };
+
+    // RoadTile中的字段号, 与road_tile.proto保持一致
+    enum TileField : uint32_t {
+        FIELD_ROAD = 11, FIELD_POI = 101, FIELD_ROAD_MARK = 103, FIELD_ROAD_OBSTACLE = 104, FIELD_PARKING_SPACE = 107
+    };
+
+    class WireReader {
+      public:
+        WireReader(const uint8_t *begin, const uint8_t *end) : p_(begin), end_(end) {}
+
+        [[nodiscard]] bool ok() const { return ok_; }
+        [[nodiscard]] bool done() const { return p_ >= end_ || !ok_; }
+
+        bool next(uint32_t &field, uint32_t &wire) {
+            if (done()) {
+                return false;
+            }
+            uint64_t tag = varint();
+            field = static_cast<uint32_t>(tag >> 3);
+            wire = static_cast<uint32_t>(tag & 7u);
+            return ok_ && field != 0;
+        }
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64 && p_ < end_; shift += 7) {
+                uint8_t byte = *p_++;
+                value |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+                if ((byte & 0x80u) == 0) {
+                    return value;
+                }
+            }
+            ok_ = false;
+            return 0;
+        }
+
+        double fixed64() {
+            double value = 0;
+            if (end_ - p_ < 8) {
+                ok_ = false;
+                return value;
+            }
+            std::memcpy(&value, p_, 8);
+            p_ += 8;
+            return value;
+        }
+
+        float fixed32() {
+            float value = 0;
+            if (end_ - p_ < 4) {
+                ok_ = false;
+                return value;
+            }
+            std::memcpy(&value, p_, 4);
+            p_ += 4;
+            return value;
+        }
+
+        WireReader message() {
+            uint64_t length = varint();
+            if (!ok_ || length > static_cast<uint64_t>(end_ - p_)) {
+                ok_ = false;
+                return {end_, end_};
+            }
+            WireReader sub(p_, p_ + length);
+            p_ += length;
+            return sub;
+        }
+
+        void skip(uint32_t wire) {
+            switch (wire) {
+                case VARINT:
+                    varint();
+                    break;
+                case FIXED64:
+                    advance(8);
+                    break;
+                case LENGTH_DELIMITED: {
+                    uint64_t length = varint();
+                    if (ok_ && length <= static_cast<uint64_t>(end_ - p_)) {
+                        p_ += length;
+                    } else {
+                        ok_ = false;
+                    }
+                    break;
+                }
+                case FIXED32:
+                    advance(4);
+                    break;
+                default:
+                    ok_ = false;  // proto3中不会出现group
+            }
+        }
+
+        void fail() { ok_ = false; }
+
+        [[nodiscard]] const uint8_t *data() const { return p_; }
+        [[nodiscard]] size_t remaining() const { return end_ - p_; }
+
+      private:
+        void advance(size_t n) {
+            if (static_cast<size_t>(end_ - p_) < n) {
+                ok_ = false;
+                return;
+            }
+            p_ += n;
+        }
+
+        const uint8_t *p_;
+        const uint8_t *end_;
+        bool ok_ = true;
+    };
+
+    // Point { double longitude = 1; double latitude = 2; double altitude = 3; }
+    bool readPoint(WireReader reader, std::vector<double> &points) {
+        double xyz[3] = {0.0, 0.0, 0.0};
+        // 三个字段都存在时的固定布局: 09 <8B> 11 <8B> 19 <8B>
+        const uint8_t *p = reader.data();
+        if (reader.remaining() == 27 && p[0] == 0x09 && p[9] == 0x11 && p[18] == 0x19) {
+            std::memcpy(&xyz[0], p + 1, 8);
+            std::memcpy(&xyz[1], p + 10, 8);
+            std::memcpy(&xyz[2], p + 19, 8);
+        } else {
+            uint32_t field, wire;
+            while (reader.next(field, wire)) {
+                if (field >= 1 && field <= 3 && wire == FIXED64) {
+                    xyz[field - 1] = reader.fixed64();
+                } else {
+                    reader.skip(wire);
+                }
+            }
+            if (!reader.ok()) {
+                return false;
+            }
+        }
+        points.insert(points.end(), xyz, xyz + 3);
+        return true;
+    }
+
+    // 各类id消息中count字段的字段号: RoadId.count = 2, AttributeId.count = 3
+    uint32_t readCount(WireReader reader, uint32_t count_field) {
+        uint32_t field, wire;
+        uint32_t count = 0;
+        while (reader.next(field, wire)) {
+            if (field == count_field && wire == VARINT) {
+                count = static_cast<uint32_t>(reader.varint());
+            } else {
+                reader.skip(wire);
+            }
+        }
+        return count;
+    }
+
+    // Polyline { repeated Point points = 1; float length = 2; bytes buffer = 3; }, buffer格式见packed_geometry.h
+    bool readPolyline(WireReader reader, std::vector<double> &points) {
+        uint32_t field, wire;
+        while (reader.next(field, wire)) {
+            if (field == 1 && wire == LENGTH_DELIMITED) {
+                if (!readPoint(reader.message(), points)) {
+                    return false;
+                }
+            } else if (field == 3 && wire == LENGTH_DELIMITED) {
+                auto buffer = reader.message();
+                if (buffer.remaining() > 0 && !unpack_points(buffer.data(), buffer.remaining(), points)) {
+                    return false;
+                }
+            } else {
+                reader.skip(wire);
+            }
+        }
+        return reader.ok();
+    }
+
+    bool readRoad(WireReader reader, DecodedRoadTile &tile) {
+        auto &layer = tile.roads;
+        uint32_t id = 0, head = 0, tail = 0;
+        uint8_t direction = 0;
+        float length = 0.0f;
+        uint32_t field, wire;
+        while (reader.next(field, wire)) {
+            if (field == 1 && wire == LENGTH_DELIMITED) {
+                id = readCount(reader.message(), 2);
+            } else if (field == 3 && wire == LENGTH_DELIMITED) {
+                head = readCount(reader.message(), 2);
+            } else if (field == 4 && wire == LENGTH_DELIMITED) {
+                tail = readCount(reader.message(), 2);
+            } else if (field == 8 && wire == VARINT) {
+                direction = static_cast<uint8_t>(reader.varint());
+            } else if (field == 5 && wire == FIXED32) {
+                length = reader.fixed32();
+            } else if (field == 7 && wire == LENGTH_DELIMITED) {
+                if (!readPolyline(reader.message(), layer.points)) {
+                    return false;
+                }
+            } else {
+                // lane_group_ab/ba等大字段在这里整段跳过
+                reader.skip(wire);
+            }
+        }
+        if (!reader.ok()) {
+            return false;
+        }
+        layer.ids.push_back(id);
+        layer.types.push_back(0);
+        layer.offsets.push_back(static_cast<uint32_t>(layer.points.size() / 3));
+        tile.road_lengths.push_back(length);
+        tile.road_heads.push_back(head);
+        tile.road_tails.push_back(tail);
+        tile.road_directions.push_back(direction);
+        return true;
+    }
+
+    // POI/RoadMark/RoadObstacle/ParkingSpace: id = 1(AttributeId), 类型和形状点的字段号各不相同
+    bool readAttribute(WireReader reader, TileLayer &layer, uint32_t type_field, uint32_t shape_field) {
+        uint32_t id = 0;
+        uint32_t type = 0;
+        uint32_t field, wire;
+        while (reader.next(field, wire)) {
+            if (field == 1 && wire == LENGTH_DELIMITED) {
+                id = readCount(reader.message(), 3);
+            } else if (field == type_field && wire == VARINT) {
+                type = static_cast<uint32_t>(reader.varint());
+            } else if (field == shape_field && wire == LENGTH_DELIMITED) {
+                if (!readPoint(reader.message(), layer.points)) {
+                    return false;
+                }
+            } else {
+                reader.skip(wire);
+            }
+        }
+        if (!reader.ok()) {
+            return false;
+        }
+        layer.ids.push_back(id);
+        layer.types.push_back(type);
+        layer.offsets.push_back(static_cast<uint32_t>(layer.points.size() / 3));
+        return true;
+    }
+
+    template<typename Shape>
+    void appendShape(const Shape &shape, TileLayer &layer) {
+        for (const auto &p : shape) {
+            layer.points.push_back(p.longitude());
+            layer.points.push_back(p.latitude());
+            layer.points.push_back(p.altitude());
+        }
+        layer.offsets.push_back(static_cast<uint32_t>(layer.points.size() / 3));
+    }
+}
+
+void TileLayer::clear() {
+    ids.clear();
+    types.clear();
+    offsets.assign(1, 0);
+    points.clear();
+}
+
+void DecodedRoadTile::clear() {
+    roads.clear();
+    road_lengths.clear();
+    road_heads.clear();
+    road_tails.clear();
+    road_directions.clear();
+    pois.clear();
+    road_marks.clear();
+    road_obstacles.clear();
+    parking_spaces.clear();
+}
+
+bool decode_road_tile(const void *data, size_t size, DecodedRoadTile &tile, uint32_t layers) {
+    if (layers & TILE_ROADS) {
+        tile.roads.clear();
+        tile.road_lengths.clear();
+        tile.road_heads.clear();
+        tile.road_tails.clear();
+        tile.road_directions.clear();
+    }
+    if (layers & TILE_POIS) {
+        tile.pois.clear();
+    }
+    if (layers & TILE_ROAD_MARKS) {
+        tile.road_marks.clear();
+    }
+    if (layers & TILE_ROAD_OBSTACLES) {
+        tile.road_obstacles.clear();
+    }
+    if (layers & TILE_PARKING_SPACES) {
+        tile.parking_spaces.clear();
+    }
+    auto begin = static_cast<const uint8_t *>(data);
+    WireReader reader(begin, begin + size);
+    uint32_t field, wire;
+    while (reader.next(field, wire)) {
+        if (wire != LENGTH_DELIMITED) {
+            reader.skip(wire);
+            continue;
+        }
+        bool ok = true;
+        if (field == FIELD_ROAD && (layers & TILE_ROADS)) {
+            ok = readRoad(reader.message(), tile);
+        } else if (field == FIELD_POI && (layers & TILE_POIS)) {
+            ok = readAttribute(reader.message(), tile.pois, 3, 4);
+        } else if (field == FIELD_ROAD_MARK && (layers & TILE_ROAD_MARKS)) {
+            ok = readAttribute(reader.message(), tile.road_marks, 3, 5);
+        } else if (field == FIELD_ROAD_OBSTACLE && (layers & TILE_ROAD_OBSTACLES)) {
+            ok = readAttribute(reader.message(), tile.road_obstacles, 3, 5);
+        } else if (field == FIELD_PARKING_SPACE && (layers & TILE_PARKING_SPACES)) {
+            ok = readAttribute(reader.message(), tile.parking_spaces, 0, 4);
+        } else {
+            reader.skip(wire);
+        }
+        if (!ok) {
+            reader.fail();
+        }
+    }
+    return reader.ok();
+}
+
+void decode_road_tile(const hdmap::data::proto::RoadTile &road_tile, DecodedRoadTile &tile) {
+    tile.clear();
+    for (const auto &road : road_tile.road()) {
+        tile.roads.ids.push_back(road.id().count());
+        tile.roads.types.push_back(0);
+        const auto &road_center = road.road_center();
+        if (!road_center.buffer().empty()) {
+            if (!unpack_points(road_center.buffer().data(), road_center.buffer().size(), tile.roads.points)) {
+                throw std::runtime_error("Unsupported Polyline.buffer layout.");
+            }
+        }
+        appendShape(road_center.points(), tile.roads);
+        tile.road_lengths.push_back(road.length());
+        tile.road_heads.push_back(road.head_id().count());
+        tile.road_tails.push_back(road.tail_id().count());
+        tile.road_directions.push_back(static_cast<uint8_t>(road.travel_direction()));
+    }
+    for (const auto &poi : road_tile.poi()) {
+        tile.pois.ids.push_back(poi.id().count());
+        tile.pois.types.push_back(poi.poi_type());
+        appendShape(poi.shape(), tile.pois);
+    }
+    for (const auto &road_mark : road_tile.road_mark()) {
+        tile.road_marks.ids.push_back(road_mark.id().count());
+        tile.road_marks.types.push_back(road_mark.type());
+        appendShape(road_mark.shape(), tile.road_marks);
+    }
+    for (const auto &obstacle : road_tile.road_obstacle()) {
+        tile.road_obstacles.ids.push_back(obstacle.id().count());
+        tile.road_obstacles.types.push_back(obstacle.type());
+        appendShape(obstacle.shape(), tile.road_obstacles);
+    }
+    for (const auto &pks : road_tile.parking_space()) {
+        tile.parking_spaces.ids.push_back(pks.id().count());
+        tile.parking_spaces.types.push_back(0);
+        appendShape(pks.shape(), tile.parking_spaces);
+    }
+}
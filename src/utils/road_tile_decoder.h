@@ -0,0 +1,54 @@
+#ifndef ROAD_TILE_DECODER_H
+#define ROAD_TILE_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "road_tile.pb.h"
+
+// 一类要素的扁平数组, 第i个要素的点为 points[offsets[i] * 3, offsets[i + 1] * 3)
+struct TileLayer {
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> types;     // POI/RoadMark/RoadObstacle的类型枚举, 其余图层为0
+    std::vector<uint32_t> offsets{0};
+    std::vector<double> points;      // [lon, lat, alt, lon, lat, alt, ...]
+
+    [[nodiscard]] size_t size() const { return ids.size(); }
+    [[nodiscard]] uint32_t pointCount(size_t i) const { return offsets[i + 1] - offsets[i]; }
+    [[nodiscard]] const double *point(size_t i) const { return points.data() + offsets[i] * 3; }
+    void clear();
+};
+
+// RoadTile中实际参与渲染的部分
+struct DecodedRoadTile {
+    TileLayer roads;                 // road(11).road_center
+    std::vector<float> road_lengths;
+    std::vector<uint32_t> road_heads;    // road.head_id.count, 与tail_id一起构成路网拓扑
+    std::vector<uint32_t> road_tails;    // road.tail_id.count
+    std::vector<uint8_t> road_directions;  // road.travel_direction
+    TileLayer pois;                  // poi(101).shape
+    TileLayer road_marks;            // road_mark(103).shape
+    TileLayer road_obstacles;        // road_obstacle(104).shape
+    TileLayer parking_spaces;        // parking_space(107).shape
+
+    void clear();
+};
+
+// decode_road_tile的图层掩码
+enum TileLayerMask : uint32_t {
+    TILE_ROADS = 1u << 0,
+    TILE_POIS = 1u << 1,
+    TILE_ROAD_MARKS = 1u << 2,
+    TILE_ROAD_OBSTACLES = 1u << 3,
+    TILE_PARKING_SPACES = 1u << 4,
+    TILE_ALL_LAYERS = (1u << 5) - 1,
+};
+
+// 直接扫描protobuf wire format, 只解码layers中的图层, 其余字段(车道组/ADAS/经验轨迹等)整段跳过.
+// 只清空并重填layers中的图层, 可分多次解码到同一个tile. 数据损坏时返回false, tile内容不确定.
+bool decode_road_tile(const void *data, size_t size, DecodedRoadTile &tile, uint32_t layers = TILE_ALL_LAYERS);
+
+// 从完整解析的消息提取, 作为兜底路径和基准对照
+void decode_road_tile(const hdmap::data::proto::RoadTile &road_tile, DecodedRoadTile &tile);
+
+#endif //ROAD_TILE_DECODER_H
@@ -0,0 +1,288 @@
+#include "shader_manager.h"
+#include "geometry_cache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const char kMagic[4] = {'M', 'M', 'S', 'P'};
+    constexpr uint32_t kFormatVersion = 1;
+    // GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile, glad中未生成
+    constexpr GLenum kCompletionStatus = 0x91B1;
+
+    struct BinaryHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+    static_assert(sizeof(BinaryHeader) == 24, "shader cache header layout changed");
+
+    double now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::string glString(GLenum name) {
+        auto value = reinterpret_cast<const char *>(glGetString(name));
+        return value ? value : "";
+    }
+
+    bool hasExtension(const char *name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            auto extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension && std::strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    GLuint compile(GLenum type, const std::string &source) {
+        GLuint shader = glCreateShader(type);
+        const char *code = source.c_str();
+        glShaderSource(shader, 1, &code, nullptr);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    void printCompileErrors(GLuint shader, const std::string &type) {
+        GLint success = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            GLchar infoLog[1024];
+            glGetShaderInfoLog(shader, 1024, nullptr, infoLog);
+            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << std::endl;
+        }
+    }
+
+    std::string hex(uint64_t value) {
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(value));
+        return buf;
+    }
+}
+
+std::string ShaderManager::defaultCacheDir() {
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::string(xdg) + "/offline_map/shaders";
+    }
+    if (const char *home = std::getenv("HOME"); home && *home) {
+        return std::string(home) + "/.cache/offline_map/shaders";
+    }
+    return "";
+}
+
+void ShaderManager::init(const std::string &cache_dir) {
+    driver_ = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+    parallel_ = hasExtension("GL_KHR_parallel_shader_compile") || hasExtension("GL_ARB_parallel_shader_compile");
+
+    GLint formats = 0;
+    if (GLAD_GL_VERSION_4_1) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    binary_supported_ = formats > 0;
+
+    dir_.clear();
+    if (!binary_supported_ || cache_dir.empty()) {
+        return;
+    }
+    std::error_code ec;
+    fs::create_directories(cache_dir, ec);
+    if (ec || !fs::is_directory(cache_dir, ec)) {
+        std::cerr << "ShaderManager: binary cache disabled, cannot create " << cache_dir << std::endl;
+        return;
+    }
+    dir_ = cache_dir;
+}
+
+ShaderManager::Handle ShaderManager::add(const std::string &name, const std::string &vertex,
+                                         const std::string &fragment, const std::vector<std::string> &uniforms,
+                                         const std::vector<std::pair<std::string, GLuint>> &blocks) {
+    Program program;
+    program.name = name;
+    program.uniformNames = uniforms;
+    program.blocks = blocks;
+    program.startTime = now();
+    std::string source = vertex + '\0' + fragment + '\0' + driver_;
+    program.key = fnv1a64(source.data(), source.size(), fnv1a64(&kFormatVersion, sizeof(kFormatVersion)));
+
+    program.id = glCreateProgram();
+    if (loadBinary(program)) {
+        program.fromCache = true;
+    } else {
+        // 支持并行编译时这里只是提交, 链接结果在finish()中才读取
+        program.vertex = compile(GL_VERTEX_SHADER, vertex);
+        program.fragment = compile(GL_FRAGMENT_SHADER, fragment);
+        glAttachShader(program.id, program.vertex);
+        glAttachShader(program.id, program.fragment);
+        if (binary_supported_) {
+            glProgramParameteri(program.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glLinkProgram(program.id);
+    }
+    programs_.push_back(std::move(program));
+    return programs_.size() - 1;
+}
+
+bool ShaderManager::ready(Handle handle) const {
+    const auto &program = programs_.at(handle);
+    if (program.finished || !parallel_) {
+        return true;
+    }
+    GLint done = GL_TRUE;
+    glGetProgramiv(program.id, kCompletionStatus, &done);
+    return done == GL_TRUE;
+}
+
+GLuint ShaderManager::program(Handle handle) {
+    auto &program = programs_.at(handle);
+    if (!program.finished) {
+        finish(program);
+    }
+    return program.id;
+}
+
+void ShaderManager::use(Handle handle) {
+    glUseProgram(program(handle));
+}
+
+GLint ShaderManager::uniform(Handle handle, size_t index) {
+    program(handle);
+    return programs_[handle].locations.at(index);
+}
+
+void ShaderManager::finish(Program &program) {
+    program.finished = true;
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program.id, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        if (program.vertex) {
+            printCompileErrors(program.vertex, "VERTEX");
+            printCompileErrors(program.fragment, "FRAGMENT");
+        }
+        GLchar infoLog[1024];
+        glGetProgramInfoLog(program.id, 1024, nullptr, infoLog);
+        std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: PROGRAM " << program.name << "\n" << infoLog << std::endl;
+    }
+    if (program.vertex) {
+        glDetachShader(program.id, program.vertex);
+        glDetachShader(program.id, program.fragment);
+        glDeleteShader(program.vertex);
+        glDeleteShader(program.fragment);
+        program.vertex = program.fragment = 0;
+    }
+    if (!linked) {
+        glDeleteProgram(program.id);
+        program.id = 0;
+    }
+    if (program.id == 0) {
+        program.locations.assign(program.uniformNames.size(), -1);
+        return;
+    }
+    if (!program.fromCache) {
+        storeBinary(program);
+    }
+
+    program.locations.clear();
+    for (const auto &name : program.uniformNames) {
+        program.locations.push_back(glGetUniformLocation(program.id, name.c_str()));
+    }
+    // 块绑定不保证随二进制保存, 每次就绪时重新设置
+    for (const auto &[name, binding] : program.blocks) {
+        GLuint index = glGetUniformBlockIndex(program.id, name.c_str());
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program.id, index, binding);
+        }
+    }
+    std::cout << "shader " << program.name << (program.fromCache ? " loaded from binary cache" : " compiled")
+              << " in " << (now() - program.startTime) * 1000.0 << " ms" << std::endl;
+}
+
+bool ShaderManager::loadBinary(Program &program) const {
+    if (dir_.empty()) {
+        return false;
+    }
+    auto path = dir_ + "/" + hex(program.key) + ".bin";
+    std::ifstream in(path, std::ios::binary);
+    BinaryHeader header{};
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) || std::memcmp(header.magic, kMagic, 4) != 0 ||
+        header.version != kFormatVersion || header.key != program.key) {
+        return false;
+    }
+    std::vector<char> binary(header.length);
+    if (!in.read(binary.data(), header.length)) {
+        return false;
+    }
+    glProgramBinary(program.id, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program.id, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // 驱动拒绝旧二进制时删掉, 下次重新编译写入
+        std::error_code ec;
+        fs::remove(path, ec);
+        return false;
+    }
+    return true;
+}
+
+void ShaderManager::storeBinary(const Program &program) const {
+    if (dir_.empty()) {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(program.id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program.id, length, &length, &format, binary.data());
+
+    BinaryHeader header{};
+    std::memcpy(header.magic, kMagic, 4);
+    header.version = kFormatVersion;
+    header.key = program.key;
+    header.format = format;
+    header.length = static_cast<uint32_t>(length);
+
+    // 与GeometryCache相同, 先写临时文件再rename
+    auto target = dir_ + "/" + hex(program.key) + ".bin";
+    auto tmp = target + ".tmp" + std::to_string(getpid()) + "_" +
+               std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(binary.data(), length);
+        if (!out) {
+            std::error_code ec;
+            fs::remove(tmp, ec);
+            return;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, target, ec);
+}
+
+void ShaderManager::release() {
+    for (auto &program : programs_) {
+        if (program.vertex) {
+            glDeleteShader(program.vertex);
+            glDeleteShader(program.fragment);
+        }
+        if (program.id) {
+            glDeleteProgram(program.id);
+        }
+    }
+    programs_.clear();
+}
@@ -0,0 +1,70 @@
+#ifndef SHADER_MANAGER_H
+#define SHADER_MANAGER_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 着色器程序管理.
+// - 链接后的程序二进制(glGetProgramBinary)缓存到磁盘, 键为源码与GL_VENDOR/RENDERER/VERSION的哈希, 驱动升级后自动失效;
+// - 驱动支持KHR/ARB_parallel_shader_compile时, add()只提交编译, 首次use()/program()时才等待结果, 可与加载数据并行;
+// - uniform位置在程序就绪时按注册顺序解析一次, 之后按下标取用, 不再每帧按名字查询.
+// 需在GL上下文创建后使用, 析构时不释放GL对象, 需显式调用release().
+class ShaderManager {
+  public:
+    using Handle = size_t;
+
+    ShaderManager() = default;
+    ShaderManager(const ShaderManager &) = delete;
+    ShaderManager &operator=(const ShaderManager &) = delete;
+
+    // cache_dir为空或无法创建时不使用磁盘缓存
+    void init(const std::string &cache_dir);
+
+    // blocks: (uniform块名, 绑定点)
+    Handle add(const std::string &name, const std::string &vertex, const std::string &fragment,
+               const std::vector<std::string> &uniforms,
+               const std::vector<std::pair<std::string, GLuint>> &blocks = {});
+
+    // 不阻塞地查询程序是否已可用
+    [[nodiscard]] bool ready(Handle handle) const;
+    // 未完成编译时阻塞等待, 失败时返回0
+    GLuint program(Handle handle);
+    void use(Handle handle);
+    // 下标对应add()时uniforms的顺序, 程序中不存在(或被优化掉)的uniform为-1
+    GLint uniform(Handle handle, size_t index);
+
+    void release();
+
+    // $XDG_CACHE_HOME/offline_map/shaders 或 ~/.cache/offline_map/shaders
+    static std::string defaultCacheDir();
+
+  private:
+    struct Program {
+        std::string name;
+        std::vector<std::string> uniformNames;
+        std::vector<std::pair<std::string, GLuint>> blocks;
+        std::vector<GLint> locations;
+        uint64_t key{};
+        GLuint id{};
+        GLuint vertex{};        // 编译中的着色器, 结束后删除
+        GLuint fragment{};
+        bool finished{false};
+        bool fromCache{false};
+        double startTime{};
+    };
+
+    bool loadBinary(Program &program) const;
+    void storeBinary(const Program &program) const;
+    void finish(Program &program);
+
+    std::vector<Program> programs_;
+    std::string dir_;
+    std::string driver_;
+    bool binary_supported_{false};
+    bool parallel_{false};
+};
+
+#endif //SHADER_MANAGER_H
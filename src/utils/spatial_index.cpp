@@ -0,0 +1,563 @@
+#include "spatial_index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+namespace {
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+
+    float dot3(const float *a, const float *b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+    float pointDistance(const float *p, const float *q) {
+        float dx = p[0] - q[0], dy = p[1] - q[1], dz = p[2] - q[2];
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    template<typename BoxT>
+    float boxDistance(const BoxT &box, const float *p) {
+        float d2 = 0.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            float d = std::max({box.min[axis] - p[axis], p[axis] - box.max[axis], 0.0f});
+            d2 += d * d;
+        }
+        return std::sqrt(d2);
+    }
+
+    float segmentDistance(const float *p, const float *a, const float *b) {
+        float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float ap[3] = {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+        float len2 = dot3(ab, ab);
+        float t = len2 > 0.0f ? std::clamp(dot3(ap, ab) / len2, 0.0f, 1.0f) : 0.0f;
+        float q[3] = {a[0] + ab[0] * t, a[1] + ab[1] * t, a[2] + ab[2] * t};
+        return pointDistance(p, q);
+    }
+
+    // 两线段的最近距离(Ericson, Real-Time Collision Detection 5.1.9)
+    float segmentSegmentDistance(const float *p1, const float *q1, const float *p2, const float *q2) {
+        float d1[3] = {q1[0] - p1[0], q1[1] - p1[1], q1[2] - p1[2]};
+        float d2[3] = {q2[0] - p2[0], q2[1] - p2[1], q2[2] - p2[2]};
+        float r[3] = {p1[0] - p2[0], p1[1] - p2[1], p1[2] - p2[2]};
+        float a = dot3(d1, d1), e = dot3(d2, d2), f = dot3(d2, r);
+        float s = 0.0f, t = 0.0f;
+        if (a <= 1e-12f && e <= 1e-12f) {
+            return pointDistance(p1, p2);
+        }
+        if (a <= 1e-12f) {
+            t = std::clamp(f / e, 0.0f, 1.0f);
+        } else {
+            float c = dot3(d1, r);
+            if (e <= 1e-12f) {
+                s = std::clamp(-c / a, 0.0f, 1.0f);
+            } else {
+                float b = dot3(d1, d2);
+                float denom = a * e - b * b;
+                s = denom > 1e-12f ? std::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+                t = (b * s + f) / e;
+                if (t < 0.0f) {
+                    t = 0.0f;
+                    s = std::clamp(-c / a, 0.0f, 1.0f);
+                } else if (t > 1.0f) {
+                    t = 1.0f;
+                    s = std::clamp((b - c) / a, 0.0f, 1.0f);
+                }
+            }
+        }
+        float c1[3] = {p1[0] + d1[0] * s, p1[1] + d1[1] * s, p1[2] + d1[2] * s};
+        float c2[3] = {p2[0] + d2[0] * t, p2[1] + d2[1] * t, p2[2] + d2[2] * t};
+        return pointDistance(c1, c2);
+    }
+
+    float segmentDistance2D(float x, float y, const float *a, const float *b) {
+        float abx = b[0] - a[0], aby = b[1] - a[1];
+        float len2 = abx * abx + aby * aby;
+        float t = len2 > 0.0f ? std::clamp(((x - a[0]) * abx + (y - a[1]) * aby) / len2, 0.0f, 1.0f) : 0.0f;
+        float dx = x - (a[0] + abx * t), dy = y - (a[1] + aby * t);
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    bool insidePolygon2D(const float *points, uint32_t count, float x, float y) {
+        bool inside = false;
+        for (uint32_t i = 0, j = count - 1; i < count; j = i++) {
+            const float *a = points + i * 3, *b = points + j * 3;
+            if ((a[1] > y) != (b[1] > y) && x < (b[0] - a[0]) * (y - a[1]) / (b[1] - a[1]) + a[0]) {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    float edgeDistance2D(const float *points, uint32_t count, float x, float y) {
+        float best = kInf;
+        for (uint32_t i = 0, j = count - 1; i < count; j = i++) {
+            best = std::min(best, segmentDistance2D(x, y, points + j * 3, points + i * 3));
+        }
+        return best;
+    }
+
+    // 射线(t >= 0, dir为单位向量)与线段的最近距离, t为最近点的射线参数. 凸二次问题, 交替投影几次即收敛
+    float raySegmentDistance(const float *o, const float *dir, const float *a, const float *b, float &t) {
+        float v[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float len2 = dot3(v, v);
+        float s = 0.0f;
+        t = 0.0f;
+        for (int iteration = 0; iteration < 4; ++iteration) {
+            float q[3] = {a[0] + v[0] * s - o[0], a[1] + v[1] * s - o[1], a[2] + v[2] * s - o[2]};
+            t = std::max(0.0f, dot3(q, dir));
+            if (len2 <= 0.0f) {
+                break;
+            }
+            float r[3] = {o[0] + dir[0] * t - a[0], o[1] + dir[1] * t - a[1], o[2] + dir[2] * t - a[2]};
+            s = std::clamp(dot3(r, v) / len2, 0.0f, 1.0f);
+        }
+        float p[3] = {o[0] + dir[0] * t, o[1] + dir[1] * t, o[2] + dir[2] * t};
+        float q[3] = {a[0] + v[0] * s, a[1] + v[1] * s, a[2] + v[2] * s};
+        return pointDistance(p, q);
+    }
+}
+
+void SpatialIndex::add(uint32_t layer, uint32_t group, uint32_t id, Shape shape, const float *points,
+                       size_t pointCount, float height) {
+    if (pointCount == 0) {
+        return;
+    }
+    Item item{};
+    item.layer = layer;
+    item.group = group;
+    item.id = id;
+    item.first = static_cast<uint32_t>(points_.size() / 3);
+    item.count = static_cast<uint32_t>(pointCount);
+    item.height = shape == POLYGON ? height : 0.0f;
+    item.shape = pointCount < 3 && shape == POLYGON ? POLYLINE : shape;
+    std::fill_n(item.box.min, 3, kInf);
+    std::fill_n(item.box.max, 3, -kInf);
+    for (size_t i = 0; i < pointCount; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            item.box.min[axis] = std::min(item.box.min[axis], points[i * 3 + axis]);
+            item.box.max[axis] = std::max(item.box.max[axis], points[i * 3 + axis]);
+        }
+    }
+    item.box.max[2] += item.height;
+    points_.insert(points_.end(), points, points + pointCount * 3);
+    items_.push_back(item);
+}
+
+void SpatialIndex::build() {
+    nodes_.clear();
+    if (items_.empty()) {
+        return;
+    }
+    // STR: 按中心x分成ceil(sqrt(P))个竖条, 条内按中心y排序后每kNodeCapacity个打包为一个节点
+    auto strOrder = [](const std::vector<Box> &boxes) {
+        size_t n = boxes.size();
+        size_t pages = (n + kNodeCapacity - 1) / kNodeCapacity;
+        size_t slices = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(pages))));
+        size_t slice = slices * kNodeCapacity;
+        std::vector<uint32_t> order(n);
+        std::iota(order.begin(), order.end(), 0u);
+        auto center = [&](uint32_t i, int axis) { return boxes[i].min[axis] + boxes[i].max[axis]; };
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return center(a, 0) < center(b, 0); });
+        for (size_t begin = 0; begin < n; begin += slice) {
+            auto end = order.begin() + static_cast<std::ptrdiff_t>(std::min(n, begin + slice));
+            std::sort(order.begin() + static_cast<std::ptrdiff_t>(begin), end,
+                      [&](uint32_t a, uint32_t b) { return center(a, 1) < center(b, 1); });
+        }
+        return order;
+    };
+    auto merge = [](Box &box, const Box &other) {
+        for (int axis = 0; axis < 3; ++axis) {
+            box.min[axis] = std::min(box.min[axis], other.min[axis]);
+            box.max[axis] = std::max(box.max[axis], other.max[axis]);
+        }
+    };
+
+    std::vector<Box> boxes;
+    boxes.reserve(items_.size());
+    for (const auto &item : items_) {
+        boxes.push_back(item.box);
+    }
+    auto order = strOrder(boxes);
+    std::vector<Item> sorted;
+    sorted.reserve(items_.size());
+    for (auto i : order) {
+        sorted.push_back(items_[i]);
+    }
+    items_ = std::move(sorted);
+
+    for (size_t i = 0; i < items_.size(); i += kNodeCapacity) {
+        Node node{items_[i].box, 0, static_cast<uint32_t>(i),
+                  static_cast<uint32_t>(std::min(kNodeCapacity, items_.size() - i)), true};
+        for (uint32_t j = node.first; j < node.first + node.count; ++j) {
+            merge(node.box, items_[j].box);
+            node.layers |= layerMask(items_[j].layer);
+        }
+        nodes_.push_back(node);
+    }
+
+    // 逐层向上打包, 同一层的节点先按STR顺序重排, 使每个父节点的子节点连续
+    size_t begin = 0, end = nodes_.size();
+    while (end - begin > 1) {
+        boxes.clear();
+        for (size_t i = begin; i < end; ++i) {
+            boxes.push_back(nodes_[i].box);
+        }
+        order = strOrder(boxes);
+        std::vector<Node> level;
+        level.reserve(order.size());
+        for (auto i : order) {
+            level.push_back(nodes_[begin + i]);
+        }
+        std::copy(level.begin(), level.end(), nodes_.begin() + static_cast<std::ptrdiff_t>(begin));
+
+        for (size_t i = begin; i < end; i += kNodeCapacity) {
+            Node node{nodes_[i].box, 0, static_cast<uint32_t>(i),
+                      static_cast<uint32_t>(std::min(kNodeCapacity, end - i)), false};
+            for (uint32_t j = node.first; j < node.first + node.count; ++j) {
+                merge(node.box, nodes_[j].box);
+                node.layers |= nodes_[j].layers;
+            }
+            nodes_.push_back(node);
+        }
+        begin = end;
+        end = nodes_.size();
+    }
+}
+
+void SpatialIndex::clear() {
+    items_.clear();
+    points_.clear();
+    nodes_.clear();
+}
+
+size_t SpatialIndex::byteSize() const {
+    return items_.capacity() * sizeof(Item) + points_.capacity() * sizeof(float) + nodes_.capacity() * sizeof(Node);
+}
+
+float SpatialIndex::distance(const Item &item, const float *p) const {
+    const float *points = points_.data() + item.first * 3;
+    float best = kInf;
+    if (item.shape == POINTS || item.count == 1) {
+        for (uint32_t i = 0; i < item.count; ++i) {
+            best = std::min(best, pointDistance(p, points + i * 3));
+        }
+    } else if (item.shape == POLYLINE) {
+        for (uint32_t i = 0; i + 1 < item.count; ++i) {
+            best = std::min(best, segmentDistance(p, points + i * 3, points + i * 3 + 3));
+        }
+    } else {
+        float dxy = insidePolygon2D(points, item.count, p[0], p[1]) ? 0.0f : edgeDistance2D(points, item.count, p[0], p[1]);
+        float dz = std::max({item.box.min[2] - p[2], p[2] - item.box.max[2], 0.0f});
+        best = std::sqrt(dxy * dxy + dz * dz);
+    }
+    return best;
+}
+
+float SpatialIndex::planarDistance(const Item &item, const float *a, const float *b) const {
+    const float *points = points_.data() + item.first * 3;
+    float a2[3] = {a[0], a[1], 0.0f}, b2[3] = {b[0], b[1], 0.0f};
+    auto flat = [&](uint32_t i, float *q) {
+        q[0] = points[i * 3];
+        q[1] = points[i * 3 + 1];
+        q[2] = 0.0f;
+    };
+    float best = kInf;
+    float p[3], q[3];
+    if (item.shape == POINTS || item.count == 1) {
+        for (uint32_t i = 0; i < item.count; ++i) {
+            flat(i, p);
+            best = std::min(best, segmentDistance(p, a2, b2));
+        }
+        return best;
+    }
+    if (item.shape == POLYGON && (insidePolygon2D(points, item.count, a[0], a[1]) ||
+                                  insidePolygon2D(points, item.count, b[0], b[1]))) {
+        return 0.0f;
+    }
+    // 折线逐段, 多边形逐边(首尾闭合)
+    uint32_t edges = item.shape == POLYLINE ? item.count - 1 : item.count;
+    for (uint32_t i = 0; i < edges; ++i) {
+        flat(i, p);
+        flat((i + 1) % item.count, q);
+        best = std::min(best, segmentSegmentDistance(a2, b2, p, q));
+    }
+    return best;
+}
+
+float SpatialIndex::intersect(const Item &item, const float *origin, const float *dir, float tolerance) const {
+    const float *points = points_.data() + item.first * 3;
+    if (item.shape != POLYGON) {
+        float best = -1.0f;
+        float bestDistance = kInf;
+        auto consider = [&](float distance, float t) {
+            if (distance <= tolerance && distance < bestDistance) {
+                bestDistance = distance;
+                best = t;
+            }
+        };
+        if (item.shape == POINTS || item.count == 1) {
+            for (uint32_t i = 0; i < item.count; ++i) {
+                float t;
+                float d = raySegmentDistance(origin, dir, points + i * 3, points + i * 3, t);
+                consider(d, t);
+            }
+        } else {
+            for (uint32_t i = 0; i + 1 < item.count; ++i) {
+                float t;
+                float d = raySegmentDistance(origin, dir, points + i * 3, points + i * 3 + 3, t);
+                consider(d, t);
+            }
+        }
+        return best;
+    }
+
+    // 柱体: 候选的进入点为射线穿过上下底面所在平面和穿过各侧边的位置, 取最近的落在柱体内的一个
+    std::vector<float> candidates = {0.0f};
+    float zlo = item.box.min[2], zhi = item.box.max[2];
+    if (std::fabs(dir[2]) > 1e-9f) {
+        candidates.push_back((zlo - origin[2]) / dir[2]);
+        candidates.push_back((zhi - origin[2]) / dir[2]);
+    }
+    for (uint32_t i = 0, j = item.count - 1; i < item.count; j = i++) {
+        const float *a = points + j * 3, *b = points + i * 3;
+        float ex = b[0] - a[0], ey = b[1] - a[1];
+        float denom = dir[0] * ey - dir[1] * ex;
+        if (std::fabs(denom) < 1e-12f) {
+            continue;
+        }
+        float wx = a[0] - origin[0], wy = a[1] - origin[1];
+        float t = (wx * ey - wy * ex) / denom;
+        float s = (wx * dir[1] - wy * dir[0]) / denom;
+        if (s >= 0.0f && s <= 1.0f) {
+            candidates.push_back(t);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    constexpr float kEpsilon = 1e-3f;
+    for (float t : candidates) {
+        if (t < 0.0f) {
+            continue;
+        }
+        float p[3] = {origin[0] + dir[0] * t, origin[1] + dir[1] * t, origin[2] + dir[2] * t};
+        if (p[2] < zlo - kEpsilon || p[2] > zhi + kEpsilon) {
+            continue;
+        }
+        if (insidePolygon2D(points, item.count, p[0], p[1]) ||
+            edgeDistance2D(points, item.count, p[0], p[1]) <= kEpsilon) {
+            return t;
+        }
+    }
+    return -1.0f;
+}
+
+std::vector<SpatialHit> SpatialIndex::queryBox(const std::array<float, 3> &min, const std::array<float, 3> &max,
+                                               uint32_t layers) const {
+    std::vector<SpatialHit> hits;
+    if (nodes_.empty()) {
+        return hits;
+    }
+    auto overlaps = [&](const Box &box) {
+        for (int axis = 0; axis < 3; ++axis) {
+            if (box.max[axis] < min[axis] || box.min[axis] > max[axis]) {
+                return false;
+            }
+        }
+        return true;
+    };
+    std::vector<uint32_t> stack = {static_cast<uint32_t>(nodes_.size() - 1)};
+    while (!stack.empty()) {
+        const auto &node = nodes_[stack.back()];
+        stack.pop_back();
+        if (!(node.layers & layers) || !overlaps(node.box)) {
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (!node.leaf) {
+                stack.push_back(i);
+            } else if ((layerMask(items_[i].layer) & layers) && overlaps(items_[i].box)) {
+                hits.push_back({items_[i].layer, items_[i].group, items_[i].id, 0.0f});
+            }
+        }
+    }
+    return hits;
+}
+
+std::vector<SpatialHit> SpatialIndex::queryRadius(const std::array<float, 3> &center, float radius,
+                                                  uint32_t layers) const {
+    std::vector<SpatialHit> hits;
+    if (nodes_.empty()) {
+        return hits;
+    }
+    std::vector<uint32_t> stack = {static_cast<uint32_t>(nodes_.size() - 1)};
+    while (!stack.empty()) {
+        const auto &node = nodes_[stack.back()];
+        stack.pop_back();
+        if (!(node.layers & layers) || boxDistance(node.box, center.data()) > radius) {
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (!node.leaf) {
+                stack.push_back(i);
+                continue;
+            }
+            const auto &item = items_[i];
+            if (!(layerMask(item.layer) & layers) || boxDistance(item.box, center.data()) > radius) {
+                continue;
+            }
+            float d = distance(item, center.data());
+            if (d <= radius) {
+                hits.push_back({item.layer, item.group, item.id, d});
+            }
+        }
+    }
+    std::sort(hits.begin(), hits.end(), [](const SpatialHit &a, const SpatialHit &b) { return a.distance < b.distance; });
+    return hits;
+}
+
+std::vector<SpatialHit> SpatialIndex::queryCorridor(const float *polyline, size_t count, float radius, float height,
+                                                    uint32_t layers) const {
+    std::vector<SpatialHit> hits;
+    if (nodes_.empty() || count == 0) {
+        return hits;
+    }
+    // 逐段查询, 节点用线段包围盒水平外扩radius, 竖直外扩height做保守剪枝; 一个要素可能被多段命中, 保留最小距离
+    std::vector<float> best(items_.size(), kInf);
+    std::vector<uint32_t> found;
+    std::vector<uint32_t> stack;
+    for (size_t segment = 0; segment < std::max<size_t>(count - 1, 1); ++segment) {
+        const float *a = polyline + segment * 3, *b = count > 1 ? a + 3 : a;
+        float min[3], max[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            float margin = axis == 2 ? height : radius;
+            min[axis] = std::min(a[axis], b[axis]) - margin;
+            max[axis] = std::max(a[axis], b[axis]) + margin;
+        }
+        auto overlaps = [&](const Box &box) {
+            for (int axis = 0; axis < 3; ++axis) {
+                if (box.max[axis] < min[axis] || box.min[axis] > max[axis]) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        stack.assign(1, static_cast<uint32_t>(nodes_.size() - 1));
+        while (!stack.empty()) {
+            const auto &node = nodes_[stack.back()];
+            stack.pop_back();
+            if (!(node.layers & layers) || !overlaps(node.box)) {
+                continue;
+            }
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                if (!node.leaf) {
+                    stack.push_back(i);
+                    continue;
+                }
+                const auto &item = items_[i];
+                if (!(layerMask(item.layer) & layers) || !overlaps(item.box)) {
+                    continue;
+                }
+                float d = planarDistance(item, a, b);
+                if (d <= radius && d < best[i]) {
+                    if (best[i] == kInf) {
+                        found.push_back(i);
+                    }
+                    best[i] = d;
+                }
+            }
+        }
+    }
+    for (auto i : found) {
+        hits.push_back({items_[i].layer, items_[i].group, items_[i].id, best[i]});
+    }
+    std::sort(hits.begin(), hits.end(), [](const SpatialHit &a, const SpatialHit &b) { return a.distance < b.distance; });
+    return hits;
+}
+
+std::vector<SpatialHit> SpatialIndex::nearestK(const std::array<float, 3> &point, size_t k, uint32_t layers) const {
+    std::vector<SpatialHit> hits;
+    if (nodes_.empty() || k == 0) {
+        return hits;
+    }
+    // 按距离下界的最优优先搜索: 节点用包围盒距离, 要素用精确距离, 弹出的要素即为当前最近
+    struct Candidate {
+        float distance;
+        uint32_t index;
+        bool item;
+        bool operator>(const Candidate &other) const { return distance > other.distance; }
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> queue;
+    queue.push({0.0f, static_cast<uint32_t>(nodes_.size() - 1), false});
+    while (!queue.empty() && hits.size() < k) {
+        auto candidate = queue.top();
+        queue.pop();
+        if (candidate.item) {
+            const auto &item = items_[candidate.index];
+            hits.push_back({item.layer, item.group, item.id, candidate.distance});
+            continue;
+        }
+        const auto &node = nodes_[candidate.index];
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (node.leaf) {
+                if (layerMask(items_[i].layer) & layers) {
+                    queue.push({distance(items_[i], point.data()), i, true});
+                }
+            } else if (nodes_[i].layers & layers) {
+                queue.push({boxDistance(nodes_[i].box, point.data()), i, false});
+            }
+        }
+    }
+    return hits;
+}
+
+std::vector<SpatialHit> SpatialIndex::raycast(const std::array<float, 3> &origin, const std::array<float, 3> &direction,
+                                              float tolerance, uint32_t layers) const {
+    std::vector<SpatialHit> hits;
+    float length = std::sqrt(dot3(direction.data(), direction.data()));
+    if (nodes_.empty() || length <= 0.0f) {
+        return hits;
+    }
+    float dir[3] = {direction[0] / length, direction[1] / length, direction[2] / length};
+    auto crosses = [&](const Box &box) {
+        float tmin = 0.0f, tmax = kInf;
+        for (int axis = 0; axis < 3; ++axis) {
+            float lo = box.min[axis] - tolerance, hi = box.max[axis] + tolerance;
+            if (std::fabs(dir[axis]) < 1e-12f) {
+                if (origin[axis] < lo || origin[axis] > hi) {
+                    return false;
+                }
+                continue;
+            }
+            float t1 = (lo - origin[axis]) / dir[axis], t2 = (hi - origin[axis]) / dir[axis];
+            tmin = std::max(tmin, std::min(t1, t2));
+            tmax = std::min(tmax, std::max(t1, t2));
+            if (tmin > tmax) {
+                return false;
+            }
+        }
+        return true;
+    };
+    std::vector<uint32_t> stack = {static_cast<uint32_t>(nodes_.size() - 1)};
+    while (!stack.empty()) {
+        const auto &node = nodes_[stack.back()];
+        stack.pop_back();
+        if (!(node.layers & layers) || !crosses(node.box)) {
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (!node.leaf) {
+                stack.push_back(i);
+                continue;
+            }
+            const auto &item = items_[i];
+            if (!(layerMask(item.layer) & layers) || !crosses(item.box)) {
+                continue;
+            }
+            float t = intersect(item, origin.data(), dir, tolerance);
+            if (t >= 0.0f) {
+                hits.push_back({item.layer, item.group, item.id, t});
+            }
+        }
+    }
+    std::sort(hits.begin(), hits.end(), [](const SpatialHit &a, const SpatialHit &b) { return a.distance < b.distance; });
+    return hits;
+}
@@ -0,0 +1,97 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// layers参数按图层取位, 见layerMask()
+constexpr uint32_t kAllLayers = 0xFFFFFFFFu;
+
+constexpr uint32_t layerMask(uint32_t layer) { return 1u << layer; }
+
+struct SpatialHit {
+    uint32_t layer{};       // 图层, 含义由地图接口定义
+    uint32_t group{};       // 分组, HMI地图中为楼层在getFloorNames()中的下标, 导航地图为0
+    uint32_t id{};          // 要素id
+    float distance{};       // 到要素几何的距离; raycast中为沿射线的距离; queryBox中为0
+};
+
+// 静态要素的R树, 在ENU坐标下按STR(Sort-Tile-Recursive)批量构建, 不依赖GL上下文.
+// 距离按要素几何计算: 点集取最近点, 折线取最近线段, 多边形在水平投影内部时只计高度差(可向上拉伸height).
+// 构建后只读, 可多线程并发查询.
+class SpatialIndex {
+  public:
+    static constexpr size_t kNodeCapacity = 16;
+
+    enum Shape : uint8_t {
+        POINTS,
+        POLYLINE,
+        POLYGON,    // 首尾自动闭合
+    };
+
+    // 逐个添加要素后调用build(); points为[x, y, z, ...], layer须小于32
+    void add(uint32_t layer, uint32_t group, uint32_t id, Shape shape, const float *points, size_t pointCount,
+             float height = 0.0f);
+    void build();
+    void clear();
+
+    // 包围盒与[min, max]相交的要素, 不做精确几何判断
+    [[nodiscard]] std::vector<SpatialHit> queryBox(const std::array<float, 3> &min, const std::array<float, 3> &max,
+                                                   uint32_t layers = kAllLayers) const;
+    // 到几何距离不超过radius的要素, 按距离升序
+    [[nodiscard]] std::vector<SpatialHit> queryRadius(const std::array<float, 3> &center, float radius,
+                                                      uint32_t layers = kAllLayers) const;
+    // 与折线polyline(count个点)的缓冲走廊相交的要素, 按水平距离升序: 水平投影到折线的距离不超过radius,
+    // 且包围盒的高度范围与所在线段的高度范围外扩height后重叠(避免选中其他楼层)
+    [[nodiscard]] std::vector<SpatialHit> queryCorridor(const float *polyline, size_t count, float radius,
+                                                        float height, uint32_t layers = kAllLayers) const;
+    // 最近的k个要素, 按距离升序
+    [[nodiscard]] std::vector<SpatialHit> nearestK(const std::array<float, 3> &point, size_t k,
+                                                   uint32_t layers = kAllLayers) const;
+    // 与射线相交的要素, 按沿射线距离升序. 点和折线在tolerance范围内视为相交, 多边形按拉伸后的柱体求交
+    [[nodiscard]] std::vector<SpatialHit> raycast(const std::array<float, 3> &origin,
+                                                  const std::array<float, 3> &direction, float tolerance = 0.2f,
+                                                  uint32_t layers = kAllLayers) const;
+
+    [[nodiscard]] size_t size() const { return items_.size(); }
+    [[nodiscard]] size_t byteSize() const;
+
+  private:
+    struct Box {
+        float min[3];
+        float max[3];
+    };
+
+    struct Item {
+        Box box;
+        uint32_t layer;
+        uint32_t group;
+        uint32_t id;
+        uint32_t first;         // points_中的起始点
+        uint32_t count;
+        float height;
+        Shape shape;
+    };
+
+    struct Node {
+        Box box;
+        uint32_t layers;        // 子树中出现的图层, 用于按layers剪枝
+        uint32_t first;         // 叶节点指向items_, 否则指向nodes_中连续的子节点
+        uint32_t count;
+        bool leaf;
+    };
+
+    [[nodiscard]] float distance(const Item &item, const float *p) const;
+    // 水平投影到线段ab的距离
+    [[nodiscard]] float planarDistance(const Item &item, const float *a, const float *b) const;
+    // 不相交时返回负数
+    [[nodiscard]] float intersect(const Item &item, const float *origin, const float *dir, float tolerance) const;
+
+    std::vector<Item> items_;
+    std::vector<float> points_;
+    std::vector<Node> nodes_;   // 根节点在最后
+};
+
+#endif //SPATIAL_INDEX_H
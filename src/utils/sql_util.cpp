@@ -34,7 +34,7 @@ std::string query_for_column(const std::string &db_path, int partition_id, const
     return render_data;
 }
 
-hdmap::data::proto::RoadTile query_for_road_tile(const std::string &db_path, int partition_id, const std::string &col) {
+std::string query_for_blob(const std::string &db_path, int partition_id) {
     sqlite3 *db;
     sqlite3_stmt *stmt;
     int rc;
@@ -56,26 +56,93 @@ hdmap::data::proto::RoadTile query_for_road_tile(const std::string &db_path, int
     }
     sqlite3_bind_int(stmt, 1, partition_id);
 
-    hdmap::data::proto::RoadTile road_tile;
+    std::string blob_data;
     if ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         int bytes = sqlite3_column_bytes(stmt, 0);
         const void *blob = sqlite3_column_blob(stmt, 0);
-
-        // 直接使用从数据库中获取的BLOB数据来反序列化proto对象
-        if (!road_tile.ParseFromArray(blob, bytes)) {
-            throw std::runtime_error("Failed to parse the BLOB data into a proto object.");
-        }
-    } else if (rc == SQLITE_DONE) {
-        throw std::runtime_error("No data found for partition_id");
+        blob_data.assign(static_cast<const char *>(blob), bytes);
     } else {
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        if (rc == SQLITE_DONE) {
+            throw std::runtime_error("No data found for partition_id");
+        }
         throw std::runtime_error("Failed to retrieve data");
     }
     sqlite3_finalize(stmt);
     sqlite3_close(db);
 
+    return blob_data;
+}
+
+void update_blob(const std::string &db_path, int partition_id, const std::string &blob_data) {
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    int rc;
+
+    rc = sqlite3_open(db_path.c_str(), &db);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Can't open database: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        throw std::runtime_error("Can't open database");
+    }
+
+    const char *sql_query = "UPDATE LPNP_table SET blob_data=? WHERE partition_id=?";
+    rc = sqlite3_prepare_v2(db, sql_query, -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        throw std::runtime_error("Failed to execute statement");
+    }
+    sqlite3_bind_blob(stmt, 1, blob_data.data(), static_cast<int>(blob_data.size()), SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, partition_id);
+
+    rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    if (rc != SQLITE_DONE) {
+        throw std::runtime_error("Failed to update blob_data");
+    }
+}
+
+hdmap::data::proto::RoadTile query_for_road_tile(const std::string &db_path, int partition_id, const std::string &col) {
+    auto blob_data = query_for_blob(db_path, partition_id);
+
+    hdmap::data::proto::RoadTile road_tile;
+    // 直接使用从数据库中获取的BLOB数据来反序列化proto对象
+    if (!road_tile.ParseFromString(blob_data)) {
+        throw std::runtime_error("Failed to parse the BLOB data into a proto object.");
+    }
     return road_tile;
 }
 
+std::vector<int> query_partition_ids(const std::string &db_path) {
+    std::vector<int> partition_ids;
+    sqlite3 *db;
+    if (sqlite3_open(db_path.c_str(), &db)) {
+        std::cerr << "Can't open database: " << std::endl;
+        return partition_ids;
+    }
+
+    char *err_msg = nullptr;
+    auto ret = sqlite3_exec(db, "SELECT partition_id FROM LPNP_table ORDER BY partition_id;",
+                            [](void *data, int argc, char **argv, char **azColName) -> int {
+        auto *ids = static_cast<std::vector<int> *>(data);
+        if (argc > 0 && argv[0]) {
+            ids->push_back(std::stoi(argv[0]));
+        }
+        return 0;
+    }, &partition_ids, &err_msg);
+
+    if (ret != SQLITE_OK) {
+        std::cerr << "SQL error: " << err_msg << std::endl;
+        sqlite3_free(err_msg);
+    }
+
+    sqlite3_close(db);
+    return partition_ids;
+}
+
 std::array<double, 3> getPoint(const std::string &str) {
     std::stringstream ss(str);
     std::string token;
@@ -3,10 +3,15 @@
 
 #include <string>
 #include <array>
+#include <vector>
 #include "road_tile.pb.h"
 
 std::string query_for_column(const std::string &db_path, int partition_id, const std::string &col);
+// 分区blob_data原始字节, 用于计算缓存键和延迟解析
+std::string query_for_blob(const std::string &db_path, int partition_id);
+void update_blob(const std::string &db_path, int partition_id, const std::string &blob_data);
 hdmap::data::proto::RoadTile query_for_road_tile(const std::string &db_path, int partition_id, const std::string &col);
+std::vector<int> query_partition_ids(const std::string &db_path);
 std::array<double, 3> getPoint(const std::string &str);
 std::array<int, 3> getTargetPrkId(const std::string &str);
 #endif //SQL_UTIL_H
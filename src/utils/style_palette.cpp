@@ -0,0 +1,75 @@
+#include "style_palette.h"
+
+namespace {
+    // 与navi_map::POI / RoadObstacle中的枚举值保持一致
+    constexpr uint8_t kPoiGarageEntrance = 5;
+    constexpr uint8_t kPoiCheckPoint = 19;
+    constexpr uint8_t kPoiHill = 23;
+    constexpr uint8_t kObstaclePillar = 6;
+    constexpr uint8_t kObstacleWall = 7;
+
+    const glm::vec4 kWhite{1.0f, 1.0f, 1.0f, 1.0f};
+
+    glm::vec4 tint(const glm::vec4 &color, const glm::vec3 &target, float amount) {
+        return {glm::mix(glm::vec3(color.x, color.y, color.z), target, amount), color.w};
+    }
+}
+
+StylePalette StylePalette::create(Theme theme) {
+    StylePalette palette;
+    for (uint8_t i = 0; i < style::STYLE_COUNT; ++i) {
+        palette.set(i, kWhite);
+    }
+
+    palette.set(style::ROAD, {0.0f, 0.7f, 1.0f, 1.0f});
+    palette.set(style::SLOPE_ROAD, {0.0f, 0.0f, 1.0f, 1.0f});
+
+    palette.set(style::PSD_ENTRY, {0.8f, 0.8f, 0.8f, 1.0f});
+    palette.set(style::PSD_REAR, {0.3f, 0.3f, 0.3f, 1.0f});
+    palette.set(style::PSD_ENTRY, style::HIGHLIGHT, kWhite);
+    palette.set(style::PSD_REAR, style::HIGHLIGHT, {1.0f, 0.55f, 0.0f, 1.0f});
+
+    palette.set(style::PILLAR_BOTTOM, kWhite);
+    palette.set(style::PILLAR_TOP, {1.0f, 0.9f, 0.5f, 0.2f});
+
+    palette.set(style::PARKING_ROW, {0.55f, 0.55f, 0.55f, 1.0f});
+    palette.set(style::PILLAR_ROW, {1.0f, 0.9f, 0.5f, 0.6f});
+
+    palette.set(style::ROUTE, {1.0f, 0.2f, 0.7f, 1.0f});
+
+    palette.set(style::POI_BASE + kPoiGarageEntrance, {1.0f, 0.27f, 0.0f, 1.0f});
+    palette.set(style::POI_BASE + kPoiCheckPoint, {0.0f, 0.5f, 0.0f, 1.0f});
+    palette.set(style::POI_BASE + kPoiHill, {1.0f, 0.5f, 0.3f, 1.0f});
+
+    for (uint8_t i = style::ROAD_MARK_BASE; i < style::ROAD_OBSTACLE_BASE; ++i) {
+        palette.set(i, {1.0f, 0.83f, 0.01f, 1.0f});
+    }
+
+    palette.set(style::ROAD_OBSTACLE_BASE + kObstaclePillar, {1.0f, 0.56f, 0.0f, 1.0f});
+    palette.set(style::ROAD_OBSTACLE_BASE + kObstacleWall, {0.65f, 0.16f, 0.16f, 1.0f});
+
+    if (theme == Theme::NIGHT) {
+        // 夜间主题: 背景压暗, 常态要素降低亮度, 高亮状态保持不变
+        palette.background = {0.04f, 0.04f, 0.06f, 1.0f};
+        for (uint8_t i = 0; i < style::STYLE_COUNT; ++i) {
+            auto &color = palette.colors_[i];
+            color = {color.x * 0.6f, color.y * 0.6f, color.z * 0.6f, color.w};
+        }
+    }
+    return palette;
+}
+
+void StylePalette::set(uint8_t style_id, const glm::vec4 &color) {
+    set(style_id, style::NORMAL, color);
+    set(style_id, style::HIGHLIGHT, tint(color, glm::vec3(1.0f), 0.5f));
+    set(style_id, style::OCCUPIED, tint(color, glm::vec3(0.6f, 0.1f, 0.1f), 0.6f));
+    set(style_id, style::SELECTED, tint(color, glm::vec3(0.2f, 1.0f, 0.4f), 0.6f));
+}
+
+void StylePalette::set(uint8_t style_id, uint8_t state, const glm::vec4 &color) {
+    colors_[state * style::STYLE_COUNT + style_id] = color;
+}
+
+const glm::vec4 &StylePalette::get(uint8_t style_id, uint8_t state) const {
+    return colors_[state * style::STYLE_COUNT + style_id];
+}
@@ -0,0 +1,71 @@
+#ifndef STYLE_PALETTE_H
+#define STYLE_PALETTE_H
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// 顶点只携带16位样式键: 低8位为样式id, 高8位为要素状态, 颜色由shader查Palette得到
+namespace style {
+    enum StyleId : uint8_t {
+        DEFAULT = 0,
+        ROAD = 1,
+        SLOPE_ROAD = 2,
+        PSD_ENTRY = 3,          // 车位入口边
+        PSD_REAR = 4,           // 车位底边
+        PILLAR_BOTTOM = 5,
+        PILLAR_TOP = 6,
+        ROUTE = 7,              // 规划路线
+        PARKING_ROW = 8,        // 远处合并的一排车位
+        PILLAR_ROW = 9,         // 远处合并的一排柱子
+
+        POI_BASE = 16,          // + POI::POIType
+        ROAD_MARK_BASE = 48,    // + RoadMark::RoadMarkType
+        ROAD_OBSTACLE_BASE = 64,// + RoadObstacle::RoadObstacleType
+        STYLE_COUNT = 80,
+    };
+
+    enum FeatureState : uint8_t {
+        NORMAL = 0,
+        HIGHLIGHT = 1,          // 目标车位等
+        OCCUPIED = 2,
+        SELECTED = 3,
+        STATE_COUNT = 4,
+    };
+
+    constexpr uint16_t key(uint8_t style_id, uint8_t state = NORMAL) {
+        return static_cast<uint16_t>(style_id | state << 8);
+    }
+
+    // base + type, 超出该基址的slots个样式(协议中新增或损坏的枚举值)时回退为DEFAULT
+    constexpr uint8_t typed(uint8_t base, int type, int slots) {
+        return type >= 0 && type < slots ? static_cast<uint8_t>(base + type) : DEFAULT;
+    }
+    constexpr int POI_SLOTS = ROAD_MARK_BASE - POI_BASE;
+    constexpr int ROAD_MARK_SLOTS = ROAD_OBSTACLE_BASE - ROAD_MARK_BASE;
+    constexpr int ROAD_OBSTACLE_SLOTS = STYLE_COUNT - ROAD_OBSTACLE_BASE;
+} // namespace style
+
+enum class Theme {
+    DAY, NIGHT
+};
+
+class StylePalette {
+  public:
+    static StylePalette create(Theme theme);
+
+    // 设置NORMAL颜色, 其余状态的颜色由其派生
+    void set(uint8_t style_id, const glm::vec4 &color);
+    void set(uint8_t style_id, uint8_t state, const glm::vec4 &color);
+    [[nodiscard]] const glm::vec4 &get(uint8_t style_id, uint8_t state = style::NORMAL) const;
+
+    [[nodiscard]] const glm::vec4 *data() const { return colors_.data(); }
+    [[nodiscard]] size_t byteSize() const { return colors_.size() * sizeof(glm::vec4); }
+
+    glm::vec4 background{0.2f, 0.2f, 0.2f, 1.0f};
+
+  private:
+    std::array<glm::vec4, style::STYLE_COUNT * style::STATE_COUNT> colors_{};
+};
+
+#endif //STYLE_PALETTE_H
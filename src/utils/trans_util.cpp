@@ -1,6 +1,9 @@
 #include "trans_util.h"
 #include <cmath>
 #include <iostream>
+#include <algorithm>
+#include <utility>
+#include <limits>
 
 const double a = 6378137.0;              // WGS-84椭球体的长半轴（米）
 const double inv_f = 298.257223563;      // WGS-84椭球体的扁率倒数
@@ -103,23 +106,187 @@ TransUtil::TransUtil(double ref_lon, double ref_lat, double ref_alt) : ref_lon(r
     double ref_E, ref_N, ref_U;
     ecefToENU(ref_lat, ref_lon, 0, 0, 0, ref_E, ref_N, ref_U);
     std::cout << "(E,N,U)=" << ref_E << "," << ref_N << "," << ref_U << std::endl;
+
+    sin_lat_ref = sin(ref_lat * M_PI / 180.0);
+    cos_lat_ref = cos(ref_lat * M_PI / 180.0);
+    sin_lon_ref = sin(ref_lon * M_PI / 180.0);
+    cos_lon_ref = cos(ref_lon * M_PI / 180.0);
 }
 
 std::array<double, 3> TransUtil::transToENU(double lon, double lat, double alt) const {
+    // 拟合范围外的点误差没有保证, 仍走精确计算
+    if (!fast_mode_ || std::fabs(lon - center_[0]) > half_[0] || std::fabs(lat - center_[1]) > half_[1] ||
+        std::fabs(alt - center_[2]) > half_[2]) {
+        return exactENU(lon, lat, alt);
+    }
+    double t[kTerms];
+    terms(lon, lat, alt, t);
+    // 每个分量分成两路累加, 缩短浮点加法的依赖链
+    std::array<double, 3> enu{};
+    for (int axis = 0; axis < 3; ++axis) {
+        const double *c = coeffs_[axis];
+        double even = 0.0, odd = 0.0;
+        for (int i = 0; i < term_count_; i += 2) {
+            even += c[i] * t[i];
+            odd += c[i + 1] * t[i + 1];
+        }
+        enu[axis] = even + odd;
+    }
+    return enu;
+}
+
+std::array<double, 3> TransUtil::exactENU(double lon, double lat, double alt) const {
     double x_tgt, y_tgt, z_tgt;
     llaToEcef(lat, lon, alt, x_tgt, y_tgt, z_tgt);
 
-    double ref_E, ref_N, ref_U;
-    ecefToENU(ref_lat, ref_lon, 0, 0, 0, ref_E, ref_N, ref_U);
-
     double delta_X = x_tgt - x_ref;
     double delta_Y = y_tgt - y_ref;
     double delta_Z = z_tgt - z_ref;
 
-    // 转换得到的局部平面坐标
-    double E, N, U;
+    // 与ecefToENU相同, 参考点的三角函数已在构造时算好
+    double E = -sin_lon_ref * delta_X + cos_lon_ref * delta_Y;
+    double N = -sin_lat_ref * cos_lon_ref * delta_X - sin_lat_ref * sin_lon_ref * delta_Y + cos_lat_ref * delta_Z;
+    double U = cos_lat_ref * cos_lon_ref * delta_X + cos_lat_ref * sin_lon_ref * delta_Y + sin_lat_ref * delta_Z;
+    return std::array<double, 3>{E, N, U};
+}
 
-    ecefToENU(ref_lat, ref_lon, delta_X, delta_Y, delta_Z, E, N, U);
-    return std::array<double, 3>{E - ref_E, N - ref_N, U - ref_U};
+void TransUtil::terms(double lon, double lat, double alt, double *out) const {
+    double x = (lon - center_[0]) * inv_half_[0];
+    double y = (lat - center_[1]) * inv_half_[1];
+    double z = (alt - center_[2]) * inv_half_[2];
+    double xx = x * x, yy = y * y, zz = z * z;
+    // 二次: 1, x, y, z, x^2, xy, xz, y^2, yz, z^2
+    out[0] = 1.0;
+    out[1] = x;
+    out[2] = y;
+    out[3] = z;
+    out[4] = xx;
+    out[5] = x * y;
+    out[6] = x * z;
+    out[7] = yy;
+    out[8] = y * z;
+    out[9] = zz;
+    if (term_count_ <= 10) {
+        return;
+    }
+    // 三次项
+    out[10] = xx * x;
+    out[11] = xx * y;
+    out[12] = xx * z;
+    out[13] = x * yy;
+    out[14] = x * y * z;
+    out[15] = x * zz;
+    out[16] = yy * y;
+    out[17] = yy * z;
+    out[18] = y * zz;
+    out[19] = zz * z;
 }
 
+double TransUtil::fit(int term_count) {
+    term_count_ = term_count;
+    const int n = term_count;
+
+    // 在范围内的规则网格上做最小二乘拟合
+    const int fit_n[3] = {9, 9, 4};
+    double ata[kTerms][kTerms] = {};
+    double atb[3][kTerms] = {};
+    double t[kTerms];
+    for (int i = 0; i < fit_n[0]; ++i) {
+        for (int j = 0; j < fit_n[1]; ++j) {
+            for (int k = 0; k < fit_n[2]; ++k) {
+                double lon = center_[0] + half_[0] * (2.0 * i / (fit_n[0] - 1) - 1.0);
+                double lat = center_[1] + half_[1] * (2.0 * j / (fit_n[1] - 1) - 1.0);
+                double alt = center_[2] + half_[2] * (2.0 * k / (fit_n[2] - 1) - 1.0);
+                auto enu = exactENU(lon, lat, alt);
+                terms(lon, lat, alt, t);
+                for (int r = 0; r < n; ++r) {
+                    for (int c = 0; c < n; ++c) {
+                        ata[r][c] += t[r] * t[c];
+                    }
+                    for (int axis = 0; axis < 3; ++axis) {
+                        atb[axis][r] += t[r] * enu[axis];
+                    }
+                }
+            }
+        }
+    }
+
+    // 高斯消元(列主元), 三个分量共用同一系数矩阵
+    for (int col = 0; col < n; ++col) {
+        int pivot = col;
+        for (int r = col + 1; r < n; ++r) {
+            if (std::fabs(ata[r][col]) > std::fabs(ata[pivot][col])) {
+                pivot = r;
+            }
+        }
+        if (std::fabs(ata[pivot][col]) < 1e-12) {
+            return std::numeric_limits<double>::infinity();
+        }
+        if (pivot != col) {
+            std::swap(ata[pivot], ata[col]);
+            for (auto &b : atb) {
+                std::swap(b[pivot], b[col]);
+            }
+        }
+        for (int r = col + 1; r < n; ++r) {
+            double factor = ata[r][col] / ata[col][col];
+            for (int c = col; c < n; ++c) {
+                ata[r][c] -= factor * ata[col][c];
+            }
+            for (auto &b : atb) {
+                b[r] -= factor * b[col];
+            }
+        }
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int r = n - 1; r >= 0; --r) {
+            double sum = atb[axis][r];
+            for (int c = r + 1; c < n; ++c) {
+                sum -= ata[r][c] * coeffs_[axis][c];
+            }
+            coeffs_[axis][r] = sum / ata[r][r];
+        }
+    }
+
+    // 用比拟合网格更密、包含边界和角点的网格检查误差
+    const int check_n[3] = {33, 33, 5};
+    double max_error = 0.0;
+    fast_mode_ = true;
+    for (int i = 0; i < check_n[0]; ++i) {
+        for (int j = 0; j < check_n[1]; ++j) {
+            for (int k = 0; k < check_n[2]; ++k) {
+                double lon = center_[0] + half_[0] * (2.0 * i / (check_n[0] - 1) - 1.0);
+                double lat = center_[1] + half_[1] * (2.0 * j / (check_n[1] - 1) - 1.0);
+                double alt = center_[2] + half_[2] * (2.0 * k / (check_n[2] - 1) - 1.0);
+                auto exact = exactENU(lon, lat, alt);
+                auto fast = transToENU(lon, lat, alt);
+                double dx = exact[0] - fast[0], dy = exact[1] - fast[1], dz = exact[2] - fast[2];
+                max_error = std::max(max_error, std::sqrt(dx * dx + dy * dy + dz * dz));
+            }
+        }
+    }
+    fast_mode_ = false;
+    return max_error;
+}
+
+bool TransUtil::enableFastMode(const std::array<double, 3> &min_lla, const std::array<double, 3> &max_lla,
+                               double tolerance) {
+    fast_mode_ = false;
+    // 退化范围(单点/平面)给一个最小半宽, 避免归一化时除零
+    const double min_half[3] = {1e-6, 1e-6, 1.0};
+    for (int i = 0; i < 3; ++i) {
+        center_[i] = 0.5 * (min_lla[i] + max_lla[i]);
+        half_[i] = std::max(0.5 * (max_lla[i] - min_lla[i]), min_half[i]);
+        inv_half_[i] = 1.0 / half_[i];
+    }
+
+    // 先试二次多项式, 不满足精度再用三次
+    for (int term_count : {10, kTerms}) {
+        fast_error_ = fit(term_count);
+        if (fast_error_ <= tolerance) {
+            fast_mode_ = true;
+            return true;
+        }
+    }
+    return false;
+}
@@ -13,9 +13,35 @@ class TransUtil {
     TransUtil(double ref_lon, double ref_lat, double ref_alt);
 
     [[nodiscard]] std::array<double, 3> transToENU(double lon, double lat, double alt) const;
+
+    // 在[min_lla, max_lla]范围内用关于(经度差, 纬度差, 高程差)的二次/三次多项式代替精确的LLA->ECEF->ENU.
+    // 启用时在范围内密集采样检查误差, 最大误差(米)超过tolerance时不启用, 仍走精确计算; 范围外的点始终精确计算.
+    bool enableFastMode(const std::array<double, 3> &min_lla, const std::array<double, 3> &max_lla,
+                        double tolerance = 1e-3);
+    void disableFastMode() { fast_mode_ = false; }
+    [[nodiscard]] bool fastMode() const { return fast_mode_; }
+    // 启用时为采样得到的最大误差(米)
+    [[nodiscard]] double fastModeError() const { return fast_error_; }
+
   private:
+    static constexpr int kTerms = 20;  // 三元三次多项式的项数, 二次时只用前10项
+
+    [[nodiscard]] std::array<double, 3> exactENU(double lon, double lat, double alt) const;
+    void terms(double lon, double lat, double alt, double *out) const;
+    // 按当前范围拟合前term_count项, 返回检查网格上的最大误差(米)
+    double fit(int term_count);
+
     double ref_lon, ref_lat, ref_alt;
     double x_ref, y_ref, z_ref;
+    double sin_lat_ref, cos_lat_ref, sin_lon_ref, cos_lon_ref;
+
+    bool fast_mode_{false};
+    int term_count_{kTerms};
+    double fast_error_{};
+    double center_[3]{};   // 拟合范围中心和半宽, 自变量归一化到[-1, 1]
+    double half_[3]{};
+    double inv_half_[3]{};
+    double coeffs_[3][kTerms]{};
 };
 
 #endif //TRANS_UTIL_H
@@ -0,0 +1,132 @@
+#include "triangulator.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <thread>
+
+namespace {
+    // 少于该数量的多边形不开线程, 线程的启动开销大于三角化本身
+    constexpr size_t kParallelThreshold = 256;
+    constexpr size_t kChunk = 64;
+
+    struct Point2 {
+        double x, y;
+    };
+
+    // (b - a) x (c - a), 逆时针为正
+    double cross(const Point2 &a, const Point2 &b, const Point2 &c) {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    // 含边界, 与顶点重合的点不算在内(重复点不应阻止切耳)
+    bool inTriangle(const Point2 &p, const Point2 &a, const Point2 &b, const Point2 &c) {
+        auto same = [&](const Point2 &q) { return q.x == p.x && q.y == p.y; };
+        if (same(a) || same(b) || same(c)) {
+            return false;
+        }
+        return cross(a, b, p) >= 0.0 && cross(b, c, p) >= 0.0 && cross(c, a, p) >= 0.0;
+    }
+}
+
+std::vector<uint32_t> triangulate_polygon(const std::vector<float> &points) {
+    std::vector<uint32_t> indices;
+    size_t n = points.size() / 3;
+    if (n > 1 && std::equal(points.begin(), points.begin() + 3, points.end() - 3)) {
+        --n;
+    }
+    if (n < 3) {
+        return indices;
+    }
+
+    // Newell法向, 投影到去掉其最大分量后的坐标平面
+    double normal[3] = {};
+    for (size_t i = 0; i < n; ++i) {
+        const float *p = points.data() + i * 3, *q = points.data() + (i + 1) % n * 3;
+        normal[0] += (static_cast<double>(p[1]) - q[1]) * (static_cast<double>(p[2]) + q[2]);
+        normal[1] += (static_cast<double>(p[2]) - q[2]) * (static_cast<double>(p[0]) + q[0]);
+        normal[2] += (static_cast<double>(p[0]) - q[0]) * (static_cast<double>(p[1]) + q[1]);
+    }
+    int drop = static_cast<int>(std::max_element(normal, normal + 3, [](double a, double b) {
+        return std::fabs(a) < std::fabs(b);
+    }) - normal);
+    int u = (drop + 1) % 3, v = (drop + 2) % 3;
+    std::vector<Point2> xy(n);
+    for (size_t i = 0; i < n; ++i) {
+        xy[i] = {points[i * 3 + u], points[i * 3 + v]};
+    }
+
+    std::vector<uint32_t> ring(n);
+    std::iota(ring.begin(), ring.end(), 0u);
+    // 统一为逆时针, 凸顶点的cross为正
+    if (normal[drop] < 0.0) {
+        std::reverse(ring.begin(), ring.end());
+    }
+
+    indices.reserve((n - 2) * 3);
+    while (ring.size() > 3) {
+        size_t m = ring.size();
+        bool clipped = false;
+        for (size_t i = 0; i < m && !clipped; ++i) {
+            uint32_t a = ring[(i + m - 1) % m], b = ring[i], c = ring[(i + 1) % m];
+            if (cross(xy[a], xy[b], xy[c]) <= 0.0) {
+                continue;
+            }
+            bool ear = true;
+            for (size_t k = 0; k < m && ear; ++k) {
+                uint32_t p = ring[k];
+                ear = p == a || p == b || p == c || !inTriangle(xy[p], xy[a], xy[b], xy[c]);
+            }
+            if (ear) {
+                indices.insert(indices.end(), {a, b, c});
+                ring.erase(ring.begin() + static_cast<std::ptrdiff_t>(i));
+                clipped = true;
+            }
+        }
+        // 没有耳朵时先去掉共线的顶点(不改变面积), 仍然没有说明多边形自交, 剩余部分按扇形补齐
+        for (size_t i = 0; i < m && !clipped; ++i) {
+            uint32_t a = ring[(i + m - 1) % m], b = ring[i], c = ring[(i + 1) % m];
+            if (cross(xy[a], xy[b], xy[c]) == 0.0) {
+                ring.erase(ring.begin() + static_cast<std::ptrdiff_t>(i));
+                clipped = true;
+            }
+        }
+        if (!clipped) {
+            break;
+        }
+    }
+    for (size_t i = 1; i + 1 < ring.size(); ++i) {
+        indices.insert(indices.end(), {ring[0], ring[i], ring[i + 1]});
+    }
+    return indices;
+}
+
+std::vector<std::vector<uint32_t>> triangulate_polygons(const std::vector<const std::vector<float> *> &polygons) {
+    std::vector<std::vector<uint32_t>> result(polygons.size());
+    size_t workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                      (polygons.size() + kChunk - 1) / kChunk);
+    if (polygons.size() < kParallelThreshold || workers <= 1) {
+        for (size_t i = 0; i < polygons.size(); ++i) {
+            result[i] = triangulate_polygon(*polygons[i]);
+        }
+        return result;
+    }
+    // 各线程按块领取, 结果写入各自的下标, 不需要加锁
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t begin = next.fetch_add(kChunk); begin < polygons.size(); begin = next.fetch_add(kChunk)) {
+            for (size_t i = begin; i < std::min(polygons.size(), begin + kChunk); ++i) {
+                result[i] = triangulate_polygon(*polygons[i]);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return result;
+}
@@ -0,0 +1,16 @@
+#ifndef TRIANGULATOR_H
+#define TRIANGULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 简单多边形(可凹, 不自交, 无洞)的耳切三角化. points为[x, y, z, ...], 首尾重合的闭合点会被忽略.
+// 在Newell法向最大分量所在的坐标平面上做二维耳切, 适用于近似水平或竖直的地图多边形.
+// 返回要素内的局部索引, 每3个一个三角形; 少于3个有效点时为空. 遇到自交等无法切耳的情况时, 剩余部分按扇形补齐
+std::vector<uint32_t> triangulate_polygon(const std::vector<float> &points);
+
+// 多线程批量三角化, 结果与polygons一一对应; 数量较少时在调用线程内完成
+std::vector<std::vector<uint32_t>> triangulate_polygons(const std::vector<const std::vector<float> *> &polygons);
+
+#endif //TRIANGULATOR_H
@@ -0,0 +1,39 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// 单生产者单消费者的无锁三缓冲: 生产者写back()后publish(), 消费者consume()后读front().
+// 双方各持有一个槽, 中间槽用一次原子交换传递, 互不等待; 消费者来不及读的旧数据直接被覆盖
+template <typename T>
+class TripleBuffer {
+  public:
+    // 生产者: 交换后back()是上次的中间槽, 内容已过期, 需要完整重写
+    T &back() { return slots_[back_]; }
+    void publish() {
+        back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // 消费者: 有新发布的数据时换到front()并返回true
+    bool consume() {
+        if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+    const T &front() const { return slots_[front_]; }
+
+  private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+
+    std::array<T, 3> slots_{};
+    uint8_t back_{0};
+    std::atomic<uint8_t> middle_{1};
+    uint8_t front_{2};
+};
+
+#endif //TRIPLE_BUFFER_H